@@ -0,0 +1,105 @@
+
+#include <stratcom.h>
+#include <stratcom_inline.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef STRATCOM_BENCHMARK_INLINE
+#   define BENCHMARK_CONFIGURATION         "inline"
+#   define BENCHMARK_IS_BUTTON_PRESSED     stratcom_is_button_pressed_inline
+#   define BENCHMARK_GET_AXIS_VALUE        stratcom_get_axis_value_inline
+#   define BENCHMARK_GET_SLIDER_STATE      stratcom_get_slider_state_inline
+#elif defined LIBSTRATCOM_STATIC
+#   define BENCHMARK_CONFIGURATION         "static"
+#else
+#   define BENCHMARK_CONFIGURATION         "shared"
+#endif
+#ifndef BENCHMARK_IS_BUTTON_PRESSED
+#   define BENCHMARK_IS_BUTTON_PRESSED     stratcom_is_button_pressed
+#   define BENCHMARK_GET_AXIS_VALUE        stratcom_get_axis_value
+#   define BENCHMARK_GET_SLIDER_STATE      stratcom_get_slider_state
+#endif
+
+/* Prevents the compiler from hoisting the state loads out of the benchmark loops,
+ * as the input state would usually change between queries in a real application.
+ */
+#if defined __GNUC__ || defined __clang__
+#   define BENCHMARK_CLOBBER_MEMORY() __asm__ __volatile__("" : : : "memory")
+#else
+#   define BENCHMARK_CLOBBER_MEMORY()
+#endif
+
+#define BENCHMARK_ITERATIONS 100000000L
+
+static void report(char const* name, clock_t start, clock_t end, long checksum)
+{
+    double const seconds = (double)(end - start) / CLOCKS_PER_SEC;
+    printf("%-8s %-28s %8.3f ns/query  (checksum %ld)\n", BENCHMARK_CONFIGURATION, name,
+           (seconds * 1e9) / BENCHMARK_ITERATIONS, checksum);
+}
+
+int main(void)
+{
+    stratcom_device* device;
+    clock_t start;
+    long i;
+    long checksum;
+    stratcom_button const buttons[] = {
+        STRATCOM_BUTTON_1, STRATCOM_BUTTON_2, STRATCOM_BUTTON_3, STRATCOM_BUTTON_4,
+        STRATCOM_BUTTON_5, STRATCOM_BUTTON_6, STRATCOM_BUTTON_PLUS, STRATCOM_BUTTON_MINUS
+    };
+    stratcom_axis const axes[] = { STRATCOM_AXIS_X, STRATCOM_AXIS_Y, STRATCOM_AXIS_Z, STRATCOM_AXIS_X };
+
+    stratcom_init();
+
+    if(!stratcom_inline_layout_matches()) {
+        printf("Library device layout does not match stratcom_inline.h.\n");
+        exit(1);
+    }
+
+    device = stratcom_open_device();
+    if(!device) {
+        /* the accessors do not touch the device, so a simulated one measures the same thing */
+        printf("Strategic Commander was not found. Using a simulated device.\n");
+        device = stratcom_open_simulated_device();
+        if(!device) {
+            printf("Error: Could not open a simulated device.\n");
+            exit(1);
+        }
+    }
+    if(stratcom_read_input_with_timeout(device, 100) == STRATCOM_RET_ERROR) {
+        printf("Error: Lost connection to the Strategic Commander.\n");
+        exit(1);
+    }
+
+    checksum = 0;
+    start = clock();
+    for(i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+        checksum += (BENCHMARK_IS_BUTTON_PRESSED(device, buttons[i & 7]) != 0);
+        BENCHMARK_CLOBBER_MEMORY();
+    }
+    report("stratcom_is_button_pressed", start, clock(), checksum);
+
+    checksum = 0;
+    start = clock();
+    for(i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+        checksum += BENCHMARK_GET_AXIS_VALUE(device, axes[i & 3]);
+        BENCHMARK_CLOBBER_MEMORY();
+    }
+    report("stratcom_get_axis_value", start, clock(), checksum);
+
+    checksum = 0;
+    start = clock();
+    for(i = 0; i < BENCHMARK_ITERATIONS; ++i) {
+        checksum += BENCHMARK_GET_SLIDER_STATE(device);
+        BENCHMARK_CLOBBER_MEMORY();
+    }
+    report("stratcom_get_slider_state", start, clock(), checksum);
+
+    stratcom_close_device(device);
+
+    stratcom_shutdown();
+    return 0;
+}
@@ -31,7 +31,7 @@
 #ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_H_
 #define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_H_
 
-#ifdef _WIN32
+#if defined _WIN32 && !defined LIBSTRATCOM_STATIC
 #   ifdef LIBSTRATCOM_EXPORT
 #       define LIBSTRATCOM_API __declspec(dllexport)
 #   else
@@ -41,6 +41,7 @@
 #   define LIBSTRATCOM_API
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -164,6 +165,12 @@ extern "C" {
         stratcom_slider_state slider;            /**< State of the slider. */
     } stratcom_input_state;
 
+    /** Timestamp.
+     * Point in time in microseconds, measured on a monotonic clock with an unspecified starting point.
+     * @see stratcom_get_timestamp()
+     */
+    typedef uint64_t stratcom_timestamp;
+
     /** @} */
 
 
@@ -206,9 +213,21 @@ extern "C" {
         STRATCOM_INPUT_EVENT_AXIS                /**< Axis event. @see stratcom_input_event_axis */
     } stratcom_input_event_type;
 
+    /** Input event flags.
+     * Combination of flags stored in @ref stratcom_input_event::flags.
+     */
+    typedef enum stratcom_input_event_flag_ {
+        STRATCOM_INPUT_EVENT_FLAG_RESYNC = 0x01, /**< The event is part of a resync after lost input reports.
+                                                      It reports the current state of a button, which
+                                                      may be unchanged. @see stratcom_set_resync_mode() */
+        STRATCOM_INPUT_EVENT_FLAG_SYNTHETIC = 0x02  /**< The event was played back from a macro and does not
+                                                         reflect the internal input state.
+                                                         @see stratcom_enable_macros() */
+    } stratcom_input_event_flag;
+
     /** Input event structure.
      * Input events form a linked list where each element contains one specific input event.
-     * @see stratcom_create_input_events_from_states(), stratcom_free_input_events()
+     * @see stratcom_create_input_events_from_states(), stratcom_read_input_events(), stratcom_free_input_events()
      */
     typedef struct stratcom_input_event_ {
         stratcom_input_event_type type;          /**< Type of the contained input event. */
@@ -222,6 +241,20 @@ extern "C" {
         } desc;                                  /**< Input event descriptor. */
         struct stratcom_input_event_* next;      /**< Pointer to the next element in the linked list structure.
                                                       For the last element in the list this is NULL. */
+        uint64_t sequence;                       /**< Sequence number of the input report that caused the event.
+                                                      @see stratcom_get_input_sequence()
+                                                      0 for events created by stratcom_create_input_events_from_states(). */
+        stratcom_timestamp timestamp;            /**< Arrival time of the input report that caused the event.
+                                                      0 for events created by stratcom_create_input_events_from_states(). */
+        uint32_t flags;                          /**< Combination of @ref stratcom_input_event_flag values. */
+        int32_t velocity;                        /**< For axis events, the estimated velocity of the axis in
+                                                      positions per second. 0 for all other events and if the
+                                                      velocity of the axis is not estimated.
+                                                      @see stratcom_set_axis_velocity_smoothing() */
+        uint32_t action;                         /**< For button events, the action of the button in the keymap
+                                                      of the device, as resolved when the button was pressed.
+                                                      0 for all other events, for synthetic events and if no
+                                                      action is mapped. @see stratcom_set_keymap() */
     } stratcom_input_event;
 
     /** @} */
@@ -262,6 +295,8 @@ extern "C" {
      *         NULL in case of error.
      * @note The Strategic Commander is identified as the first device with an HID Vendor Id of \c 0x045e and
      *       a Product Id of \c 0x0033.
+     * @note On Linux, the device is looked up directly through the hidraw interface first. If that fails,
+     *       the device is looked up through hidapi instead.
      * @note The internal state of the LEDs and LED blink intervals are set to match the state of the physical device.
      *       The input state however is left uninitialized and must be queried manually by calling one of the
      *       \c stratcom_read_input* functions.
@@ -270,6 +305,8 @@ extern "C" {
     LIBSTRATCOM_API stratcom_device* stratcom_open_device();
 
     /** Open a Strategic Commander device on a certain HID device path.
+     * On Linux, paths referring to a hidraw device node (\c /dev/hidraw*) are opened directly through the
+     * hidraw interface. All other paths, or paths that fail to open that way, are opened through hidapi.
      * @param[in] device_path The HID path of the device to open.
      * @return Pointer to a device struct on success, which can be freed by calling stratcom_close_device().
      *         NULL in case of error.
@@ -288,6 +325,126 @@ extern "C" {
 
     /** @} */
 
+    /** @name Device State Snapshots.
+     *
+     * Reopening a device after it was disconnected, for instance by a USB reset, normally involves reading the LED
+     * state and blink intervals from the device and then restoring the LEDs and all per-device configuration
+     * through further calls. Instead, the internal state of a device can be saved into a compact binary snapshot
+     * before, and be applied when opening the device again. This skips the initial reads and restores the LEDs
+     * with as few feature reports as possible: the LED state is sent in one report, while the blink intervals are
+     * only sent if an LED is blinking.
+     *
+     * A snapshot contains the internal LED state and blink intervals, the resync mode, the axis calibrations,
+     * the debounce windows and the axis velocity smoothing times. Macros, resampling, LED latency measurement and
+     * the input state are not part of a snapshot.
+     *
+     * \code{.c}
+        unsigned char state[STRATCOM_DEVICE_STATE_MAX_SIZE];
+        size_t const state_size = stratcom_save_device_state(device, state, sizeof(state));
+        stratcom_close_device(device);
+        ...
+        device = stratcom_open_device_with_state(NULL, state, state_size);
+     * \endcode
+     *
+     * @{
+     */
+
+    /** Maximum size of a device state snapshot in bytes.
+     */
+#define STRATCOM_DEVICE_STATE_MAX_SIZE 128
+
+    /** Save the internal state of a device to a snapshot.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[out] buffer Buffer receiving the snapshot.
+     * @param[in] buffer_size Size of buffer in bytes. A size of STRATCOM_DEVICE_STATE_MAX_SIZE is always enough.
+     * @return Size of the snapshot in bytes. 0 if the buffer is too small.
+     */
+    LIBSTRATCOM_API size_t stratcom_save_device_state(stratcom_device* device, void* buffer, size_t buffer_size);
+
+    /** Apply a snapshot to a device.
+     * The LED state is sent to the device in a single feature report.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] state A snapshot obtained from stratcom_save_device_state().
+     * @param[in] state_size Size of the snapshot in bytes.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the snapshot is invalid or could not be
+     *         applied. An invalid snapshot leaves the device unchanged, otherwise the device may be partially
+     *         restored in case of error.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_restore_device_state(stratcom_device* device,
+                                                                  void const* state, size_t state_size);
+
+    /** Open a Strategic Commander device and apply a snapshot to it.
+     * Unlike stratcom_open_device() and stratcom_open_device_on_path(), the LED state and blink intervals are not
+     * read from the device but taken from the snapshot.
+     * @param[in] device_path The HID path of the device to open, as for stratcom_open_device_on_path().
+     *                        Pass \c NULL to open the first device found, as stratcom_open_device() does.
+     * @param[in] state A snapshot obtained from stratcom_save_device_state().
+     * @param[in] state_size Size of the snapshot in bytes.
+     * @return Pointer to a device struct on success, which can be freed by calling stratcom_close_device().
+     *         NULL if the snapshot is invalid, the device could not be opened, or the snapshot could not be applied.
+     * @see stratcom_restore_device_state()
+     */
+    LIBSTRATCOM_API stratcom_device* stratcom_open_device_with_state(char const* device_path,
+                                                                     void const* state, size_t state_size);
+
+    /** @} */
+
+    /** @name Memory Allocation.
+     *
+     * By default, the library allocates memory with malloc() and free(). Applications with their own memory
+     * management can route all allocations made by the library through a custom allocator instead.
+     * Every block of memory records the allocator it was obtained from, so memory is always returned to the
+     * right allocator, even if the allocator was changed in the meantime.
+     *
+     * Once a device is open, reading input and querying the input state never allocates memory. Only functions
+     * that create objects, like input events, allocate memory. Allocations made internally by hidapi, the
+     * C library or the operating system are not covered by the allocator. Neither are the worker threads that
+     * stratcom_commit_led_transaction() starts for transactions spanning several devices, as the C++ standard
+     * library allocates their state itself.
+     *
+     * @{
+     */
+
+    /** Memory allocation function.
+     * @param[in] user_data The user data passed along with the allocator.
+     * @param[in] size Number of bytes to allocate.
+     * @return Memory suitably aligned for any fundamental type, like memory returned by malloc(),
+     *         or \c NULL on failure.
+     */
+    typedef void* (*stratcom_alloc_fn)(void* user_data, size_t size);
+
+    /** Memory deallocation function.
+     * @param[in] user_data The user data passed along with the allocator.
+     * @param[in] ptr Memory previously returned from the matching allocation function. Never \c NULL.
+     * @param[in] size The size that was passed to the allocation function for ptr.
+     */
+    typedef void (*stratcom_free_fn)(void* user_data, void* ptr, size_t size);
+
+    /** Set the global allocator.
+     * All objects that are not tied to a device, as well as devices themselves, are allocated through the
+     * global allocator. This function is not thread-safe and should be called before any other library
+     * function.
+     * @param[in] alloc_fn Allocation function. Pass \c NULL to restore the default allocator.
+     * @param[in] free_fn Deallocation function. Pass \c NULL to restore the default allocator.
+     * @param[in] user_data User data passed to the allocator functions.
+     */
+    LIBSTRATCOM_API void stratcom_set_allocator(stratcom_alloc_fn alloc_fn, stratcom_free_fn free_fn,
+                                                void* user_data);
+
+    /** Set the allocator of a device.
+     * All subsequent allocations on behalf of the device, like input events read from it or its resampling
+     * history, go through the device allocator. A newly opened device uses the global allocator.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] alloc_fn Allocation function. Pass \c NULL to use the current global allocator.
+     * @param[in] free_fn Deallocation function. Pass \c NULL to use the current global allocator.
+     * @param[in] user_data User data passed to the allocator functions.
+     * @see stratcom_set_allocator()
+     */
+    LIBSTRATCOM_API void stratcom_set_device_allocator(stratcom_device* device, stratcom_alloc_fn alloc_fn,
+                                                       stratcom_free_fn free_fn, void* user_data);
+
+    /** @} */
+
     /** @name Button LEDs.
      *
      * Use these functions to interact with the LEDs on the device.
@@ -349,6 +506,8 @@ extern "C" {
     /** Flush the current internal LED state to the physical device.
      * This will send a feature report to the device to update the state of the button LEDs.
      * In case of successful execution, all button LEDs will light up according to the internal state.
+     * If blink intervals restored by stratcom_restore_device_state() or stratcom_open_device_with_state() have
+     * not been sent to the device yet and an LED is set to blink, they are sent in an additional feature report.
      * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
      * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR on error.
      * @see stratcom_set_button_led_state_without_flushing(), stratcom_led_state_has_unflushed_changes()
@@ -359,7 +518,8 @@ extern "C" {
      * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
      * @return 1 if the internal state contains unflushed changes, 0 otherwise.
      * @note This function does not query the physical device for its state. It simply accounts for changes made
-     *       through stratcom_set_button_led_state_without_flushing() that have not been flushed.
+     *       through stratcom_set_button_led_state_without_flushing() and changes of the REC LED requested by
+     *       macro recording that have not been flushed. @see stratcom_enable_macros()
      * @see stratcom_set_button_led_state_without_flushing(), stratcom_flush_button_led_state()
      */
     LIBSTRATCOM_API int stratcom_led_state_has_unflushed_changes(stratcom_device* device);
@@ -375,6 +535,7 @@ extern "C" {
 
     /** Set the blink intervals for blinking LEDs.
      * This function will send a feature report to update the blink state on the physical device.
+     * Upon success, the internal state blink intervals are updated as well.
      * The blink intervals are the same for all buttons.
      * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
      * @param[in] on_time Time that the LED is lit when blinking.
@@ -411,6 +572,164 @@ extern "C" {
 
     /** @} */
 
+    /** @name LED Transactions.
+     *
+     * Each function that changes the physical LED state of a device blocks until the device has acknowledged
+     * the corresponding feature report. When updating several devices, LED transactions avoid paying that
+     * latency once per device: Changes are staged for any number of devices and then committed at once,
+     * sending the feature reports to all devices concurrently.
+     *
+     * All changes staged for the same device are collapsed, so that committing sends at most one LED state
+     * report and one blink interval report per device.
+     *
+     * \code{.c}
+        stratcom_led_transaction* transaction = stratcom_begin_led_transaction();
+        stratcom_led_transaction_set_button_led_state(transaction, device1, STRATCOM_LEDBUTTON_ALL, STRATCOM_LED_OFF);
+        stratcom_led_transaction_set_button_led_state(transaction, device2, STRATCOM_LEDBUTTON_1, STRATCOM_LED_ON);
+        stratcom_led_transaction_set_button_led_state(transaction, device2, STRATCOM_LEDBUTTON_2, STRATCOM_LED_BLINK);
+        if(stratcom_commit_led_transaction(transaction, NULL) != STRATCOM_RET_SUCCESS) {
+            ...
+        }
+        stratcom_free_led_transaction(transaction);
+     * \endcode
+     *
+     * @{
+     */
+
+    /** LED transaction.
+     * @see stratcom_begin_led_transaction()
+     */
+    typedef struct stratcom_led_transaction_ stratcom_led_transaction;
+
+    /** Result of committing an LED transaction to a single device.
+     */
+    typedef struct stratcom_led_transaction_result_ {
+        stratcom_device* device;                 /**< The device. */
+        stratcom_return result;                  /**< STRATCOM_RET_SUCCESS if all staged changes were applied to the
+                                                      physical device, STRATCOM_RET_ERROR otherwise. */
+    } stratcom_led_transaction_result;
+
+    /** Begin a new LED transaction.
+     * @return A new, empty LED transaction that must be freed by calling stratcom_free_led_transaction(),
+     *         or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_led_transaction* stratcom_begin_led_transaction();
+
+    /** Stage a change of the state of an LED.
+     * The change is not applied to the internal state before the transaction is committed.
+     * Later changes to the same LED of the same device override earlier ones.
+     * @param[in] transaction An LED transaction returned from stratcom_begin_led_transaction().
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] led The button LED which is to be changed.
+     * @param[in] state Requested new state of the LED.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the change could not be staged.
+     * @see stratcom_set_button_led_state_without_flushing()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_led_transaction_set_button_led_state(stratcom_led_transaction* transaction,
+                                                                                  stratcom_device* device,
+                                                                                  stratcom_button_led led,
+                                                                                  stratcom_led_state state);
+
+    /** Stage a change of the blink intervals.
+     * Later changes for the same device override earlier ones.
+     * @param[in] transaction An LED transaction returned from stratcom_begin_led_transaction().
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] on_time Time that the LED is lit when blinking.
+     * @param[in] off_time Time that the LED is dark when blinking.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the change could not be staged.
+     * @see stratcom_set_led_blink_interval()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_led_transaction_set_blink_interval(stratcom_led_transaction* transaction,
+                                                                                stratcom_device* device,
+                                                                                uint8_t on_time, uint8_t off_time);
+
+    /** Retrieve the number of devices with staged changes in an LED transaction.
+     * @param[in] transaction An LED transaction returned from stratcom_begin_led_transaction().
+     */
+    LIBSTRATCOM_API uint32_t stratcom_led_transaction_get_device_count(stratcom_led_transaction* transaction);
+
+    /** Commit all staged changes.
+     * Applies the staged changes to the internal state of each device and sends the resulting feature reports
+     * to all devices concurrently. Returns once all devices have acknowledged their reports or failed.
+     * Other functions must not access any of the devices in the transaction while the commit is in progress.
+     * Committing leaves the staged changes in place, so a failed transaction can be retried.
+     * @param[in] transaction An LED transaction returned from stratcom_begin_led_transaction().
+     * @param[out] out_results Receives the result for each device, in the order in which the devices were first
+     *                         staged. Must have room for stratcom_led_transaction_get_device_count() entries.
+     *                         May be \c NULL.
+     * @return STRATCOM_RET_SUCCESS if the changes were applied to all devices, STRATCOM_RET_ERROR otherwise.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_commit_led_transaction(stratcom_led_transaction* transaction,
+                                                                    stratcom_led_transaction_result* out_results);
+
+    /** Free an LED transaction.
+     * Changes that were not committed are discarded.
+     * @param[in] transaction An LED transaction returned from stratcom_begin_led_transaction().
+     */
+    LIBSTRATCOM_API void stratcom_free_led_transaction(stratcom_led_transaction* transaction);
+
+    /** @} */
+
+    /** @name LED Latency Measurement.
+     *
+     * Applications commonly light the LED of a button as feedback for pressing it. The responsiveness perceived
+     * by the user is the time from the arrival of the input report containing the press until the device has
+     * acknowledged the feature report that changes the LED. When latency measurement is enabled for a device,
+     * the library measures this time and collects it in a histogram.
+     *
+     * A press is matched by the first successful call to stratcom_flush_button_led_state() afterwards that changes the
+     * state of the LED of the pressed button, including flushes by stratcom_commit_led_transaction(). Pressing the same
+     * button again before a match replaces the earlier press. A press that is not matched within one second is dropped.
+     * Buttons without an LED are not measured, and neither are the changes of the REC LED made for macro recording. As
+     * both ends are timed with stratcom_get_timestamp() around the actual I/O, this works the same with all backends.
+     *
+     * @{
+     */
+
+    /** Number of buckets in a stratcom_latency_histogram.
+     */
+#define STRATCOM_LATENCY_HISTOGRAM_BUCKETS 32
+
+    /** Latency histogram.
+     * All times are in microseconds.
+     */
+    typedef struct stratcom_latency_histogram_ {
+        uint64_t count;                          /**< Number of measurements. */
+        uint64_t sum;                            /**< Sum of all measurements. */
+        uint64_t min;                            /**< Smallest measurement. 0 if count is 0. */
+        uint64_t max;                            /**< Largest measurement. */
+        uint64_t buckets[STRATCOM_LATENCY_HISTOGRAM_BUCKETS];   /**< Bucket 0 counts measurements below 2,
+                                                                     bucket i counts measurements in
+                                                                     [2^i, 2^(i+1)). The last bucket also
+                                                                     counts everything above. */
+    } stratcom_latency_histogram;
+
+    /** Enable or disable LED latency measurement for a device.
+     * Enabling the measurement clears the histogram. This function must not be called while another thread
+     * is reading from the device or flushing its LED state.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] enabled 1 to enable measurement, 0 to disable it.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the measurement could not be enabled.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_enable_led_latency_measurement(stratcom_device* device, int enabled);
+
+    /** Retrieve the LED latency histogram of a device.
+     * This function may be called concurrently with reading from the device and flushing its LED state.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[out] out_histogram Receives the histogram.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if measurement is not enabled for the device.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_get_led_latency_histogram(stratcom_device* device,
+                                                                       stratcom_latency_histogram* out_histogram);
+
+    /** Clear the LED latency histogram of a device.
+     * Presses that are waiting for a match are kept.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     */
+    LIBSTRATCOM_API void stratcom_reset_led_latency_histogram(stratcom_device* device);
+
+    /** @} */
+
     /** @name Device Input.
      *
      * Use these functions to obtain the input state of the device, such as which buttons are currently pressed.
@@ -462,6 +781,17 @@ extern "C" {
      */
     LIBSTRATCOM_API stratcom_return stratcom_read_input_non_blocking(stratcom_device* device);
 
+    /** Retrieve a file descriptor for waiting on input with poll(), select() or similar.
+     * The file descriptor becomes readable when input reports are available. Once it is readable, call
+     * stratcom_read_input_non_blocking() or stratcom_read_input_events() with a timeout of 0 until they
+     * return STRATCOM_RET_NO_DATA, as reports may be buffered by the library as well.
+     * The file descriptor is owned by the device and must not be read from or closed.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @return A file descriptor, or -1 if the device cannot be waited on this way. This is only supported
+     *         for devices opened through the Linux hidraw interface and for simulated devices on POSIX systems.
+     */
+    LIBSTRATCOM_API int stratcom_get_poll_fd(stratcom_device* device);
+
     /** Retrieve a copy of the internal input state.
      * The input state contains state information for all the buttons, axes and sliders of the device.
      * This function does not read any data from the physical device. Use stratcom_read_input() for that.
@@ -486,6 +816,8 @@ extern "C" {
      * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
      * @param[in] axis The axis which is to be queried.
      * @return The current position for the axis stored in the internal input state.
+     *         If the axis is calibrated, this is the calibrated position.
+     * @see stratcom_set_axis_calibration()
      */
     LIBSTRATCOM_API stratcom_axis_word stratcom_get_axis_value(stratcom_device* device, stratcom_axis axis);
 
@@ -497,6 +829,759 @@ extern "C" {
 
     /** @} */
 
+    /** @name Wait Policies.
+     *
+     * Blocking in stratcom_read_input() costs no CPU time while waiting, but the operating system takes some
+     * time to wake up the thread once a report arrives. Polling stratcom_read_input_non_blocking() in a loop picks
+     * up reports as soon as they arrive, but keeps a CPU core busy. stratcom_wait_input() offers policies in
+     * between, and keeps statistics for each policy, so that the tradeoff can be measured on the target system:
+     *
+     *  - STRATCOM_WAIT_BLOCK blocks, like stratcom_read_input().
+     *  - STRATCOM_WAIT_SPIN_THEN_BLOCK polls for a fixed time before blocking. This catches reports that
+     *    follow each other closely, as during continuous movement of an axis.
+     *  - STRATCOM_WAIT_ADAPTIVE learns the rate at which the device sends reports and predicts the arrival of the
+     *    next one. It blocks until shortly before the expected arrival and polls only around it. When no report
+     *    arrives around the expected time, the device is considered idle and the wait blocks.
+     *
+     * Each wait first checks for a report that is already available, which is counted as an immediate wake-up.
+     * Wake-up latency is measured from the timestamp of a report to the return of the wait. Simulated devices
+     * timestamp reports when they are pushed, so the full latency is seen. Physical devices timestamp reports
+     * when they are read from the operating system, which hides the wake-up latency of blocking reads;
+     * compare policies on a simulated device driven at the report rate of the deployment instead.
+     *
+     * @{
+     */
+
+    /** Wait policy types.
+     */
+    typedef enum stratcom_wait_policy_type_ {
+        STRATCOM_WAIT_BLOCK,                     /**< Block until a report arrives. */
+        STRATCOM_WAIT_SPIN_THEN_BLOCK,           /**< Poll for a bounded time, then block. */
+        STRATCOM_WAIT_ADAPTIVE                   /**< Poll only around the expected arrival of the next report. */
+    } stratcom_wait_policy_type;
+
+/** Number of stratcom_wait_policy_type values. */
+#define STRATCOM_NUMBER_OF_WAIT_POLICIES 3
+
+    /** Wait policy.
+     * @see stratcom_wait_input()
+     */
+    typedef struct stratcom_wait_policy_ {
+        stratcom_wait_policy_type type;          /**< Type of the policy. */
+        uint32_t spin_microseconds;              /**< For STRATCOM_WAIT_SPIN_THEN_BLOCK, the time to poll before
+                                                      blocking. For STRATCOM_WAIT_ADAPTIVE, the minimum time to
+                                                      poll before and after the expected arrival, and the time to
+                                                      poll while the report rate is not known yet. */
+        uint32_t max_spin_microseconds;          /**< For STRATCOM_WAIT_ADAPTIVE, the maximum time to poll in a
+                                                      single wait. Ignored by the other policies. */
+    } stratcom_wait_policy;
+
+    /** Wait statistics of a policy.
+     * All times are in microseconds.
+     * @see stratcom_get_wait_statistics()
+     */
+    typedef struct stratcom_wait_statistics_ {
+        uint64_t waits;                          /**< Number of reports read by stratcom_wait_input(). */
+        uint64_t immediate_wakeups;              /**< Reports that had arrived before the wait began. */
+        uint64_t spin_wakeups;                   /**< Reports that were picked up while polling. */
+        uint64_t block_wakeups;                  /**< Reports that were picked up by a blocking read. */
+        uint64_t wait_time;                      /**< Total time spent waiting. */
+        uint64_t cpu_time;                       /**< Total CPU time consumed by the waiting thread while waiting.
+                                                      0 on platforms where the CPU time of a thread is not
+                                                      available. */
+        stratcom_latency_histogram wakeup_latency;  /**< Time from the timestamp of a report until the wait
+                                                         returned. Reports that arrived before the wait began
+                                                         are not included. Only meaningful for simulated
+                                                         devices; physical devices timestamp a report after
+                                                         it was read, so the latency appears as close to 0. */
+    } stratcom_wait_statistics;
+
+    /** Wait for a new input report and read it from the physical device to update the internal input state.
+     * This works like stratcom_read_input(), but waits according to a policy.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] policy The wait policy. Pass \c NULL to block.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR on error or if the policy is invalid.
+     * @see stratcom_get_wait_statistics()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_wait_input(stratcom_device* device, stratcom_wait_policy const* policy);
+
+    /** Retrieve the wait statistics of a device for a policy.
+     * This function must not be called concurrently with stratcom_wait_input().
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] type The policy type.
+     * @param[out] out_statistics Receives the statistics of all waits of the device with policies of that type.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the policy type is invalid.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_get_wait_statistics(stratcom_device* device,
+                                                                 stratcom_wait_policy_type type,
+                                                                 stratcom_wait_statistics* out_statistics);
+
+    /** Clear the wait statistics of a device for all policies.
+     * The learned report rate is kept. This function must not be called concurrently with stratcom_wait_input().
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     */
+    LIBSTRATCOM_API void stratcom_reset_wait_statistics(stratcom_device* device);
+
+    /** @} */
+
+    /** @name Simulated Devices.
+     *
+     * A simulated device behaves like a physical Strategic Commander, except that its input reports are
+     * supplied by the application. This allows exercising an application, or the library itself, without
+     * hardware attached. Simulated devices work with all functions that take a device, including the
+     * functions for reading input and setting the LEDs. Their LED state is stored but not displayed anywhere.
+     *
+     * @{
+     */
+
+    /** Open a simulated device.
+     * The LEDs of a new simulated device are all off and no input reports are queued.
+     * @return Pointer to a device struct on success, which can be freed by calling stratcom_close_device().
+     *         NULL in case of error.
+     * @see stratcom_simulated_device_push_state(), stratcom_close_device()
+     */
+    LIBSTRATCOM_API stratcom_device* stratcom_open_simulated_device();
+
+    /** Queue an input report on a simulated device.
+     * The input state is encoded into an input report, just as the physical device would send it, and
+     * is returned by the next read from the device. The arrival time of the report is the time of the call.
+     * Up to 256 reports can be queued; reports beyond that are rejected.
+     * This function may be called concurrently with reading from the device.
+     * @param[in] device A device structure returned from stratcom_open_simulated_device().
+     * @param[in] state The input state to report. Axis positions outside the range of the device are clamped
+     *                  and STRATCOM_SLIDER_UNKNOWN is reported as STRATCOM_SLIDER_3.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the device is not a simulated device or
+     *         the report queue is full.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_simulated_device_push_state(stratcom_device* device,
+                                                                         stratcom_input_state const* state);
+
+    /** @} */
+
+    /** @name Sequence Numbers and Drop Detection.
+     *
+     * Input reports that are not read in time are buffered by the HID layer. If the buffer overflows,
+     * input reports are lost silently. This may lead to missing button events, causing buttons to
+     * appear stuck.
+     *
+     * Every input report read from the device receives a sequence number. As the device only sends
+     * input reports when its state changes, receiving the same input report twice in a row indicates
+     * that the reports in between were lost. The library counts such gaps and, if resync mode is enabled,
+     * reports the complete button state through stratcom_read_input_events() after a gap was detected.
+     *
+     * @{
+     */
+
+    /** Read statistics.
+     * @see stratcom_get_read_statistics()
+     */
+    typedef struct stratcom_read_statistics_ {
+        uint64_t reports_read;                   /**< Number of input reports read. Equals the current sequence
+                                                      number. */
+        uint64_t gaps_detected;                  /**< Number of times lost input reports were detected. */
+        uint64_t gaps_suspected;                 /**< Number of input reports that changed more than one button at
+                                                      once. This may indicate lost input reports, but may also be
+                                                      caused by pressing buttons at the same time. */
+        uint64_t resyncs;                        /**< Number of resyncs reported by stratcom_read_input_events(). */
+        uint64_t debounce_suppressed;            /**< Number of button changes suppressed by debouncing.
+                                                      @see stratcom_set_debounce_window() */
+    } stratcom_read_statistics;
+
+    /** Retrieve the sequence number of the current input state.
+     * The sequence number is incremented for every input report read from the device, starting with 1
+     * for the first report.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @return Sequence number of the last input report read. 0 if no input report has been read yet.
+     */
+    LIBSTRATCOM_API uint64_t stratcom_get_input_sequence(stratcom_device* device);
+
+    /** Retrieve the read statistics of a device.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[out] out_statistics Receives the current counters.
+     */
+    LIBSTRATCOM_API void stratcom_get_read_statistics(stratcom_device* device,
+                                                      stratcom_read_statistics* out_statistics);
+
+    /** Enable or disable resync mode.
+     * In resync mode, the first call to stratcom_read_input_events() after lost input reports were detected
+     * reports a button event for every button, carrying the current state of the button and the
+     * STRATCOM_INPUT_EVENT_FLAG_RESYNC flag. Clients that track button state from events can use these to
+     * get back in sync with the device. Resync mode is disabled by default.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] enabled 1 to enable resync mode, 0 to disable it.
+     */
+    LIBSTRATCOM_API void stratcom_set_resync_mode(stratcom_device* device, int enabled);
+
+    /** @} */
+
+    /** @name Timestamps.
+     *
+     * The library timestamps each input report upon arrival. Timestamps are measured in microseconds on a
+     * monotonic clock. Use stratcom_get_timestamp() to obtain timestamps on the same clock.
+     *
+     * @{
+     */
+
+    /** Retrieve the current time.
+     * @return The current time on the clock used for timestamping input reports.
+     */
+    LIBSTRATCOM_API stratcom_timestamp stratcom_get_timestamp();
+
+    /** Retrieve the arrival time of the input report that was last read from the device.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @return Timestamp of the last input report read by one of the \c stratcom_read_input* functions.
+     *         0 if no input report has been read yet.
+     */
+    LIBSTRATCOM_API stratcom_timestamp stratcom_get_input_timestamp(stratcom_device* device);
+
+    /** @} */
+
+    /** @name Tracing.
+     *
+     * For analyzing input latency, the library can record spans of time spent in reading input reports,
+     * decoding them, creating input events and sending LED feature reports. Tracing is only available if
+     * the library was built with the \c LIBSTRATCOM_ENABLE_TRACING CMake option, which is off by default.
+     * In such builds tracing is enabled from the start.
+     *
+     * Spans are recorded into a fixed-size buffer per thread, without locking. If a buffer fills up before
+     * its spans are exported, new spans of that thread are dropped. Exported traces use the Chrome Trace Event
+     * JSON format and can be opened in Perfetto or chrome://tracing.
+     *
+     * @{
+     */
+
+    /** Enable or disable the recording of tracing spans at runtime.
+     * @param[in] enabled Non-zero to enable recording, 0 to disable it.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the library was built without tracing.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_enable_tracing(int enabled);
+
+    /** Export all spans recorded since the previous export.
+     * Exported spans are removed from the buffers. This function may be called from any thread.
+     * @param[in] filename Name of the JSON file to write. An existing file of the same name is overwritten.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the library was built without tracing or
+     *         the file could not be written.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_export_trace(char const* filename);
+
+    /** @} */
+
+    /** @name Resampling.
+     *
+     * Input reports arrive at irregular intervals, whenever the user interacts with the device.
+     * Applications that process input at a fixed rate can use the resampling functions to obtain the
+     * input state at an arbitrary point in time. To this end, the device keeps a history of timestamped
+     * input states in a ring buffer that is allocated once when resampling is enabled.
+     *
+     * Buttons are never interpolated. Instead, each sample reports all button presses and releases that
+     * happened since the previous sample, so that short button presses between two samples are not lost.
+     *
+     * @{
+     */
+
+    /** Interpolation of axis values between two input states.
+     */
+    typedef enum stratcom_resample_mode_ {
+        STRATCOM_RESAMPLE_HOLD,                  /**< Axes keep the value of the latest input state. */
+        STRATCOM_RESAMPLE_LINEAR                 /**< Axes are linearly interpolated between input states. */
+    } stratcom_resample_mode;
+
+    /** Resampling configuration.
+     */
+    typedef struct stratcom_resampler_config_ {
+        uint32_t history_size;                   /**< Number of input states kept in the history. */
+        stratcom_resample_mode axis_mode;        /**< Interpolation of axis values. */
+        stratcom_timestamp max_interpolation_interval;  /**< Axes are only interpolated between states that are
+                                                             at most this many microseconds apart. Otherwise,
+                                                             the older value is held. */
+    } stratcom_resampler_config;
+
+    /** Sampled input state.
+     */
+    typedef struct stratcom_sampled_state_ {
+        stratcom_input_state state;              /**< Input state at the sampled time. Buttons that were pressed
+                                                      at any time since the previous sample are reported as pressed,
+                                                      even if they were released before the sampled time. */
+        stratcom_button_word pressed;            /**< Buttons that were pressed since the previous sample. */
+        stratcom_button_word released;           /**< Buttons that were released since the previous sample. */
+    } stratcom_sampled_state;
+
+    /** Enable resampling for a device.
+     * Upon successful execution, every input state read from the device is recorded in a history buffer.
+     * Calling this function again replaces the existing history.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] config Resampling configuration. Pass \c NULL to disable resampling and free the history buffer.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the history buffer could not be allocated.
+     * @see stratcom_sample_at()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_enable_resampling(stratcom_device* device,
+                                                               stratcom_resampler_config const* config);
+
+    /** Sample the input state of a device at a point in time.
+     * For the common case of sampling at increasing points in time close to the present, this function runs in
+     * constant time and never allocates memory. It may be called concurrently with the \c stratcom_read_input*
+     * functions from a different thread.
+     * @param[in] device A device structure with resampling enabled.
+     * @param[in] t Point in time to sample. Button edges are reported for the interval between the latest
+     *              previous call to this function and t.
+     * @param[out] out_sample The sampled input state.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if resampling is not enabled for the device.
+     * @see stratcom_enable_resampling(), stratcom_get_timestamp()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_sample_at(stratcom_device* device, stratcom_timestamp t,
+                                                       stratcom_sampled_state* out_sample);
+
+    /** @} */
+
+    /** @name State History.
+     *
+     * A state history keeps the most recent timestamped input states for analysis or replay. The history is
+     * a ring buffer of fixed capacity, allocated once upon creation. Each field of the input state is stored
+     * packed in an array of its own, so that a state takes 17 bytes including its timestamp, and queries over
+     * a range of time scan contiguous memory. Looking up states by time takes logarithmic time.
+     *
+     * A state history is not tied to a device. Push the states from any source, typically the result of
+     * stratcom_get_input_state() after each successful read. State histories are not safe for concurrent use.
+     *
+     * @{
+     */
+
+    /** State history.
+     * @see stratcom_create_state_history()
+     */
+    typedef struct stratcom_state_history_ stratcom_state_history;
+
+    /** Create a state history.
+     * @param[in] capacity Maximum number of states kept in the history. Once the history is full, each new state
+     *                     overwrites the oldest state.
+     * @return A new, empty state history that must be freed by calling stratcom_free_state_history(),
+     *         or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_state_history* stratcom_create_state_history(uint32_t capacity);
+
+    /** Free a state history.
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     */
+    LIBSTRATCOM_API void stratcom_free_state_history(stratcom_state_history* history);
+
+    /** Add an input state to a state history.
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     * @param[in] timestamp Time at which the state became effective, usually obtained from
+     *                      stratcom_get_input_timestamp(). Must not be older than the previously pushed state.
+     * @param[in] state The input state.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the timestamp is out of order.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_state_history_push(stratcom_state_history* history,
+                                                                stratcom_timestamp timestamp,
+                                                                stratcom_input_state const* state);
+
+    /** Retrieve the number of states in a state history.
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     */
+    LIBSTRATCOM_API uint32_t stratcom_state_history_get_size(stratcom_state_history* history);
+
+    /** Retrieve the input state at a point in time.
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     * @param[in] t The point in time.
+     * @param[out] out_state The newest state that became effective at or before t.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if t precedes all states in the history.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_state_history_get_state_at(stratcom_state_history* history,
+                                                                        stratcom_timestamp t,
+                                                                        stratcom_input_state* out_state);
+
+    /** Query which buttons were held during an interval.
+     * The query considers all states effective at any point in the interval [t0, t1], including the state
+     * that was effective at t0. Parts of the interval preceding the history are ignored.
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     * @param[in] t0 Start of the interval.
+     * @param[in] t1 End of the interval.
+     * @param[out] out_held_any Receives the buttons that were held at any point in the interval.
+     * @param[out] out_held_throughout Receives the buttons that were held throughout the interval.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if t1 precedes t0 or all states in the history.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_state_history_query_buttons(stratcom_state_history* history,
+                                                                         stratcom_timestamp t0, stratcom_timestamp t1,
+                                                                         stratcom_button_word* out_held_any,
+                                                                         stratcom_button_word* out_held_throughout);
+
+    /** Query the range of positions an axis took during an interval.
+     * The interval is treated as in stratcom_state_history_query_buttons().
+     * @param[in] history A state history returned from stratcom_create_state_history().
+     * @param[in] axis The axis which is to be queried.
+     * @param[in] t0 Start of the interval.
+     * @param[in] t1 End of the interval.
+     * @param[out] out_min Receives the lowest position of the axis in the interval.
+     * @param[out] out_max Receives the highest position of the axis in the interval.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if t1 precedes t0 or all states in the history.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_state_history_query_axis_range(stratcom_state_history* history,
+                                                                            stratcom_axis axis,
+                                                                            stratcom_timestamp t0,
+                                                                            stratcom_timestamp t1,
+                                                                            stratcom_axis_word* out_min,
+                                                                            stratcom_axis_word* out_max);
+
+    /** @} */
+
+    /** @name Axis Calibration.
+     *
+     * Calibration maps the raw position of an axis to a calibrated position. The mapping is applied while
+     * decoding input reports, so that the internal input state, stratcom_get_axis_value() and all axis events
+     * report calibrated positions. As the raw axis range consists of only 1024 values, the mapping is
+     * precomputed into a lookup table when the calibration is set, which reduces the cost of calibrating an axis
+     * to a single table lookup per changed axis value.
+     *
+     * Calibrated positions use the same range as raw positions, from -512 to +511. Applications that prefer
+     * normalized floating point positions can request an additional floating point lookup table and query it
+     * with stratcom_get_axis_value_float().
+     *
+     * @{
+     */
+
+    /** Calibration of a single axis.
+     */
+    typedef struct stratcom_axis_calibration_ {
+        stratcom_axis_word min;                  /**< Raw position mapped to the lowest calibrated position. */
+        stratcom_axis_word center;               /**< Raw position mapped to the calibrated position 0. */
+        stratcom_axis_word max;                  /**< Raw position mapped to the highest calibrated position. */
+        float response_curve;                    /**< Exponent of the response curve applied to the distance from the
+                                                      center. 1.0 is linear. Values above 1.0 reduce the sensitivity
+                                                      around the center, values below 1.0 increase it. */
+        int build_float_table;                   /**< Non-zero to additionally build a lookup table for
+                                                      stratcom_get_axis_value_float(). */
+    } stratcom_axis_calibration;
+
+    /** Set the calibration of an axis.
+     * The current axis position in the internal input state is recalibrated immediately. Input states and
+     * events obtained before the call are not changed.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] axis The axis to calibrate.
+     * @param[in] calibration The calibration for the axis. Positions must satisfy min < center < max and the
+     *                        response curve must be positive. Pass \c NULL to remove the calibration.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the calibration is invalid or the lookup
+     *         tables could not be allocated.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_set_axis_calibration(stratcom_device* device, stratcom_axis axis,
+                                                                  stratcom_axis_calibration const* calibration);
+
+    /** Get the normalized value of a particular axis in the internal input state.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] axis The axis which is to be queried.
+     * @return The calibrated position of the axis, from -1.0 to 1.0, taken from the floating point lookup table
+     *         if the axis calibration requested one. Otherwise stratcom_get_axis_value() scaled to the same range.
+     * @see stratcom_set_axis_calibration()
+     */
+    LIBSTRATCOM_API float stratcom_get_axis_value_float(stratcom_device* device, stratcom_axis axis);
+
+    /** @} */
+
+    /** @name Axis Velocity.
+     *
+     * The velocity and acceleration of an axis can be estimated while decoding input reports, based on the
+     * arrival times of the reports. Each report yields a difference quotient to the previous report, which is
+     * blended into the estimate by an exponential filter whose weight depends on the time between the
+     * reports. This keeps the estimate consistent when reports arrive at irregular intervals. The estimator
+     * works on integers only, uses no memory beyond the device structure and costs a constant amount of work
+     * per report.
+     *
+     * As the device only sends reports when its state changes, the estimates decay towards 0 when queried
+     * while no report arrives, as if the axis had not moved since the last report.
+     *
+     * @{
+     */
+
+    /** Enable or disable the velocity estimation for an axis.
+     * Enabling the estimation resets the estimates of the axis.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] axis The axis.
+     * @param[in] smoothing_microseconds Time constant of the filter in microseconds. Larger values give smoother,
+     *                                   but more sluggish estimates. Pass 0 to disable the estimation.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the axis is invalid.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_set_axis_velocity_smoothing(stratcom_device* device, stratcom_axis axis,
+                                                                         uint32_t smoothing_microseconds);
+
+    /** Get the estimated velocity of an axis.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] axis The axis which is to be queried.
+     * @return The velocity in positions per second at the time of the call. 0 if the velocity of the axis is not
+     *         estimated or the axis is invalid.
+     * @see stratcom_set_axis_velocity_smoothing()
+     */
+    LIBSTRATCOM_API int32_t stratcom_get_axis_velocity(stratcom_device* device, stratcom_axis axis);
+
+    /** Get the estimated acceleration of an axis.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] axis The axis which is to be queried.
+     * @return The acceleration in positions per second squared at the time of the call. 0 if the velocity of
+     *         the axis is not estimated or the axis is invalid.
+     * @see stratcom_set_axis_velocity_smoothing()
+     */
+    LIBSTRATCOM_API int32_t stratcom_get_axis_acceleration(stratcom_device* device, stratcom_axis axis);
+
+    /** @} */
+
+    /** @name Macros.
+     *
+     * Macros give the REC button a meaning. While macros are enabled, holding REC arms the recorder and makes the REC
+     * LED blink. Reading input never sends LED reports itself, so the REC LED only changes with the next flush of the
+     * LED state, for instance by stratcom_flush_button_led_state(), which stratcom_led_state_has_unflushed_changes()
+     * indicates. The first of the buttons 1 to 6 pressed while REC is held selects the button the macro is bound to.
+     * All button and axis changes after that are recorded along with their timing, until REC is released. Pressing a
+     * button with a bound macro afterwards plays the macro back.
+     *
+     * Playback produces synthetic input events, flagged with STRATCOM_INPUT_EVENT_FLAG_SYNTHETIC, that are
+     * delivered by stratcom_read_input_events() together with the events of the physical device. Their timestamp
+     * is the time at which they were due. While a macro is playing, stratcom_read_input_events() shortens its wait
+     * so that it returns when the next step is due. Synthetic events do not change the internal input state and
+     * do not trigger macros themselves. Pressing REC stops a running playback.
+     *
+     * All memory for the macros is allocated when they are enabled; recording and playback never allocate.
+     * None of these functions may be called concurrently with reading input from the device.
+     *
+     * @{
+     */
+
+    /** Enable or disable macros for a device.
+     * Enabling macros again erases all recorded macros.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] max_steps Maximum number of button and axis changes recorded for each macro.
+     *                      Pass 0 to disable macros.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the macros could not be allocated or the
+     *         REC LED of an armed recording could not be restored.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_enable_macros(stratcom_device* device, uint32_t max_steps);
+
+    /** Get the number of changes recorded in the macro bound to a button.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] button One of the buttons STRATCOM_BUTTON_1 to STRATCOM_BUTTON_6.
+     * @return Number of recorded changes. 0 if no macro is bound to the button or macros are disabled.
+     */
+    LIBSTRATCOM_API uint32_t stratcom_get_macro_length(stratcom_device* device, stratcom_button button);
+
+    /** Erase the macro bound to a button.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] button One of the buttons STRATCOM_BUTTON_1 to STRATCOM_BUTTON_6.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the button is invalid or macros are
+     *         disabled.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_clear_macro(stratcom_device* device, stratcom_button button);
+
+    /** @} */
+
+    /** @name Debouncing.
+     *
+     * Worn switches may chatter, so that a single press of a button is reported as several presses and
+     * releases. Debouncing filters the button state while decoding input reports, so that the internal input
+     * state, stratcom_is_button_pressed() and all button events report the debounced state.
+     *
+     * Debouncing is eager: a button change is reported as soon as it arrives, without added latency. The button
+     * is then locked for its debounce window, during which further changes of that button are suppressed and
+     * counted in @ref stratcom_read_statistics::debounce_suppressed. If the button was left in a different state
+     * when its window expires, that state is taken on at the end of the window. While such a change is held
+     * back, the read functions wait no longer than until the end of the window, so that a blocking read returns
+     * the change even if the device reports nothing further. The window should therefore be shorter than the
+     * shortest intended press of the button.
+     *
+     * @{
+     */
+
+    /** Set the debounce window of one or more buttons.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] buttons Combination of stratcom_button values of the buttons to configure.
+     * @param[in] window_microseconds Time in microseconds for which further changes of a button are suppressed
+     *                                after a change. Pass 0 to disable debouncing for the buttons.
+     *                                Disabling debouncing for the last button releases any change that is still
+     *                                held back into the internal input state.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if buttons contains invalid bits or the
+     *         debounce state could not be allocated.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_set_debounce_window(stratcom_device* device,
+                                                                 stratcom_button_word buttons,
+                                                                 uint32_t window_microseconds);
+
+    /** @} */
+
+    /** @name Keymaps.
+     *
+     * The three shift buttons and the slider position form 32 layers, in each of which the number buttons,
+     * '+' and '-' can be mapped to a different action. A keymap is compiled from a list of mappings into a flat
+     * table that holds the action for every key in every layer, so that resolving an action is a single table
+     * access, indexed directly by the bits of the button word and the slider state.
+     *
+     * A keymap set on a device resolves the action of each key when it is pressed, which is reported in
+     * @ref stratcom_input_event::action. The release of the key reports the same action, even if the shift
+     * buttons or the slider changed while the key was held. Keymaps can be replaced at any time from any thread,
+     * without interrupting or blocking the thread reading from the device.
+     *
+     * \code{.c}
+        enum { ACTION_FIRE = 1, ACTION_RELOAD, ACTION_MAP };
+        stratcom_keymap_entry const entries[] = {
+            { STRATCOM_KEYMAP_ANY_SLIDER, STRATCOM_KEYMAP_ANY_SHIFT, STRATCOM_BUTTON_1, ACTION_FIRE },
+            { STRATCOM_KEYMAP_ANY_SLIDER, STRATCOM_BUTTON_SHIFT1, STRATCOM_BUTTON_1, ACTION_RELOAD },
+            { STRATCOM_SLIDER_3, 0, STRATCOM_BUTTON_PLUS, ACTION_MAP }
+        };
+        stratcom_keymap* keymap = stratcom_compile_keymap(entries, 3);
+        stratcom_set_keymap(device, keymap);
+     * \endcode
+     *
+     * @{
+     */
+
+    /** Keymap.
+     * @see stratcom_compile_keymap()
+     */
+    typedef struct stratcom_keymap_ stratcom_keymap;
+
+/** Value for @ref stratcom_keymap_entry::slider matching all slider positions. */
+#define STRATCOM_KEYMAP_ANY_SLIDER (-1)
+/** Value for @ref stratcom_keymap_entry::shift_buttons matching all combinations of shift buttons. */
+#define STRATCOM_KEYMAP_ANY_SHIFT 0xFFFF
+
+    /** Mapping of a key to an action in one or more layers.
+     */
+    typedef struct stratcom_keymap_entry_ {
+        int slider;                              /**< The stratcom_slider_state of the layer, including
+                                                      STRATCOM_SLIDER_UNKNOWN, or STRATCOM_KEYMAP_ANY_SLIDER. */
+        stratcom_button_word shift_buttons;      /**< The exact combination of STRATCOM_BUTTON_SHIFT1,
+                                                      STRATCOM_BUTTON_SHIFT2 and STRATCOM_BUTTON_SHIFT3 held
+                                                      in the layer, or STRATCOM_KEYMAP_ANY_SHIFT. */
+        stratcom_button button;                  /**< The key; one of the number buttons, STRATCOM_BUTTON_PLUS
+                                                      or STRATCOM_BUTTON_MINUS. */
+        uint32_t action;                         /**< Application-defined action. 0 means no action. */
+    } stratcom_keymap_entry;
+
+    /** Compile a keymap from a list of mappings.
+     * Where several entries map the same key in the same layer, the entry that comes last takes precedence.
+     * Keys that are not mapped in a layer have an action of 0.
+     * @param[in] entries Array of mappings.
+     * @param[in] number_of_entries Number of elements in entries.
+     * @return A new keymap that must be freed by calling stratcom_free_keymap(), or \c NULL if an entry is
+     *         invalid or the keymap could not be allocated.
+     */
+    LIBSTRATCOM_API stratcom_keymap* stratcom_compile_keymap(stratcom_keymap_entry const* entries,
+                                                             size_t number_of_entries);
+
+    /** Free a keymap.
+     * @param[in] keymap A keymap returned from stratcom_compile_keymap(). It must not be set on any device.
+     */
+    LIBSTRATCOM_API void stratcom_free_keymap(stratcom_keymap* keymap);
+
+    /** Look up the action of a key.
+     * @param[in] keymap A keymap returned from stratcom_compile_keymap().
+     * @param[in] buttons The buttons held, from which the shift buttons select the layer.
+     * @param[in] slider The slider position.
+     * @param[in] button The key.
+     * @return The action of the key in the layer, 0 if it is not mapped or button is not a key.
+     */
+    LIBSTRATCOM_API uint32_t stratcom_keymap_lookup(stratcom_keymap const* keymap, stratcom_button_word buttons,
+                                                    stratcom_slider_state slider, stratcom_button button);
+
+    /** Set the keymap of a device.
+     * May be called from any thread, also while another thread is reading from the device. A keymap may be
+     * set on several devices at once.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] keymap A keymap returned from stratcom_compile_keymap(), or \c NULL to remove the keymap.
+     *                   Keys that are pressed while no keymap is set have an action of 0.
+     * @return The keymap that was set previously, or \c NULL. It is no longer used by the device once this
+     *         function returns and may be freed, unless it is still set on another device.
+     */
+    LIBSTRATCOM_API stratcom_keymap const* stratcom_set_keymap(stratcom_device* device,
+                                                               stratcom_keymap const* keymap);
+
+    /** @} */
+
+    /** @name Input Logs.
+     *
+     * Input logs store a timestamped sequence of input states in a compact file format, suitable for
+     * recording long sessions. Each record only encodes the fields that changed since the previous record,
+     * with variable-length time and axis deltas and button changes as a bit mask. Input states identical to
+     * their predecessor are not recorded at all. A typical record takes three to four bytes.
+     *
+     * Every few thousand records, the writer inserts a keyframe that encodes the complete input state.
+     * The reader uses an index of all keyframes to seek to arbitrary points in time. The index is written
+     * when the writer is closed. If that never happened, for instance because the application crashed,
+     * the reader rebuilds the index when opening the file.
+     *
+     * @{
+     */
+
+    /** Input log writer.
+     * @see stratcom_log_writer_open()
+     */
+    typedef struct stratcom_log_writer_ stratcom_log_writer;
+
+    /** Input log reader.
+     * @see stratcom_log_reader_open()
+     */
+    typedef struct stratcom_log_reader_ stratcom_log_reader;
+
+    /** Create a new input log file.
+     * An existing file of the same name is overwritten.
+     * @param[in] filename Name of the log file.
+     * @param[in] keyframe_interval Number of records between two keyframes. Pass 0 for the default of 4096.
+     * @return A log writer that must be closed by calling stratcom_log_writer_close(), or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_log_writer* stratcom_log_writer_open(char const* filename, uint32_t keyframe_interval);
+
+    /** Append an input state to an input log.
+     * Records are written to the file in large blocks, so they might not be visible in the file right away.
+     * @param[in] writer A log writer returned from stratcom_log_writer_open().
+     * @param[in] timestamp Time of the input state, usually obtained from stratcom_get_input_timestamp().
+     *                      Must not be older than the timestamp of the previously appended state.
+     * @param[in] state The input state.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the timestamp is out of order or writing
+     *         to the file failed.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_log_writer_append(stratcom_log_writer* writer,
+                                                               stratcom_timestamp timestamp,
+                                                               stratcom_input_state const* state);
+
+    /** Write all pending records and the keyframe index, close the log file and free the writer.
+     * @param[in] writer A log writer returned from stratcom_log_writer_open().
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if writing to the file failed at any time.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_log_writer_close(stratcom_log_writer* writer);
+
+    /** Open an input log file for reading.
+     * The reader is positioned at the first record.
+     * @param[in] filename Name of the log file.
+     * @return A log reader that must be closed by calling stratcom_log_reader_close(), or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_log_reader* stratcom_log_reader_open(char const* filename);
+
+    /** Retrieve the number of records in an input log.
+     * @param[in] reader A log reader returned from stratcom_log_reader_open().
+     */
+    LIBSTRATCOM_API uint64_t stratcom_log_reader_get_record_count(stratcom_log_reader* reader);
+
+    /** Position the reader at a point in time.
+     * The next call to stratcom_log_reader_next() returns the last record at or before t, which holds the input
+     * state at time t. If t precedes all records, the reader is positioned at the first record.
+     * @param[in] reader A log reader returned from stratcom_log_reader_open().
+     * @param[in] t The point in time.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the log is empty or could not be read.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_log_reader_seek(stratcom_log_reader* reader, stratcom_timestamp t);
+
+    /** Read the next record from an input log.
+     * @param[in] reader A log reader returned from stratcom_log_reader_open().
+     * @param[out] out_timestamp Timestamp of the record.
+     * @param[out] out_state Input state of the record.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_NO_DATA at the end of the log.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_log_reader_next(stratcom_log_reader* reader,
+                                                             stratcom_timestamp* out_timestamp,
+                                                             stratcom_input_state* out_state);
+
+    /** Close an input log file and free the reader.
+     * @param[in] reader A log reader returned from stratcom_log_reader_open().
+     */
+    LIBSTRATCOM_API void stratcom_log_reader_close(stratcom_log_reader* reader);
+
+    /** @} */
+
     /** @name Iterating Button Identifiers.
      *
      * Use these functions if you need to iterate over all the buttons in a loop.
@@ -565,6 +1650,77 @@ extern "C" {
                                                                                    stratcom_input_state* old_state,
                                                                                    stratcom_input_state* new_state);
 
+    /** Compact input event.
+     * Describes the same change as a stratcom_input_event, but is stored by value in a contiguous buffer.
+     * @see stratcom_diff_states_bulk()
+     */
+    typedef struct stratcom_compact_event_ {
+        uint64_t state_index;                    /**< Index of the input state that introduced the change,
+                                                      relative to the state preceding it. */
+        uint16_t type;                           /**< Type of the event, one of @ref stratcom_input_event_type. */
+        uint16_t control;                        /**< The stratcom_button or stratcom_axis this event refers to.
+                                                      0 for slider events. */
+        int32_t status;                          /**< 1 if the button is pressed and 0 if it is released,
+                                                      the new position of the axis,
+                                                      or the new stratcom_slider_state of the slider. */
+    } stratcom_compact_event;
+
+    /** Growable buffer of compact input events.
+     * Must be zero-initialized before first use and released with stratcom_free_compact_event_buffer().
+     * @see stratcom_diff_states_bulk()
+     */
+    typedef struct stratcom_compact_event_buffer_ {
+        stratcom_compact_event* events;          /**< Array of events. */
+        size_t size;                             /**< Number of valid events in the array.
+                                                      Set this to 0 to reuse the buffer. */
+        size_t capacity;                         /**< Number of events the array can hold before it is grown. */
+    } stratcom_compact_event_buffer;
+
+    /** Generate the input events for all pairs of adjacent states in an array.
+     * For each index i in [1, n) the events describing the changes from states[i-1] to states[i] are appended
+     * to the buffer, in the same order in which they appear in the list returned by
+     * stratcom_create_input_events_from_states(). The buffer is grown as needed.
+     * This is intended for the offline analysis of long recordings of input states. Adjacent states are
+     * compared several at a time with SIMD instructions where available, so that unchanged stretches cost
+     * little more than reading them from memory.
+     * @param[in] states Array of input states.
+     * @param[in] n Number of elements in states.
+     * @param[in,out] buffer A zero-initialized buffer or a buffer previously passed to this function.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the buffer could not be grown.
+     *         In case of error, the buffer holds the same events as before the call.
+     * @see stratcom_create_input_events_from_states(), stratcom_free_compact_event_buffer()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_diff_states_bulk(stratcom_input_state const* states, size_t n,
+                                                              stratcom_compact_event_buffer* buffer);
+
+    /** Free the events of a compact event buffer.
+     * The buffer is reset to zero afterwards and may be reused.
+     * @param[in,out] buffer A buffer passed to stratcom_diff_states_bulk().
+     */
+    LIBSTRATCOM_API void stratcom_free_compact_event_buffer(stratcom_compact_event_buffer* buffer);
+
+    /** Read a new input report from the physical device and generate the input events caused by it.
+     * This function updates the internal input state like stratcom_read_input_with_timeout() does.
+     * The generated events are identical to those obtained by calling stratcom_create_input_events_from_states()
+     * with the internal input states from before and after the read. Unlike that function, the events are
+     * generated directly from the difference between the raw input reports, without decoding the parts of the
+     * report that did not change. Reading a report that is identical to the previous one costs no more than
+     * a single comparison.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] timeout_milliseconds Time in milliseconds that the function will wait for an input report to
+     *                                 become available. Pass -1 to wait indefinitely and 0 to return immediately.
+     * @param[out] out_events Receives a pointer to a linked list of input events, which must be freed by calling
+     *                        stratcom_free_input_events(). Receives \c NULL if the input report did not change
+     *                        the input state or if no input report was read.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR on error, STRATCOM_RET_NO_DATA on timeout.
+     *         In case the input events could not be allocated, STRATCOM_RET_ERROR is returned but the internal
+     *         input state is still updated.
+     * @see stratcom_create_input_events_from_states(), stratcom_free_input_events(),
+     *      stratcom_read_input_with_timeout()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_read_input_events(stratcom_device* device, int timeout_milliseconds,
+                                                               stratcom_input_event** out_events);
+
     /** Free a list of input events.
      * @param[in] events An input event list obtained from stratcom_create_input_events_from_states().
      * @see stratcom_create_input_events_from_states()
@@ -573,6 +1729,341 @@ extern "C" {
 
     /** @} */
 
+    /** @name Dispatchers.
+     *
+     * A dispatcher invokes handler functions for individual controls directly from the read path, instead of
+     * building a list of input events that the client has to walk. Handlers are registered per button, per axis,
+     * for the slider, or for any control. Each registration recompiles a flat table that holds the handlers of
+     * each control, indexed by the bit that the control occupies in a mask of changed controls. Dispatching an
+     * input report then only visits the controls that changed and have handlers, and never allocates memory.
+     *
+     * \code{.c}
+        void onButton1(void* user_data, stratcom_input_event_type type, int control,
+                       int32_t old_value, int32_t new_value, stratcom_timestamp timestamp)
+        {
+            ...
+        }
+
+        stratcom_dispatcher* dispatcher = stratcom_create_dispatcher();
+        stratcom_dispatcher_on_button(dispatcher, STRATCOM_BUTTON_1, onButton1, NULL);
+        while(stratcom_read_input_dispatch(device, -1, dispatcher) == STRATCOM_RET_SUCCESS) {}
+        stratcom_free_dispatcher(dispatcher);
+     * \endcode
+     *
+     * @{
+     */
+
+    /** Dispatcher.
+     * @see stratcom_create_dispatcher()
+     */
+    typedef struct stratcom_dispatcher_ stratcom_dispatcher;
+
+    /** Handler function for changes of a control.
+     * @param[in] user_data The user data passed upon registration.
+     * @param[in] type STRATCOM_INPUT_EVENT_BUTTON, STRATCOM_INPUT_EVENT_AXIS or STRATCOM_INPUT_EVENT_SLIDER.
+     * @param[in] control The stratcom_button or stratcom_axis that changed. 0 for the slider.
+     * @param[in] old_value The previous value: 1 for a pressed button and 0 for a released one,
+     *                      the axis position, or the stratcom_slider_state.
+     * @param[in] new_value The new value, in the same form as old_value.
+     * @param[in] timestamp Arrival time of the input report.
+     */
+    typedef void (*stratcom_control_handler)(void* user_data, stratcom_input_event_type type, int control,
+                                             int32_t old_value, int32_t new_value, stratcom_timestamp timestamp);
+
+    /** Create a new dispatcher without any handlers.
+     * @return A new dispatcher that must be freed by calling stratcom_free_dispatcher(), or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_dispatcher* stratcom_create_dispatcher();
+
+    /** Free a dispatcher.
+     * @param[in] dispatcher A dispatcher returned from stratcom_create_dispatcher().
+     */
+    LIBSTRATCOM_API void stratcom_free_dispatcher(stratcom_dispatcher* dispatcher);
+
+    /** Register a handler for a button.
+     * Any number of handlers may be registered for the same control. Handlers of a control are invoked in
+     * the order of their registration, followed by the handlers registered with stratcom_dispatcher_on_any().
+     * Registering handlers must not happen concurrently with dispatching.
+     * @param[in] dispatcher A dispatcher returned from stratcom_create_dispatcher().
+     * @param[in] button The button.
+     * @param[in] handler The handler.
+     * @param[in] user_data User data passed to the handler.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the button is invalid or the handler
+     *         could not be registered.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_dispatcher_on_button(stratcom_dispatcher* dispatcher,
+                                                                  stratcom_button button,
+                                                                  stratcom_control_handler handler,
+                                                                  void* user_data);
+
+    /** Register a handler for an axis.
+     * @see stratcom_dispatcher_on_button()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_dispatcher_on_axis(stratcom_dispatcher* dispatcher,
+                                                                stratcom_axis axis,
+                                                                stratcom_control_handler handler,
+                                                                void* user_data);
+
+    /** Register a handler for the slider.
+     * @see stratcom_dispatcher_on_button()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_dispatcher_on_slider(stratcom_dispatcher* dispatcher,
+                                                                  stratcom_control_handler handler,
+                                                                  void* user_data);
+
+    /** Register a handler for all controls.
+     * @see stratcom_dispatcher_on_button()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_dispatcher_on_any(stratcom_dispatcher* dispatcher,
+                                                               stratcom_control_handler handler,
+                                                               void* user_data);
+
+    /** Read an input report from the device and dispatch the resulting changes.
+     * Works like stratcom_read_input_with_timeout(), but afterwards invokes the handlers of all controls that
+     * changed, on the calling thread. Controls are dispatched in the same order in which
+     * stratcom_read_input_events() would generate their events. No memory is allocated.
+     * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+     * @param[in] timeout_milliseconds Time in milliseconds that the function will wait for an input report to
+     *                                 become available. Pass -1 to wait indefinitely and 0 to return immediately.
+     * @param[in] dispatcher A dispatcher returned from stratcom_create_dispatcher().
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR on error, STRATCOM_RET_NO_DATA on timeout.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_read_input_dispatch(stratcom_device* device, int timeout_milliseconds,
+                                                                 stratcom_dispatcher* dispatcher);
+
+    /** @} */
+
+    /** @name Gestures.
+     *
+     * A gesture engine recognizes higher level gestures in the button events of one or more devices:
+     * Taps, double taps, long presses and chords of one or more shift buttons with a number button.
+     * All timers of an engine are kept in a single hierarchical timer wheel, so that starting, cancelling and
+     * expiring a timer takes constant time, regardless of the number of devices. The engine allocates all of
+     * its memory upon creation and never allocates while recognizing gestures.
+     *
+     * Feed each list of input events to stratcom_gesture_engine_process_events() and call
+     * stratcom_gesture_engine_advance() regularly, to recognize gestures that are triggered by the passing
+     * of time, like long presses.
+     *
+     * \code{.c}
+        stratcom_input_event* events;
+        if(stratcom_read_input_events(device, 10, &events) == STRATCOM_RET_SUCCESS) {
+            stratcom_gesture_engine_process_events(engine, 0, events);
+            stratcom_free_input_events(events);
+        }
+        stratcom_gesture_engine_advance(engine, stratcom_get_timestamp());
+     * \endcode
+     *
+     * @{
+     */
+
+    /** Gesture engine.
+     * @see stratcom_create_gesture_engine()
+     */
+    typedef struct stratcom_gesture_engine_ stratcom_gesture_engine;
+
+    /** Different types of gestures.
+     */
+    typedef enum stratcom_gesture_type_ {
+        STRATCOM_GESTURE_TAP,                    /**< A button was pressed and released again before the long press
+                                                      time elapsed and was not pressed again within the double tap
+                                                      interval. */
+        STRATCOM_GESTURE_DOUBLE_TAP,             /**< A button was tapped and pressed again within the double tap
+                                                      interval. Reported when the button is pressed the second time. */
+        STRATCOM_GESTURE_LONG_PRESS,             /**< A button was held for the long press time. Reported while the
+                                                      button is still held. */
+        STRATCOM_GESTURE_CHORD                   /**< A number button was pressed while holding one or more shift
+                                                      buttons. The number button does not cause any other gestures. */
+    } stratcom_gesture_type;
+
+    /** Gesture recognition thresholds.
+     */
+    typedef struct stratcom_gesture_config_ {
+        stratcom_timestamp long_press_time;      /**< Time in microseconds a button has to be held for a long press.
+                                                      0 disables long presses. */
+        stratcom_timestamp double_tap_interval;  /**< Maximum time in microseconds between releasing a button and
+                                                      pressing it again for a double tap. 0 disables double taps,
+                                                      which causes taps to be reported immediately upon release. */
+        int enable_chords;                       /**< Non-zero to enable recognition of chords. */
+    } stratcom_gesture_config;
+
+    /** A recognized gesture.
+     */
+    typedef struct stratcom_gesture_ {
+        stratcom_gesture_type type;              /**< Type of the gesture. */
+        uint32_t device_index;                   /**< Index of the device as passed to
+                                                      stratcom_gesture_engine_process_events(). */
+        stratcom_button button;                  /**< The button that performed the gesture. For chords, this is the
+                                                      number button. */
+        stratcom_button_word shift_buttons;      /**< For chords, the shift buttons held. 0 otherwise. */
+        stratcom_timestamp timestamp;            /**< Time at which the gesture was recognized. */
+    } stratcom_gesture;
+
+    /** Callback receiving recognized gestures.
+     * @param[in] user_data The user data passed to stratcom_create_gesture_engine().
+     * @param[in] gesture The recognized gesture. Only valid for the duration of the call.
+     */
+    typedef void (*stratcom_gesture_callback)(void* user_data, stratcom_gesture const* gesture);
+
+    /** Create a gesture engine.
+     * @param[in] number_of_devices Number of devices the engine recognizes gestures for.
+     * @param[in] config Gesture recognition thresholds. Pass \c NULL to use the defaults of a 500 ms long press
+     *                   time, a 250 ms double tap interval and chords enabled.
+     * @param[in] callback Callback receiving all recognized gestures.
+     * @param[in] user_data User data passed to the callback.
+     * @return A new gesture engine that must be freed by calling stratcom_free_gesture_engine(),
+     *         or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_gesture_engine* stratcom_create_gesture_engine(uint32_t number_of_devices,
+                                                                            stratcom_gesture_config const* config,
+                                                                            stratcom_gesture_callback callback,
+                                                                            void* user_data);
+
+    /** Free a gesture engine.
+     * Pending gestures are discarded.
+     * @param[in] engine A gesture engine created by stratcom_create_gesture_engine().
+     */
+    LIBSTRATCOM_API void stratcom_free_gesture_engine(stratcom_gesture_engine* engine);
+
+    /** Feed a list of input events of a device to the gesture engine.
+     * Gestures triggered by the events are reported through the callback before this function returns.
+     * Timers that expire before the events happened are processed first.
+     * @param[in] engine A gesture engine created by stratcom_create_gesture_engine().
+     * @param[in] device_index Index of the device the events originate from. Must be less than the number of
+     *                         devices passed to stratcom_create_gesture_engine().
+     * @param[in] events A list of input events. Event timestamps are used for timing; events without a timestamp,
+     *                   like those from stratcom_create_input_events_from_states(), are assumed to happen now.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the device index is out of range.
+     * @see stratcom_read_input_events()
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_gesture_engine_process_events(stratcom_gesture_engine* engine,
+                                                                           uint32_t device_index,
+                                                                           stratcom_input_event const* events);
+
+    /** Advance the time of the gesture engine.
+     * Gestures triggered by timers expiring up to the given time are reported through the callback before
+     * this function returns.
+     * @param[in] engine A gesture engine created by stratcom_create_gesture_engine().
+     * @param[in] now The current time, as returned by stratcom_get_timestamp().
+     */
+    LIBSTRATCOM_API void stratcom_gesture_engine_advance(stratcom_gesture_engine* engine, stratcom_timestamp now);
+
+    /** @} */
+
+    /** @name Event Merging.
+     *
+     * An event merger combines the input events of several devices into a single stream that is ordered by
+     * timestamp. Each device is read on its own producer thread, which pushes the events it reads into a queue
+     * of the merger that belongs to that device. A single consumer thread reads the merged stream.
+     *
+     * The events of each device are already ordered, so the merger only has to merge the oldest pending events
+     * of all devices, which it keeps in a min-heap. The cost per event grows only logarithmically with the
+     * number of devices, and producers never take a lock unless the consumer is waiting.
+     * An event is released as soon as all devices have events pending, since no older event can arrive anymore.
+     * Otherwise it is held back until it is older than the reordering window, giving events of other devices
+     * that are still in flight the chance to be sorted in before it. The merger allocates all of its memory
+     * upon creation.
+     *
+     * \code{.c}
+        // producer thread for device i
+        stratcom_input_event* events;
+        while(stratcom_read_input_events(devices[i], -1, &events) != STRATCOM_RET_ERROR) {
+            stratcom_event_merger_push_events(merger, i, events);
+            stratcom_free_input_events(events);
+        }
+
+        // consumer thread
+        stratcom_merged_event merged[64];
+        size_t count;
+        while(stratcom_read_merged_events(merger, -1, merged, 64, &count) == STRATCOM_RET_SUCCESS) {
+            ...
+        }
+     * \endcode
+     *
+     * @{
+     */
+
+    /** Event merger.
+     * @see stratcom_create_event_merger()
+     */
+    typedef struct stratcom_event_merger_ stratcom_event_merger;
+
+    /** An input event tagged with the device it originates from.
+     */
+    typedef struct stratcom_merged_event_ {
+        uint32_t device_index;                   /**< Index of the device as passed to
+                                                      stratcom_event_merger_push_events(). */
+        stratcom_input_event event;              /**< The input event. The next pointer is always \c NULL. */
+    } stratcom_merged_event;
+
+    /** Event merger statistics.
+     * @see stratcom_get_event_merger_statistics()
+     */
+    typedef struct stratcom_event_merger_statistics_ {
+        uint64_t events_merged;                  /**< Total number of events read from the merger. */
+        uint64_t events_late;                    /**< Number of events that were read after a younger event, because
+                                                      they arrived after the reordering window had passed. */
+        uint64_t events_dropped;                 /**< Number of events that were dropped because the queue of
+                                                      their device was full. */
+    } stratcom_event_merger_statistics;
+
+    /** Create an event merger.
+     * @param[in] number_of_devices Number of devices whose events are merged.
+     * @param[in] queue_size Number of events that can be queued for each device. Rounded up to a power of two.
+     * @param[in] reorder_window Time in microseconds an event is held back while not all devices have events
+     *                           pending. This should exceed the time it takes from the arrival of an input report
+     *                           until its events are pushed to the merger.
+     * @return A new event merger that must be freed by calling stratcom_free_event_merger(),
+     *         or \c NULL on error.
+     */
+    LIBSTRATCOM_API stratcom_event_merger* stratcom_create_event_merger(uint32_t number_of_devices, size_t queue_size,
+                                                                        stratcom_timestamp reorder_window);
+
+    /** Free an event merger.
+     * Events that were not read are discarded. No other thread may access the merger anymore.
+     * @param[in] merger An event merger created by stratcom_create_event_merger().
+     */
+    LIBSTRATCOM_API void stratcom_free_event_merger(stratcom_event_merger* merger);
+
+    /** Queue a list of input events of a device for merging.
+     * For each device index, only one thread at a time may push events. Events of a device must be pushed in
+     * order of their timestamps. Different devices may be pushed from different threads concurrently.
+     * @param[in] merger An event merger created by stratcom_create_event_merger().
+     * @param[in] device_index Index of the device the events originate from. Must be less than the number of
+     *                         devices passed to stratcom_create_event_merger().
+     * @param[in] events A list of input events, as obtained from stratcom_read_input_events(). The events are
+     *                   copied, so the list may be freed afterwards.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the device index is out of range or if the
+     *         queue of the device was full. In the latter case, all events that fit have been queued.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_event_merger_push_events(stratcom_event_merger* merger,
+                                                                      uint32_t device_index,
+                                                                      stratcom_input_event const* events);
+
+    /** Read the next events from the merged stream.
+     * Only one thread at a time may read from a merger.
+     * @param[in] merger An event merger created by stratcom_create_event_merger().
+     * @param[in] timeout_milliseconds Time in milliseconds that the function will wait for an event to become
+     *                                 ready. Pass -1 to wait indefinitely and 0 to return immediately.
+     * @param[out] out_events Array receiving the events, ordered by timestamp.
+     * @param[in] max_events Size of the out_events array.
+     * @param[out] out_count Receives the number of events written to out_events.
+     * @return STRATCOM_RET_SUCCESS if at least one event was read, STRATCOM_RET_NO_DATA on timeout.
+     */
+    LIBSTRATCOM_API stratcom_return stratcom_read_merged_events(stratcom_event_merger* merger,
+                                                                int timeout_milliseconds,
+                                                                stratcom_merged_event* out_events,
+                                                                size_t max_events, size_t* out_count);
+
+    /** Retrieve statistics about an event merger.
+     * @param[in] merger An event merger created by stratcom_create_event_merger().
+     * @param[out] out_statistics Receives the statistics.
+     */
+    LIBSTRATCOM_API void stratcom_get_event_merger_statistics(stratcom_event_merger* merger,
+                                                              stratcom_event_merger_statistics* out_statistics);
+
+    /** @} */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,635 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/** @file
+ * Coroutine Interface.
+ * This optional, header-only C++20 layer lets coroutines wait for device input without blocking a thread:
+ *
+ * \code{.cpp}
+    stratcom::coro::task<> watchButtons(stratcom::coro::async_device& device)
+    {
+        for(;;) {
+            stratcom_input_event const ev = co_await device.next_event();
+            if(ev.type == STRATCOM_INPUT_EVENT_BUTTON) { ... }
+        }
+    }
+
+    stratcom::coro::executor executor;
+    stratcom::coro::async_device device(executor, stratcom_open_device());
+    executor.spawn(watchButtons(device));
+    executor.run();
+ * \endcode
+ *
+ * All coroutines run on the thread calling executor::run(). The executor waits for input on the file
+ * descriptors returned by stratcom_get_poll_fd() with a single poll() call, so any number of coroutines
+ * waiting on any number of devices costs no additional threads. Waiting coroutines are resumed directly
+ * from the event loop; a coroutine that awaits the next event right after processing one does not miss
+ * events, no matter how many other coroutines are waiting on the same device.
+ *
+ * This header requires POSIX and a device backend that supports stratcom_get_poll_fd(), that is, the
+ * Linux hidraw backend or simulated devices.
+ */
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_CORO_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_CORO_HPP_
+
+#include <stratcom.h>
+
+#if !defined __cpp_impl_coroutine
+#   error stratcom_coro.hpp requires C++20 coroutine support.
+#endif
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace stratcom::coro {
+
+    class executor;
+    class async_device;
+
+    /** Thrown by the awaitables of async_device if reading from the device failed.
+     * Usually this means that the device was unplugged.
+     */
+    class device_error : public std::runtime_error {
+    public:
+        device_error()
+            :std::runtime_error("Error reading from Strategic Commander device")
+        {}
+    };
+
+    namespace detail {
+        void onDetachedTaskDone(executor& exec, std::coroutine_handle<> handle, std::exception_ptr exception);
+
+        struct promise_base {
+            std::coroutine_handle<> continuation;       ///< coroutine awaiting the task; null if not awaited.
+            std::exception_ptr exception;
+            executor* detached_owner = nullptr;         ///< executor owning the task, if it was spawned.
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    promise_base& p = handle.promise();
+                    if(p.continuation) { return p.continuation; }
+                    if(p.detached_owner) { onDetachedTaskDone(*p.detached_owner, handle, p.exception); }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            final_awaiter final_suspend() noexcept { return {}; }
+        };
+
+        template<typename T>
+        struct task_promise : promise_base {
+            std::optional<T> value;
+
+            template<typename U>
+            void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+            T result()
+            {
+                if(exception) { std::rethrow_exception(exception); }
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct task_promise<void> : promise_base {
+            void return_void() {}
+
+            void result()
+            {
+                if(exception) { std::rethrow_exception(exception); }
+            }
+        };
+    }
+
+    /** A lazily started coroutine.
+     * The coroutine starts running when the task is awaited or spawned on an executor.
+     */
+    template<typename T = void>
+    class [[nodiscard]] task {
+    public:
+        struct promise_type : detail::task_promise<T> {
+            task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        };
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+
+        explicit task(std::coroutine_handle<promise_type> handle)
+            :m_handle(handle)
+        {}
+    public:
+        task(task&& rhs) noexcept
+            :m_handle(std::exchange(rhs.m_handle, nullptr))
+        {}
+
+        task& operator=(task&& rhs) noexcept
+        {
+            if(this != &rhs) {
+                if(m_handle) { m_handle.destroy(); }
+                m_handle = std::exchange(rhs.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~task()
+        {
+            if(m_handle) { m_handle.destroy(); }
+        }
+
+        task(task const&) = delete;
+        task& operator=(task const&) = delete;
+
+        auto operator co_await() && noexcept
+        {
+            struct awaiter {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume() { return handle.promise().result(); }
+            };
+            return awaiter{ m_handle };
+        }
+
+        /** Give up ownership of the coroutine.
+         */
+        std::coroutine_handle<promise_type> release() noexcept
+        {
+            return std::exchange(m_handle, nullptr);
+        }
+    };
+
+    /** Single-threaded executor driving coroutines from a poll() loop.
+     */
+    class executor {
+    public:
+        typedef std::chrono::steady_clock clock;
+    private:
+        friend class async_device;
+        friend void detail::onDetachedTaskDone(executor&, std::coroutine_handle<>, std::exception_ptr);
+
+        /** A pending timeout. Calls on_expired with context once the deadline has passed.
+         */
+        struct timer {
+            void (*on_expired)(void* context);
+            void* context;
+        };
+        typedef std::multimap<clock::time_point, timer>::iterator timer_handle;
+
+        std::deque<std::coroutine_handle<>> m_ready;
+        std::unordered_set<void*> m_tasks;             ///< addresses of spawned tasks that are still running.
+        std::multimap<clock::time_point, timer> m_timers;
+        std::vector<async_device*> m_devices;
+        std::vector<pollfd> m_pollfds;
+        std::exception_ptr m_exception;                 ///< first exception that escaped a spawned task.
+        bool m_stop = false;
+    public:
+        executor() = default;
+
+        ~executor()
+        {
+            for(void* address : m_tasks) { std::coroutine_handle<>::from_address(address).destroy(); }
+        }
+
+        executor(executor const&) = delete;
+        executor& operator=(executor const&) = delete;
+
+        /** Start running a task. The executor takes ownership of the task.
+         * The task starts running on the next iteration of the event loop.
+         */
+        void spawn(task<> t)
+        {
+            auto handle = t.release();
+            handle.promise().detached_owner = this;
+            m_tasks.insert(handle.address());
+            m_ready.push_back(handle);
+        }
+
+        /** Awaitable suspending the calling coroutine for a period of time.
+         */
+        auto sleep_for(clock::duration duration)
+        {
+            struct awaiter {
+                executor& exec;
+                clock::duration duration;
+
+                bool await_ready() const noexcept { return duration <= clock::duration::zero(); }
+
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    exec.addTimer(clock::now() + duration, &awaiter::resume, handle.address());
+                }
+
+                void await_resume() noexcept {}
+
+                static void resume(void* address)
+                {
+                    std::coroutine_handle<>::from_address(address).resume();
+                }
+            };
+            return awaiter{ *this, duration };
+        }
+
+        /** Run the event loop until all spawned tasks have completed or stop() was called.
+         * If a spawned task exits with an exception, the event loop stops and the exception is rethrown.
+         * @throw std::logic_error If tasks are still running but nothing is left that could resume them.
+         */
+        void run()
+        {
+            m_stop = false;
+            while(!m_tasks.empty() && !m_stop) {
+                while(!m_ready.empty() && !m_exception) {
+                    auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    handle.resume();
+                }
+                if(m_exception) { std::rethrow_exception(std::exchange(m_exception, nullptr)); }
+                if(m_tasks.empty() || m_stop) { break; }
+                waitAndDispatch();
+                if(m_exception) { std::rethrow_exception(std::exchange(m_exception, nullptr)); }
+            }
+        }
+
+        /** Make run() return after the current iteration of the event loop.
+         */
+        void stop() noexcept
+        {
+            m_stop = true;
+        }
+
+    private:
+        timer_handle addTimer(clock::time_point deadline, void (*on_expired)(void*), void* context)
+        {
+            return m_timers.emplace(deadline, timer{ on_expired, context });
+        }
+
+        void cancelTimer(timer_handle handle)
+        {
+            m_timers.erase(handle);
+        }
+
+        void onTaskDone(std::coroutine_handle<> handle, std::exception_ptr exception)
+        {
+            m_tasks.erase(handle.address());
+            handle.destroy();
+            if(exception && !m_exception) { m_exception = exception; }
+        }
+
+        void waitAndDispatch();
+    };
+
+    /** A device whose input can be awaited by coroutines running on an executor.
+     * The async_device must outlive all coroutines waiting on it. It does not take ownership of the device.
+     */
+    class async_device {
+    private:
+        friend class executor;
+
+        /** Common part of the awaitables, linked into the list of waiting coroutines.
+         */
+        struct waiter {
+            waiter* prev = nullptr;
+            waiter* next = nullptr;
+            std::coroutine_handle<> handle;
+            bool failed = false;
+        };
+
+        struct waiter_list {
+            waiter head;
+
+            waiter_list() { head.prev = head.next = &head; }
+            waiter_list(waiter_list const&) = delete;
+            waiter_list& operator=(waiter_list const&) = delete;
+
+            bool empty() const { return head.next == &head; }
+
+            void push_back(waiter& w)
+            {
+                w.prev = head.prev;
+                w.next = &head;
+                head.prev->next = &w;
+                head.prev = &w;
+            }
+
+            static void unlink(waiter& w)
+            {
+                w.prev->next = w.next;
+                w.next->prev = w.prev;
+                w.prev = w.next = nullptr;
+            }
+
+            /** Move all waiters to another, empty list.
+             */
+            void moveTo(waiter_list& target)
+            {
+                if(empty()) { return; }
+                target.head.next = head.next;
+                target.head.prev = head.prev;
+                target.head.next->prev = &target.head;
+                target.head.prev->next = &target.head;
+                head.prev = head.next = &head;
+            }
+        };
+
+        executor& m_executor;
+        stratcom_device* m_device;
+        int m_fd;
+        bool m_failed = false;
+        waiter_list m_event_waiters;
+        waiter_list m_state_waiters;
+    public:
+        class event_awaitable : private waiter {
+        private:
+            friend class async_device;
+            async_device& m_owner;
+            stratcom_input_event m_event;
+        public:
+            explicit event_awaitable(async_device& owner)
+                :m_owner(owner)
+            {}
+
+            bool await_ready() const noexcept { return m_owner.m_failed; }
+
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                handle = h;
+                m_owner.m_event_waiters.push_back(*this);
+            }
+
+            /** @return The event. Its next field is always NULL.
+             * @throw device_error If reading from the device failed.
+             */
+            stratcom_input_event await_resume()
+            {
+                if(failed || m_owner.m_failed) { throw device_error(); }
+                return m_event;
+            }
+        };
+
+        class state_awaitable : private waiter {
+        private:
+            friend class async_device;
+            async_device& m_owner;
+            std::optional<executor::clock::duration> m_timeout;
+            executor::timer_handle m_timer;
+            std::optional<stratcom_input_state> m_state;
+        public:
+            state_awaitable(async_device& owner, std::optional<executor::clock::duration> timeout)
+                :m_owner(owner), m_timeout(timeout)
+            {}
+
+            bool await_ready() const noexcept { return m_owner.m_failed; }
+
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                handle = h;
+                m_owner.m_state_waiters.push_back(*this);
+                if(m_timeout) {
+                    m_timer = m_owner.m_executor.addTimer(executor::clock::now() + *m_timeout,
+                                                          &state_awaitable::onTimeout, this);
+                }
+            }
+
+            /** @return The input state after the next input report, or an empty optional on timeout.
+             * @throw device_error If reading from the device failed.
+             */
+            std::optional<stratcom_input_state> await_resume()
+            {
+                if(failed || (m_owner.m_failed && !m_state)) { throw device_error(); }
+                return m_state;
+            }
+        private:
+            static void onTimeout(void* context)
+            {
+                auto& self = *static_cast<state_awaitable*>(context);
+                waiter_list::unlink(self);
+                self.m_timeout.reset();
+                self.handle.resume();
+            }
+
+            void complete(stratcom_input_state const* state)
+            {
+                if(m_timeout) { m_owner.m_executor.cancelTimer(m_timer); }
+                if(state) { m_state = *state; } else { failed = true; }
+                handle.resume();
+            }
+        };
+
+        /** @param[in] exec The executor resuming the coroutines waiting on this device.
+         * @param[in] device A device structure returned from stratcom_open_device() or stratcom_open_device_on_path().
+         * @throw std::invalid_argument If the device does not support stratcom_get_poll_fd().
+         */
+        async_device(executor& exec, stratcom_device* device)
+            :m_executor(exec), m_device(device), m_fd(device ? stratcom_get_poll_fd(device) : -1)
+        {
+            if(m_fd < 0) { throw std::invalid_argument("Device does not support waiting on a file descriptor."); }
+            m_executor.m_devices.push_back(this);
+        }
+
+        ~async_device()
+        {
+            auto& devices = m_executor.m_devices;
+            for(auto it = devices.begin(); it != devices.end(); ++it) {
+                if(*it == this) { devices.erase(it); break; }
+            }
+        }
+
+        async_device(async_device const&) = delete;
+        async_device& operator=(async_device const&) = delete;
+
+        stratcom_device* get() const noexcept
+        {
+            return m_device;
+        }
+
+        /** Wait for the next input event.
+         * @note Events generated while the coroutine is not waiting are not delivered to it.
+         */
+        event_awaitable next_event()
+        {
+            return event_awaitable(*this);
+        }
+
+        /** Wait for the next input report and retrieve the resulting input state.
+         */
+        state_awaitable next_state()
+        {
+            return state_awaitable(*this, std::nullopt);
+        }
+
+        /** Wait for the next input report for at most timeout and retrieve the resulting input state.
+         */
+        state_awaitable next_state(executor::clock::duration timeout)
+        {
+            return state_awaitable(*this, timeout);
+        }
+
+    private:
+        bool hasWaiters() const
+        {
+            return !m_failed && (!m_event_waiters.empty() || !m_state_waiters.empty());
+        }
+
+        /** Read and dispatch all available input reports.
+         */
+        void onReadable()
+        {
+            for(;;) {
+                stratcom_input_event* events = nullptr;
+                stratcom_return const res = stratcom_read_input_events(m_device, 0, &events);
+                if(res == STRATCOM_RET_NO_DATA) { return; }
+                if(res != STRATCOM_RET_SUCCESS) {
+                    stratcom_free_input_events(events);
+                    fail();
+                    return;
+                }
+                stratcom_input_state const state = stratcom_get_input_state(m_device);
+                dispatchState(&state);
+                for(auto ev = events; ev; ev = ev->next) {
+                    dispatchEvent(*ev);
+                }
+                stratcom_free_input_events(events);
+            }
+        }
+
+        /** Resume all waiting coroutines with a device_error.
+         */
+        void fail()
+        {
+            m_failed = true;
+            dispatchState(nullptr);
+            waiter_list waiters;
+            m_event_waiters.moveTo(waiters);
+            while(!waiters.empty()) {
+                waiter& w = *waiters.head.next;
+                waiter_list::unlink(w);
+                w.failed = true;
+                w.handle.resume();
+            }
+        }
+
+        void dispatchState(stratcom_input_state const* state)
+        {
+            // coroutines that wait again while being resumed are added to the now empty list of the device
+            waiter_list waiters;
+            m_state_waiters.moveTo(waiters);
+            while(!waiters.empty()) {
+                auto& w = static_cast<state_awaitable&>(*waiters.head.next);
+                waiter_list::unlink(w);
+                w.complete(state);
+            }
+        }
+
+        void dispatchEvent(stratcom_input_event const& ev)
+        {
+            waiter_list waiters;
+            m_event_waiters.moveTo(waiters);
+            while(!waiters.empty()) {
+                auto& w = static_cast<event_awaitable&>(*waiters.head.next);
+                waiter_list::unlink(w);
+                w.m_event = ev;
+                w.m_event.next = nullptr;
+                w.handle.resume();
+            }
+        }
+    };
+
+    inline void executor::waitAndDispatch()
+    {
+        m_pollfds.clear();
+        for(auto d : m_devices) {
+            if(d->hasWaiters()) {
+                m_pollfds.push_back(pollfd{ d->m_fd, POLLIN, 0 });
+            }
+        }
+        if(m_pollfds.empty() && m_timers.empty()) {
+            throw std::logic_error("All tasks are waiting, but nothing is left that could resume them.");
+        }
+        int timeout_milliseconds = -1;
+        if(!m_timers.empty()) {
+            auto const remaining = m_timers.begin()->first - clock::now();
+            auto const ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+            timeout_milliseconds = (ms <= 0) ? 0 : static_cast<int>(std::min<decltype(ms)>(ms, 1 << 30));
+        }
+        int const res = poll(m_pollfds.data(), m_pollfds.size(), timeout_milliseconds);
+        if((res < 0) && (errno != EINTR)) {
+            throw std::system_error(errno, std::generic_category(), "poll");
+        }
+        if(res > 0) {
+            // devices may be destroyed by the coroutines they resume, so look them up by file descriptor
+            for(auto const& pfd : m_pollfds) {
+                if(pfd.revents == 0) { continue; }
+                for(auto d : m_devices) {
+                    if(d->m_fd != pfd.fd) { continue; }
+                    if(pfd.revents & POLLIN) {
+                        d->onReadable();
+                    } else {
+                        d->fail();
+                    }
+                    break;
+                }
+            }
+        }
+        auto const now = clock::now();
+        while(!m_timers.empty() && (m_timers.begin()->first <= now)) {
+            timer const t = m_timers.begin()->second;
+            m_timers.erase(m_timers.begin());
+            t.on_expired(t.context);
+        }
+    }
+
+    inline void detail::onDetachedTaskDone(executor& exec, std::coroutine_handle<> handle,
+                                           std::exception_ptr exception)
+    {
+        exec.onTaskDone(handle, exception);
+    }
+}
+
+#endif
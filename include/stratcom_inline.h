@@ -0,0 +1,120 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/** @file
+ * Inline Accessors.
+ * This optional header provides inline versions of the input state accessors from stratcom.h.
+ * Unlike their exported counterparts, these can be inlined by the compiler into the calling code,
+ * reducing the cost of a query to a single load from memory.
+ *
+ * The inline accessors rely on the publicly documented layout of the stratcom_device struct,
+ * which is described by @ref stratcom_device_public. Clients that use this header should verify
+ * at startup that the library they are running against uses the same layout, by calling
+ * stratcom_inline_layout_matches().
+ */
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_INLINE_H_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_INLINE_H_
+
+#include <stratcom.h>
+
+#if defined __cplusplus || (defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L)
+#   define STRATCOM_INLINE static inline
+#elif defined _MSC_VER
+#   define STRATCOM_INLINE static __inline
+#elif defined __GNUC__
+#   define STRATCOM_INLINE static __inline__
+#else
+#   define STRATCOM_INLINE static
+#endif
+
+/** Version of the public device layout.
+ * This number is incremented each time the layout of @ref stratcom_device_public changes.
+ */
+#define STRATCOM_DEVICE_LAYOUT_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /** Public part of the stratcom_device struct.
+     * Every stratcom_device starts with this struct, that is, a pointer to a stratcom_device
+     * may be converted to a pointer to stratcom_device_public.
+     * The layout of this struct only changes together with @ref STRATCOM_DEVICE_LAYOUT_VERSION.
+     * The fields of this struct must be treated as read-only by clients.
+     */
+    typedef struct stratcom_device_public_ {
+        stratcom_input_state input_state;       /**< Internal input state, as returned by stratcom_get_input_state(). */
+    } stratcom_device_public;
+
+    /** Retrieve the public device layout version of the library.
+     * @return The value of @ref STRATCOM_DEVICE_LAYOUT_VERSION the library was compiled with.
+     */
+    LIBSTRATCOM_API int stratcom_get_device_layout_version();
+
+    /** Check whether the inline accessors of this header can be used with the library.
+     * @return 1 if the library uses the same device layout as this header, 0 otherwise.
+     */
+    STRATCOM_INLINE int stratcom_inline_layout_matches()
+    {
+        return (stratcom_get_device_layout_version() == STRATCOM_DEVICE_LAYOUT_VERSION) ? 1 : 0;
+    }
+
+    /** Inline version of stratcom_get_input_state().
+     */
+    STRATCOM_INLINE stratcom_input_state stratcom_get_input_state_inline(stratcom_device* device)
+    {
+        return ((stratcom_device_public const*)device)->input_state;
+    }
+
+    /** Inline version of stratcom_is_button_pressed().
+     */
+    STRATCOM_INLINE int stratcom_is_button_pressed_inline(stratcom_device* device, stratcom_button button)
+    {
+        return (((stratcom_device_public const*)device)->input_state.buttons & button);
+    }
+
+    /** Inline version of stratcom_get_axis_value().
+     */
+    STRATCOM_INLINE stratcom_axis_word stratcom_get_axis_value_inline(stratcom_device* device, stratcom_axis axis)
+    {
+        stratcom_input_state const* state = &((stratcom_device_public const*)device)->input_state;
+        switch(axis) {
+        case STRATCOM_AXIS_X: return state->axisX;
+        case STRATCOM_AXIS_Y: return state->axisY;
+        case STRATCOM_AXIS_Z: return state->axisZ;
+        default: break;
+        }
+        return 0;
+    }
+
+    /** Inline version of stratcom_get_slider_state().
+     */
+    STRATCOM_INLINE stratcom_slider_state stratcom_get_slider_state_inline(stratcom_device* device)
+    {
+        return ((stratcom_device_public const*)device)->input_state.slider;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
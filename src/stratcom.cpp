@@ -21,11 +21,49 @@
  *****************************************************************************/
 
 #include <stratcom.h>
+#include <stratcom_inline.h>
+
+#include "stratcom_allocator.hpp"
+#include "stratcom_calibration.hpp"
+#include "stratcom_debounce.hpp"
+#include "stratcom_dispatcher.hpp"
+#include "stratcom_gestures.hpp"
+#include "stratcom_keymap.hpp"
+#include "stratcom_latency.hpp"
+#include "stratcom_log.hpp"
+#include "stratcom_macro.hpp"
+#include "stratcom_merge.hpp"
+#include "stratcom_resampler.hpp"
+#include "stratcom_simulation.hpp"
+#include "stratcom_snapshot.hpp"
+#include "stratcom_state_diff.hpp"
+#include "stratcom_state_history.hpp"
+#include "stratcom_trace.hpp"
+#include "stratcom_velocity.hpp"
+#include "stratcom_wait.hpp"
 
 #include <hidapi.h>
 
+#ifdef LIBSTRATCOM_HIDRAW
+#   include <dirent.h>
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <poll.h>
+#   include <sys/ioctl.h>
+#   include <unistd.h>
+#   include <linux/hidraw.h>
+#   include <cstdio>
+#   include <string>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <new>
+#include <thread>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -35,6 +73,14 @@ namespace {
      */
     const unsigned short HID_VENDOR_ID  = 0x045e;
     const unsigned short HID_PRODUCT_ID = 0x0033;
+    /** Bits of the led state that make an LED blink. */
+    const unsigned short LED_BLINK_BITS = (STRATCOM_LEDBUTTON_ALL << 1);
+    /** Changes of the REC LED requested by the macro recorder. */
+    enum macro_led_change {
+        MACRO_LED_NONE,
+        MACRO_LED_BLINK,                                ///< recording was armed.
+        MACRO_LED_RESTORE                               ///< recording finished.
+    };
     /***/
 
     /** Generic RAII wrapper for hidapi resource handles.
@@ -114,29 +160,351 @@ namespace {
         std::uint8_t b5;
         std::uint8_t b6;
     };
+
+#ifdef LIBSTRATCOM_HIDRAW
+    /** Number of input reports that can be drained from a hidraw device in one go.
+     */
+    std::size_t const HIDRAW_REPORT_QUEUE_SIZE = 32;
+
+    /** An input report read from a hidraw device that has not been evaluated yet.
+     */
+    struct hidraw_queued_report {
+        input_report report;
+        int size;                                       ///< number of bytes returned by read().
+        stratcom_timestamp timestamp;                   ///< time at which the report was read.
+    };
+#endif
 }
 
 /** \internal Definition of the opaque stratcom_device_ struct.
+ * The public part of the struct is inherited from stratcom_device_public, which places it at the very
+ * beginning of the struct. Changing stratcom_device_public requires incrementing
+ * STRATCOM_DEVICE_LAYOUT_VERSION, as clients may access it directly through stratcom_inline.h.
  */
-struct stratcom_device_ {
-    hid_device_wrapper device;                          ///< underlying hidapi device.
+struct stratcom_device_ : public stratcom_device_public {
+    hid_device_wrapper device;                          ///< underlying hidapi device. NULL for hidraw and
+                                                        ///  simulated devices.
+    stratcom_internal::allocated_ptr<stratcom_internal::simulated_device> simulated;    ///< backend of a
+                                                                                        ///  simulated device.
+#ifdef LIBSTRATCOM_HIDRAW
+    int hidraw_fd;                                      ///< hidraw device file descriptor. -1 for hidapi devices.
+    hidraw_queued_report hidraw_queue[HIDRAW_REPORT_QUEUE_SIZE];    ///< reports drained from the hidraw device.
+    std::size_t hidraw_queue_front;                     ///< index of the next report in hidraw_queue.
+    std::size_t hidraw_queue_size;                      ///< number of reports in hidraw_queue.
+#endif
     std::uint16_t led_button_state;                     ///< cached state of the device leds.
     struct blink_state_T {
         std::uint8_t on_time;
         std::uint8_t off_time;
     } blink_state;                                      ///< cached state of the device led blink state.
     bool led_button_state_has_unflushed_changes;        ///< true if the cached led state has unflushed changes.
-    stratcom_input_state input_state;                   ///< device input state obtained by read_input* functions.
+    bool blink_state_has_unflushed_changes;             ///< true if the cached blink state has to be sent along
+                                                        ///  with the next led state that makes an LED blink.
+    std::uint64_t last_report;                          ///< packed copy of the last processed input report.
+    bool has_last_report;                               ///< true if last_report holds a valid input report.
+    stratcom_timestamp input_timestamp;                 ///< arrival time of the last processed input report.
+    stratcom_read_statistics read_statistics;           ///< sequence and drop detection counters.
+    bool resync_mode;                                   ///< true if resync events are generated after a loss.
+    bool resync_pending;                                ///< true if a loss was detected and resync events are due.
+    stratcom_internal::allocated_ptr<stratcom_internal::input_resampler> resampler;  ///< resampler; NULL if
+                                                                                     ///  resampling is disabled.
+    stratcom_internal::allocated_ptr<stratcom_internal::axis_calibration> calibration;   ///< axis lookup tables;
+                                                                                         ///  NULL if no axis
+                                                                                         ///  is calibrated.
+    stratcom_internal::axis_velocity_estimator axis_velocity[3];                         ///< indexed by
+                                                                                         ///  stratcom_axis.
+    stratcom_internal::allocated_ptr<stratcom_internal::macro_recorder> macros;  ///< NULL if macros are disabled.
+    stratcom_led_state macro_led_state;                 ///< state of the REC LED before recording started.
+    std::atomic<int> macro_led_request;                 ///< macro_led_change set by the reading thread
+                                                        ///  and applied by the next LED flush.
+    bool macro_led_blinking;                            ///< true while the REC LED blinks for a recording and
+                                                        ///  macro_led_state holds its previous state.
+    bool macro_led_unflushed;                           ///< true if the macros changed the REC LED since the
+                                                        ///  last successful flush.
+    stratcom_internal::allocated_ptr<stratcom_internal::button_debouncer> debouncer;     ///< NULL if no button
+                                                                                         ///  is debounced.
+    stratcom_internal::keymap_binding keymap;           ///< keymap and the actions of the keys.
+    stratcom_internal::allocated_ptr<stratcom_internal::input_waiter> waiter;   ///< state of
+                                                                                 ///  stratcom_wait_input().
+    stratcom_internal::allocated_ptr<stratcom_internal::led_latency_tracker> led_latency;    ///< NULL if LED
+                                                                                            ///  latency is not
+                                                                                            ///  measured.
+    stratcom_internal::allocator allocator;             ///< allocator for the resources of this device.
 
     stratcom_device_(hid_device* dev)
         :device(dev), led_button_state(0), led_button_state_has_unflushed_changes(true)
+    {
+        init();
+    }
+
+#ifdef LIBSTRATCOM_HIDRAW
+    stratcom_device_(int fd)
+        :led_button_state(0), led_button_state_has_unflushed_changes(true)
+    {
+        init();
+        hidraw_fd = fd;
+    }
+#endif
+
+    ~stratcom_device_()
+    {
+#ifdef LIBSTRATCOM_HIDRAW
+        if(hidraw_fd >= 0) { close(hidraw_fd); }
+#endif
+    }
+
+private:
+    void init()
     {
         std::memset(&input_state, 0, sizeof(input_state));
         blink_state.on_time = 0;
         blink_state.off_time = 0;
+        blink_state_has_unflushed_changes = false;
+        last_report = 0;
+        has_last_report = false;
+        input_timestamp = 0;
+        std::memset(&read_statistics, 0, sizeof(read_statistics));
+        resync_mode = false;
+        resync_pending = false;
+        macro_led_state = STRATCOM_LED_OFF;
+        macro_led_request.store(MACRO_LED_NONE);
+        macro_led_blinking = false;
+        macro_led_unflushed = false;
+        allocator = stratcom_internal::getGlobalAllocator();
+#ifdef LIBSTRATCOM_HIDRAW
+        hidraw_fd = -1;
+        hidraw_queue_front = 0;
+        hidraw_queue_size = 0;
+#endif
     }
+
+    stratcom_device_(stratcom_device_ const&);              // = delete
+    stratcom_device_& operator=(stratcom_device_ const&);   // = delete
 };
 
+// stratcom_inline.h reads the public part through a pointer to the device. stratcom_device_ is not standard
+// layout, so offsetof is only conditionally supported for it; all supported compilers implement it.
+#if defined __GNUC__
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+static_assert(offsetof(stratcom_device_, input_state) == 0,
+              "stratcom_device_public must be at the beginning of stratcom_device_");
+#if defined __GNUC__
+#   pragma GCC diagnostic pop
+#endif
+
+namespace {
+    /** \internal
+     * Device I/O.
+     * All communication with the physical device goes through the following functions, which dispatch
+     * to either the hidraw backend or hidapi, depending on how the device was opened.
+     */
+#ifdef LIBSTRATCOM_HIDRAW
+    /** Size of the buffers for paths below /sys/class/hidraw and /dev.
+     */
+    std::size_t const HIDRAW_PATH_SIZE = 512;
+
+    /** Find the hidraw device node of the first attached Strategic Commander.
+     * This scans sysfs directly instead of going through udev. Paths are built in fixed buffers,
+     * so that no memory is allocated outside of the allocator hooks.
+     * @param[out] out_path Receives the path to the device node (e.g. /dev/hidraw0) on success.
+     * @return true if a device was found.
+     */
+    bool hidraw_find_device(char (&out_path)[HIDRAW_PATH_SIZE])
+    {
+        DIR* dir = opendir("/sys/class/hidraw");
+        if(!dir) { return false; }
+        int best_index = -1;
+        while(struct dirent* entry = readdir(dir)) {
+            int index;
+            if(std::sscanf(entry->d_name, "hidraw%d", &index) != 1) { continue; }
+            if((best_index != -1) && (index > best_index)) { continue; }
+            char uevent_path[HIDRAW_PATH_SIZE];
+            int const length = std::snprintf(uevent_path, sizeof(uevent_path), "/sys/class/hidraw/%s/device/uevent",
+                                             entry->d_name);
+            if((length < 0) || (static_cast<std::size_t>(length) >= sizeof(uevent_path))) { continue; }
+            std::FILE* uevent = std::fopen(uevent_path, "r");
+            if(!uevent) { continue; }
+            char line[256];
+            while(std::fgets(line, sizeof(line), uevent)) {
+                unsigned int bus, vendor, product;
+                if((std::sscanf(line, "HID_ID=%x:%x:%x", &bus, &vendor, &product) == 3) &&
+                   (vendor == HID_VENDOR_ID) && (product == HID_PRODUCT_ID))
+                {
+                    best_index = index;
+                    break;
+                }
+            }
+            std::fclose(uevent);
+        }
+        closedir(dir);
+        if(best_index == -1) { return false; }
+        std::snprintf(out_path, HIDRAW_PATH_SIZE, "/dev/hidraw%d", best_index);
+        return true;
+    }
+
+    /** Open a hidraw device node.
+     * @return File descriptor on success, -1 if the path does not refer to a hidraw device node or
+     *         could not be opened.
+     */
+    int hidraw_open(char const* device_path)
+    {
+        if(std::strncmp(device_path, "/dev/hidraw", 11) != 0) { return -1; }
+        return open(device_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    }
+
+    /** Read all input reports that are currently queued by the kernel into the device's report queue.
+     * @return Number of reports in the queue after draining; -1 on error with an empty queue.
+     */
+    int hidraw_drain_reports(stratcom_device* device)
+    {
+        unsigned char buffer[64];
+        stratcom_timestamp const timestamp = stratcom_get_timestamp();
+        while(device->hidraw_queue_size < HIDRAW_REPORT_QUEUE_SIZE) {
+            ssize_t const res = read(device->hidraw_fd, buffer, sizeof(buffer));
+            if(res < 0) {
+                if(errno == EINTR) { continue; }
+                if((errno == EAGAIN) || (errno == EWOULDBLOCK)) { break; }
+                return (device->hidraw_queue_size == 0) ? -1 : static_cast<int>(device->hidraw_queue_size);
+            }
+            std::size_t const back = (device->hidraw_queue_front + device->hidraw_queue_size) % HIDRAW_REPORT_QUEUE_SIZE;
+            hidraw_queued_report& queued = device->hidraw_queue[back];
+            std::memcpy(&queued.report, buffer, std::min(sizeof(input_report), static_cast<std::size_t>(res)));
+            queued.size = static_cast<int>(res);
+            queued.timestamp = timestamp;
+            ++device->hidraw_queue_size;
+        }
+        return static_cast<int>(device->hidraw_queue_size);
+    }
+
+    int hidraw_read_report(stratcom_device* device, input_report& report, int timeout_milliseconds,
+                           stratcom_timestamp& out_timestamp)
+    {
+        while(device->hidraw_queue_size == 0) {
+            struct pollfd pfd;
+            pfd.fd = device->hidraw_fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            int const res = poll(&pfd, 1, timeout_milliseconds);
+            if(res < 0) {
+                if(errno == EINTR) { continue; }
+                return -1;
+            }
+            if(res == 0) { return 0; }
+            if(pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) { return -1; }
+            if(hidraw_drain_reports(device) < 0) { return -1; }
+            if((device->hidraw_queue_size == 0) && (timeout_milliseconds >= 0)) { return 0; }
+        }
+        hidraw_queued_report const& queued = device->hidraw_queue[device->hidraw_queue_front];
+        report = queued.report;
+        out_timestamp = queued.timestamp;
+        device->hidraw_queue_front = (device->hidraw_queue_front + 1) % HIDRAW_REPORT_QUEUE_SIZE;
+        --device->hidraw_queue_size;
+        return queued.size;
+    }
+#endif
+
+    /** Read a single input report from the device.
+     * @param[in] timeout_milliseconds Time to wait for a report. -1 blocks indefinitely, 0 returns immediately.
+     * @param[out] out_timestamp Arrival time of the report.
+     * @return Number of bytes read, 0 if no report was available within the timeout, -1 on error.
+     */
+    int device_read_report(stratcom_device* device, input_report& report, int timeout_milliseconds,
+                           stratcom_timestamp& out_timestamp)
+    {
+        STRATCOM_TRACE_SCOPE("device_read_report");
+        if(device->simulated) {
+            return device->simulated->readReport(&report.b0, sizeof(report), timeout_milliseconds, out_timestamp);
+        }
+#ifdef LIBSTRATCOM_HIDRAW
+        if(device->hidraw_fd >= 0) {
+            return hidraw_read_report(device, report, timeout_milliseconds, out_timestamp);
+        }
+#endif
+        int res;
+        if(timeout_milliseconds < 0) {
+            hid_set_nonblocking(device->device, false);
+            res = hid_read(device->device, &report.b0, sizeof(report));
+        } else if(timeout_milliseconds == 0) {
+            hid_set_nonblocking(device->device, true);
+            res = hid_read(device->device, &report.b0, sizeof(report));
+        } else {
+            hid_set_nonblocking(device->device, false);
+            res = hid_read_timeout(device->device, &report.b0, sizeof(report), timeout_milliseconds);
+        }
+        out_timestamp = stratcom_get_timestamp();
+        return res;
+    }
+
+    /** Send a feature report to the device.
+     * @return Number of bytes sent, -1 on error.
+     */
+    int device_send_feature_report(stratcom_device* device, feature_report const& report)
+    {
+        STRATCOM_TRACE_SCOPE("device_send_feature_report");
+        if(device->simulated) {
+            return device->simulated->sendFeatureReport(&report.b0, sizeof(report));
+        }
+#ifdef LIBSTRATCOM_HIDRAW
+        if(device->hidraw_fd >= 0) {
+            return ioctl(device->hidraw_fd, HIDIOCSFEATURE(sizeof(report)), &report);
+        }
+#endif
+        return hid_send_feature_report(device->device, &report.b0, sizeof(report));
+    }
+
+    /** Read a feature report from the device.
+     * The report id must be set in the b0 field of report before calling this function.
+     * @return Number of bytes read, -1 on error.
+     */
+    int device_get_feature_report(stratcom_device* device, feature_report& report)
+    {
+        STRATCOM_TRACE_SCOPE("device_get_feature_report");
+        if(device->simulated) {
+            return device->simulated->getFeatureReport(&report.b0, sizeof(report));
+        }
+#ifdef LIBSTRATCOM_HIDRAW
+        if(device->hidraw_fd >= 0) {
+            return ioctl(device->hidraw_fd, HIDIOCGFEATURE(sizeof(report)), &report);
+        }
+#endif
+        return hid_get_feature_report(device->device, &report.b0, sizeof(report));
+    }
+}
+
+
+stratcom_return stratcom_enable_tracing(int enabled)
+{
+#ifdef LIBSTRATCOM_TRACING
+    stratcom_internal::g_trace_enabled.store(enabled != 0, std::memory_order_relaxed);
+    return STRATCOM_RET_SUCCESS;
+#else
+    (void)enabled;
+    return STRATCOM_RET_ERROR;
+#endif
+}
+
+stratcom_return stratcom_export_trace(char const* filename)
+{
+#ifdef LIBSTRATCOM_TRACING
+    return stratcom_internal::traceExport(filename) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+#else
+    (void)filename;
+    return STRATCOM_RET_ERROR;
+#endif
+}
+
+stratcom_timestamp stratcom_get_timestamp()
+{
+    return static_cast<stratcom_timestamp>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+int stratcom_get_device_layout_version()
+{
+    return STRATCOM_DEVICE_LAYOUT_VERSION;
+}
 
 stratcom_return stratcom_init()
 {
@@ -148,33 +516,193 @@ void stratcom_shutdown()
     hid_exit();
 }
 
-stratcom_device* stratcom_open_device()
+void stratcom_set_allocator(stratcom_alloc_fn alloc_fn, stratcom_free_fn free_fn, void* user_data)
 {
-    hid_device_info_wrapper dev_info_list(hid_enumerate(HID_VENDOR_ID, HID_PRODUCT_ID));
-    stratcom_device* ret = nullptr;
-    if(dev_info_list) {
-        ret = stratcom_open_device_on_path(dev_info_list->path);
+    stratcom_internal::setGlobalAllocator(alloc_fn, free_fn, user_data);
+}
+
+namespace {
+    /** Allocate the resources that every device needs, so that reading input never has to allocate.
+     * @return false if an allocation failed.
+     */
+    bool allocateDeviceResources(stratcom_device* device)
+    {
+        device->waiter.reset(stratcom_internal::create<stratcom_internal::input_waiter>(device->allocator));
+        return static_cast<bool>(device->waiter);
     }
-    return ret;
+
+    /** Open the device on a path.
+     * @param[in] read_led_state If true, the led state and blink intervals are read from the device.
+     */
+    stratcom_device* openDeviceOnPath(char const* device_path, bool read_led_state)
+    {
+#ifdef LIBSTRATCOM_HIDRAW
+        int const fd = hidraw_open(device_path);
+        if(fd >= 0) {
+            auto ret = stratcom_internal::create<stratcom_device>(stratcom_internal::getGlobalAllocator(), fd);
+            if(ret) {
+                if(!allocateDeviceResources(ret)) {
+                    stratcom_internal::destroy(ret);
+                    return nullptr;
+                }
+                if(read_led_state) {
+                    stratcom_read_button_led_state(ret);
+                    stratcom_read_led_blink_intervals(ret);
+                }
+            } else {
+                close(fd);
+            }
+            return ret;
+        }
+#endif
+        auto dev = hid_open_path(device_path);
+        if (dev) {
+            auto ret = stratcom_internal::create<stratcom_device>(stratcom_internal::getGlobalAllocator(), dev);
+            if(ret && !allocateDeviceResources(ret)) {
+                stratcom_internal::destroy(ret);
+                return nullptr;
+            }
+            if(ret && read_led_state) {
+                stratcom_read_button_led_state(ret);
+                stratcom_read_led_blink_intervals(ret);
+            }
+            return ret;
+        }
+        return nullptr;
+    }
+
+    /** Open the first Strategic Commander found.
+     * @param[in] read_led_state If true, the led state and blink intervals are read from the device.
+     */
+    stratcom_device* openFirstDevice(bool read_led_state)
+    {
+#ifdef LIBSTRATCOM_HIDRAW
+        char hidraw_path[HIDRAW_PATH_SIZE];
+        if(hidraw_find_device(hidraw_path)) {
+            stratcom_device* ret = openDeviceOnPath(hidraw_path, read_led_state);
+            if(ret) { return ret; }
+        }
+#endif
+        hid_device_info_wrapper dev_info_list(hid_enumerate(HID_VENDOR_ID, HID_PRODUCT_ID));
+        stratcom_device* ret = nullptr;
+        if(dev_info_list) {
+            ret = openDeviceOnPath(dev_info_list->path, read_led_state);
+        }
+        return ret;
+    }
+
+    /** Capture the state of a device that is saved by stratcom_save_device_state().
+     */
+    void captureDeviceSnapshot(stratcom_device const& device, stratcom_internal::device_snapshot& snapshot)
+    {
+        snapshot.led_button_state = device.led_button_state;
+        snapshot.blink_on_time = device.blink_state.on_time;
+        snapshot.blink_off_time = device.blink_state.off_time;
+        snapshot.resync_mode = device.resync_mode;
+        for(int i = 0; i < 3; ++i) {
+            snapshot.is_calibrated[i] = device.calibration && device.calibration->getCalibration(i,
+                                                                                              snapshot.calibration[i]);
+            snapshot.velocity_smoothing[i] = device.axis_velocity[i].getSmoothingTime();
+        }
+        for(unsigned i = 0; i < stratcom_internal::device_snapshot::NUMBER_OF_BUTTONS; ++i) {
+            snapshot.debounce_window[i] = device.debouncer ? device.debouncer->getWindow(i) : 0;
+        }
+    }
+
+    /** Apply a snapshot to a device.
+     * The led state is flushed with a single feature report. The blink intervals are only sent along if an LED
+     * is blinking; otherwise they are deferred until an LED is set to blink.
+     * @param[in] blink_state_known True if the cached blink intervals match the physical device.
+     */
+    stratcom_return applyDeviceSnapshot(stratcom_device* device, stratcom_internal::device_snapshot const& snapshot,
+                                        bool blink_state_known)
+    {
+        stratcom_set_resync_mode(device, snapshot.resync_mode ? 1 : 0);
+        for(int i = 0; i < 3; ++i) {
+            auto const axis = static_cast<stratcom_axis>(i);
+            if(stratcom_set_axis_calibration(device, axis, snapshot.is_calibrated[i] ? &snapshot.calibration[i] :
+                                                                                      nullptr) != STRATCOM_RET_SUCCESS)
+            {
+                return STRATCOM_RET_ERROR;
+            }
+            if(device->axis_velocity[i].getSmoothingTime() != snapshot.velocity_smoothing[i]) {
+                device->axis_velocity[i].setSmoothingTime(snapshot.velocity_smoothing[i]);
+            }
+        }
+        for(unsigned i = 0; i < stratcom_internal::device_snapshot::NUMBER_OF_BUTTONS; ++i) {
+            auto const button = static_cast<stratcom_button_word>(1u << i);
+            if(stratcom_set_debounce_window(device, button, snapshot.debounce_window[i]) != STRATCOM_RET_SUCCESS) {
+                return STRATCOM_RET_ERROR;
+            }
+        }
+        if(!blink_state_known || (device->blink_state.on_time != snapshot.blink_on_time) ||
+           (device->blink_state.off_time != snapshot.blink_off_time))
+        {
+            device->blink_state.on_time = snapshot.blink_on_time;
+            device->blink_state.off_time = snapshot.blink_off_time;
+            device->blink_state_has_unflushed_changes = true;
+        }
+        device->led_button_state = snapshot.led_button_state;
+        device->led_button_state_has_unflushed_changes = true;
+        return stratcom_flush_button_led_state(device);
+    }
+}
+
+stratcom_device* stratcom_open_device()
+{
+    return openFirstDevice(true);
 }
 
 stratcom_device* stratcom_open_device_on_path(char const* device_path)
 {
-    auto dev = hid_open_path(device_path);
-    if (dev) {
-        auto ret = new (std::nothrow) stratcom_device(dev);
-        if(ret) {
-            stratcom_read_button_led_state(ret);
-            stratcom_read_led_blink_intervals(ret);
-        }
-        return ret;
+    return openDeviceOnPath(device_path, true);
+}
+
+stratcom_device* stratcom_open_device_with_state(char const* device_path, void const* state, size_t state_size)
+{
+    stratcom_internal::device_snapshot snapshot;
+    if(!stratcom_internal::readSnapshot(state, state_size, snapshot)) {
+        return nullptr;
     }
-    return nullptr;
+    stratcom_internal::allocated_ptr<stratcom_device> ret(device_path ? openDeviceOnPath(device_path, false) :
+                                                                        openFirstDevice(false));
+    if(!ret || (applyDeviceSnapshot(ret.get(), snapshot, false) != STRATCOM_RET_SUCCESS)) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+size_t stratcom_save_device_state(stratcom_device* device, void* buffer, size_t buffer_size)
+{
+    stratcom_internal::device_snapshot snapshot;
+    captureDeviceSnapshot(*device, snapshot);
+    return stratcom_internal::writeSnapshot(snapshot, buffer, buffer_size);
+}
+
+stratcom_return stratcom_restore_device_state(stratcom_device* device, void const* state, size_t state_size)
+{
+    stratcom_internal::device_snapshot snapshot;
+    if(!stratcom_internal::readSnapshot(state, state_size, snapshot)) {
+        return STRATCOM_RET_ERROR;
+    }
+    return applyDeviceSnapshot(device, snapshot, true);
 }
 
 void stratcom_close_device(stratcom_device* device)
 {
-    delete device;
+    stratcom_internal::destroy(device);
+}
+
+void stratcom_set_device_allocator(stratcom_device* device, stratcom_alloc_fn alloc_fn,
+                                   stratcom_free_fn free_fn, void* user_data)
+{
+    if(alloc_fn && free_fn) {
+        device->allocator.alloc_fn = alloc_fn;
+        device->allocator.free_fn = free_fn;
+        device->allocator.user_data = user_data;
+    } else {
+        device->allocator = stratcom_internal::getGlobalAllocator();
+    }
 }
 
 stratcom_led_state stratcom_get_button_led_state(stratcom_device* device,
@@ -219,8 +747,37 @@ void stratcom_set_button_led_state_without_flushing(stratcom_device* device,
     device->led_button_state_has_unflushed_changes = true;
 }
 
+namespace {
+    /** Apply the REC LED change last requested by the macro recorder to the internal LED state.
+     * The reading thread only records the request, so that decoding input never sends feature reports
+     * and never touches the LED state, which belongs to the thread flushing the LEDs.
+     */
+    void applyMacroLedRequest(stratcom_device* device)
+    {
+        switch(device->macro_led_request.exchange(MACRO_LED_NONE)) {
+        case MACRO_LED_BLINK:
+            if(!device->macro_led_blinking) {
+                device->macro_led_state = stratcom_get_button_led_state(device, STRATCOM_LEDBUTTON_REC);
+                stratcom_set_button_led_state_without_flushing(device, STRATCOM_LEDBUTTON_REC, STRATCOM_LED_BLINK);
+                device->macro_led_blinking = true;
+                device->macro_led_unflushed = true;
+            }
+            break;
+        case MACRO_LED_RESTORE:
+            if(device->macro_led_blinking) {
+                stratcom_set_button_led_state_without_flushing(device, STRATCOM_LEDBUTTON_REC,
+                                                               device->macro_led_state);
+                device->macro_led_blinking = false;
+                device->macro_led_unflushed = true;
+            }
+            break;
+        }
+    }
+}
+
 stratcom_return stratcom_flush_button_led_state(stratcom_device* device)
 {
+    STRATCOM_TRACE_SCOPE("flush_button_led_state");
     /** \internal
      * LEDs are set by sending a feature report of the following form:
      * b0 = 0x01
@@ -233,20 +790,36 @@ stratcom_return stratcom_flush_button_led_state(stratcom_device* device)
      * bitmask send to the device.
      * Values of the stratcom_button_led enum correspond to the bitmasks for LED On bits in led_button_state.
      */
+    applyMacroLedRequest(device);
+    if(device->blink_state_has_unflushed_changes && ((device->led_button_state & LED_BLINK_BITS) != 0)) {
+        if(stratcom_set_led_blink_interval(device, device->blink_state.on_time, device->blink_state.off_time) !=
+           STRATCOM_RET_SUCCESS)
+        {
+            return STRATCOM_RET_ERROR;
+        }
+    }
     feature_report report;
     report.b0 = 0x01;
     report.b1 = (device->led_button_state & 0xff);
     report.b2 = ((device->led_button_state >> 8) & 0xff);
-    if(hid_send_feature_report(device->device, &report.b0, sizeof(report)) != sizeof(report)) {
+    if(device_send_feature_report(device, report) != sizeof(report)) {
         return STRATCOM_RET_ERROR;
     }
+    if(device->led_latency) {
+        // the REC LED blinking for a macro recording is not feedback given by the application
+        auto const rec_mask = static_cast<std::uint16_t>(STRATCOM_LEDBUTTON_REC | (STRATCOM_LEDBUTTON_REC << 1));
+        device->led_latency->onLedStateFlushed(device->led_button_state,
+                                               device->macro_led_unflushed ? rec_mask : 0,
+                                               stratcom_get_timestamp());
+    }
+    device->macro_led_unflushed = false;
     device->led_button_state_has_unflushed_changes = false;
     return STRATCOM_RET_SUCCESS;
 }
 
 int stratcom_led_state_has_unflushed_changes(stratcom_device* device)
 {
-    return device->led_button_state_has_unflushed_changes;
+    return device->led_button_state_has_unflushed_changes || (device->macro_led_request.load() != MACRO_LED_NONE);
 }
 
 void stratcom_get_led_blink_interval(stratcom_device* device,
@@ -269,9 +842,12 @@ stratcom_return stratcom_set_led_blink_interval(stratcom_device* device, uint8_t
     report.b0 = 0x02;
     report.b1 = on_time;
     report.b2 = off_time;
-    if(hid_send_feature_report(device->device, &report.b0, sizeof(report)) != sizeof(report)) {
+    if(device_send_feature_report(device, report) != sizeof(report)) {
         return STRATCOM_RET_ERROR;
     }
+    device->blink_state.on_time = on_time;
+    device->blink_state.off_time = off_time;
+    device->blink_state_has_unflushed_changes = false;
     return STRATCOM_RET_SUCCESS;
 }
 
@@ -279,7 +855,7 @@ stratcom_return stratcom_read_button_led_state(stratcom_device* device)
 {
     feature_report rep;
     rep.b0 = 0x01;
-    int const res = hid_get_feature_report(device->device, reinterpret_cast<unsigned char*>(&rep), sizeof(rep));
+    int const res = device_get_feature_report(device, rep);
     if(res != sizeof(rep)) {
         return STRATCOM_RET_ERROR;
     }
@@ -293,12 +869,13 @@ stratcom_return stratcom_read_led_blink_intervals(stratcom_device* device)
 {
     feature_report rep;
     rep.b0 = 0x02;
-    int const res = hid_get_feature_report(device->device, reinterpret_cast<unsigned char*>(&rep), sizeof(rep));
+    int const res = device_get_feature_report(device, rep);
     if(res != sizeof(rep)) {
         return STRATCOM_RET_ERROR;
     }
     device->blink_state.on_time = rep.b1;
     device->blink_state.off_time = rep.b2;
+    device->blink_state_has_unflushed_changes = false;
     return STRATCOM_RET_SUCCESS;
 }
 
@@ -317,14 +894,249 @@ stratcom_button_led stratcom_get_led_for_button(stratcom_button button)
     return STRATCOM_LEDBUTTON_NONE;
 }
 
+stratcom_return stratcom_enable_led_latency_measurement(stratcom_device* device, int enabled)
+{
+    if(!enabled) {
+        device->led_latency.reset();
+        return STRATCOM_RET_SUCCESS;
+    }
+    device->led_latency.reset(stratcom_internal::create<stratcom_internal::led_latency_tracker>(
+        device->allocator, device->led_button_state));
+    return device->led_latency ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_get_led_latency_histogram(stratcom_device* device,
+                                                   stratcom_latency_histogram* out_histogram)
+{
+    if(!device->led_latency) {
+        return STRATCOM_RET_ERROR;
+    }
+    device->led_latency->getHistogram(*out_histogram);
+    return STRATCOM_RET_SUCCESS;
+}
+
+void stratcom_reset_led_latency_histogram(stratcom_device* device)
+{
+    if(device->led_latency) {
+        device->led_latency->resetHistogram();
+    }
+}
+
+/** \internal Changes staged for a single device in an LED transaction.
+ */
+struct led_transaction_entry {
+    stratcom_device* device;
+    std::uint16_t led_mask;                             ///< bits of led_button_state that are changed.
+    std::uint16_t led_bits;                             ///< new values for the bits in led_mask.
+    bool has_blink_interval;
+    stratcom_device_::blink_state_T blink_interval;
+    stratcom_return result;
+};
+
+struct stratcom_led_transaction_ {
+    std::vector<led_transaction_entry, stratcom_internal::std_allocator<led_transaction_entry>> entries;
+                                                        ///< one entry per device, in staging order.
+
+    explicit stratcom_led_transaction_(stratcom_internal::allocator const& alloc)
+        :entries(stratcom_internal::std_allocator<led_transaction_entry>(alloc))
+    {}
+};
+
 namespace {
-    stratcom_return evaluateInputReport(input_report const& report, stratcom_input_state& input_state)
+    led_transaction_entry* findLedTransactionEntry(stratcom_led_transaction* transaction, stratcom_device* device)
     {
-        if(report.b0 != 0x01)
-        {
-            return STRATCOM_RET_ERROR;
+        for(auto& e : transaction->entries) {
+            if(e.device == device) { return &e; }
+        }
+        led_transaction_entry e;
+        e.device = device;
+        e.led_mask = 0;
+        e.led_bits = 0;
+        e.has_blink_interval = false;
+        e.blink_interval.on_time = 0;
+        e.blink_interval.off_time = 0;
+        e.result = STRATCOM_RET_ERROR;
+        try {
+            transaction->entries.push_back(e);
+        } catch(std::bad_alloc&) {
+            return nullptr;
+        }
+        return &transaction->entries.back();
+    }
+
+    void commitLedTransactionEntry(led_transaction_entry& e)
+    {
+        STRATCOM_TRACE_SCOPE("commit_led_transaction_device");
+        stratcom_device* device = e.device;
+        bool success = true;
+        if(e.has_blink_interval) {
+            // the flush sends the interval ahead of an LED state that makes an LED blink
+            device->blink_state = e.blink_interval;
+            device->blink_state_has_unflushed_changes = true;
+        }
+        if((e.led_mask != 0) || (device->macro_led_request.load() != MACRO_LED_NONE)) {
+            device->led_button_state = static_cast<std::uint16_t>((device->led_button_state & ~e.led_mask) |
+                                                                  e.led_bits);
+            device->led_button_state_has_unflushed_changes = true;
+            success = (stratcom_flush_button_led_state(device) == STRATCOM_RET_SUCCESS);
+        }
+        if(success && e.has_blink_interval && device->blink_state_has_unflushed_changes) {
+            // no LED blinks, so the flush did not send the staged interval
+            success = (stratcom_set_led_blink_interval(device, e.blink_interval.on_time,
+                                                       e.blink_interval.off_time) == STRATCOM_RET_SUCCESS);
         }
+        e.result = success ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+    }
+}
+
+stratcom_led_transaction* stratcom_begin_led_transaction()
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    return stratcom_internal::create<stratcom_led_transaction>(alloc, alloc);
+}
+
+stratcom_return stratcom_led_transaction_set_button_led_state(stratcom_led_transaction* transaction,
+                                                              stratcom_device* device,
+                                                              stratcom_button_led led,
+                                                              stratcom_led_state state)
+{
+    led_transaction_entry* e = findLedTransactionEntry(transaction, device);
+    if(!e) {
+        return STRATCOM_RET_ERROR;
+    }
+    // see stratcom_set_button_led_state_without_flushing() for the meaning of the bits
+    auto const button_mask = static_cast<std::uint16_t>(led);
+    auto const mask = static_cast<std::uint16_t>(button_mask | (button_mask << 1));
+    std::uint16_t bits = 0;
+    switch(state) {
+    case STRATCOM_LED_BLINK: bits = static_cast<std::uint16_t>(button_mask << 1); break;
+    case STRATCOM_LED_ON:    bits = button_mask; break;
+    case STRATCOM_LED_OFF:   bits = 0; break;
+    }
+    e->led_mask |= mask;
+    e->led_bits = static_cast<std::uint16_t>((e->led_bits & ~mask) | bits);
+    return STRATCOM_RET_SUCCESS;
+}
+
+stratcom_return stratcom_led_transaction_set_blink_interval(stratcom_led_transaction* transaction,
+                                                            stratcom_device* device,
+                                                            uint8_t on_time, uint8_t off_time)
+{
+    led_transaction_entry* e = findLedTransactionEntry(transaction, device);
+    if(!e) {
+        return STRATCOM_RET_ERROR;
+    }
+    e->has_blink_interval = true;
+    e->blink_interval.on_time = on_time;
+    e->blink_interval.off_time = off_time;
+    return STRATCOM_RET_SUCCESS;
+}
+
+uint32_t stratcom_led_transaction_get_device_count(stratcom_led_transaction* transaction)
+{
+    return static_cast<uint32_t>(transaction->entries.size());
+}
+
+stratcom_return stratcom_commit_led_transaction(stratcom_led_transaction* transaction,
+                                                stratcom_led_transaction_result* out_results)
+{
+    STRATCOM_TRACE_SCOPE("commit_led_transaction");
+    auto& entries = transaction->entries;
+    if(entries.empty()) {
+        return STRATCOM_RET_SUCCESS;
+    }
+    // the calling thread commits the first device; every other device gets a worker thread.
+    // if threads cannot be started, the remaining devices are committed serially.
+    std::vector<std::thread, stratcom_internal::std_allocator<std::thread>> workers(
+        stratcom_internal::std_allocator<std::thread>(stratcom_internal::getAllocatorOf(transaction)));
+    try {
+        workers.reserve(entries.size() - 1);
+        for(std::size_t i = 1; i < entries.size(); ++i) {
+            workers.emplace_back(commitLedTransactionEntry, std::ref(entries[i]));
+        }
+    } catch(std::exception&) {}
+    commitLedTransactionEntry(entries[0]);
+    for(std::size_t i = workers.size() + 1; i < entries.size(); ++i) {
+        commitLedTransactionEntry(entries[i]);
+    }
+    for(auto& w : workers) {
+        w.join();
+    }
+
+    stratcom_return ret = STRATCOM_RET_SUCCESS;
+    for(std::size_t i = 0; i < entries.size(); ++i) {
+        if(entries[i].result != STRATCOM_RET_SUCCESS) {
+            ret = STRATCOM_RET_ERROR;
+        }
+        if(out_results) {
+            out_results[i].device = entries[i].device;
+            out_results[i].result = entries[i].result;
+        }
+    }
+    return ret;
+}
+
+void stratcom_free_led_transaction(stratcom_led_transaction* transaction)
+{
+    stratcom_internal::destroy(transaction);
+}
+
+namespace {
+    /** \internal
+     * Input state fields.
+     * Used for marking which parts of an input state are affected by an input report.
+     */
+    enum input_field {
+        INPUT_FIELD_BUTTONS = 0x01,
+        INPUT_FIELD_AXIS_X  = 0x02,
+        INPUT_FIELD_AXIS_Y  = 0x04,
+        INPUT_FIELD_AXIS_Z  = 0x08,
+        INPUT_FIELD_SLIDER  = 0x10,
+        INPUT_FIELD_ALL     = 0x1f
+    };
+
+    /** \internal
+     * Bits of a packed input report (see packInputReport()) that carry the data for each input field.
+     * See evaluateInputReport() for a description of the report layout.
+     */
+    std::uint64_t const REPORT_BITS_AXIS_X  = 0x000000000003ff00ull;
+    std::uint64_t const REPORT_BITS_AXIS_Y  = 0x000000000ffc0000ull;
+    std::uint64_t const REPORT_BITS_AXIS_Z  = 0x0000003ff0000000ull;
+    std::uint64_t const REPORT_BITS_BUTTONS = 0x000fff0000000000ull;
+    std::uint64_t const REPORT_BITS_SLIDER  = 0x0030000000000000ull;
 
+    /** Pack the bytes of an input report into a single 64-bit word, with b0 in the lowest byte.
+     */
+    std::uint64_t packInputReport(input_report const& report)
+    {
+        return  static_cast<std::uint64_t>(report.b0)        | (static_cast<std::uint64_t>(report.b1) << 8)  |
+               (static_cast<std::uint64_t>(report.b2) << 16) | (static_cast<std::uint64_t>(report.b3) << 24) |
+               (static_cast<std::uint64_t>(report.b4) << 32) | (static_cast<std::uint64_t>(report.b5) << 40) |
+               (static_cast<std::uint64_t>(report.b6) << 48);
+    }
+
+    /** Determine the input fields affected by a change in the packed report bits.
+     * @param[in] delta XOR of two packed input reports.
+     * @return Combination of input_field flags.
+     */
+    unsigned getChangedInputFields(std::uint64_t delta)
+    {
+        return ((delta & REPORT_BITS_BUTTONS) ? INPUT_FIELD_BUTTONS : 0) |
+               ((delta & REPORT_BITS_AXIS_X)  ? INPUT_FIELD_AXIS_X  : 0) |
+               ((delta & REPORT_BITS_AXIS_Y)  ? INPUT_FIELD_AXIS_Y  : 0) |
+               ((delta & REPORT_BITS_AXIS_Z)  ? INPUT_FIELD_AXIS_Z  : 0) |
+               ((delta & REPORT_BITS_SLIDER)  ? INPUT_FIELD_SLIDER  : 0);
+    }
+
+    /** Decode the selected fields of an input report into an input state.
+     * Fields not selected are left untouched.
+     * @param[in] report Input report to decode. The report id must have been checked by the caller.
+     * @param[in] fields Combination of input_field flags.
+     * @param[in,out] input_state Input state receiving the decoded values.
+     */
+    void evaluateInputReport(input_report const& report, unsigned fields, stratcom_input_state& input_state)
+    {
+        STRATCOM_TRACE_SCOPE("evaluateInputReport");
         /** \internal
          * Button State.
          * The button state is contained in the b5 and b6 fields of the report.
@@ -335,7 +1147,9 @@ namespace {
          * Applying a mask from the stratcom_button enum on the stratcom_button_word gives the
          * state of that button: 1 if the button is pressed; 0 otherwise
          */
-        input_state.buttons = (((report.b6 & 0x0F) << 8) | report.b5);
+        if(fields & INPUT_FIELD_BUTTONS) {
+            input_state.buttons = (((report.b6 & 0x0F) << 8) | report.b5);
+        }
 
         /** \internal
          * Slider State.
@@ -345,10 +1159,12 @@ namespace {
          *  SLIDER2 = 0x20,
          *  SLIDER3 = 0x10
          */
-        if((report.b6 & 0x30) == 0x30) {
-            input_state.slider = STRATCOM_SLIDER_1;
-        } else {
-            input_state.slider = ((report.b6 & 0x20) ? STRATCOM_SLIDER_2 : STRATCOM_SLIDER_3);
+        if(fields & INPUT_FIELD_SLIDER) {
+            if((report.b6 & 0x30) == 0x30) {
+                input_state.slider = STRATCOM_SLIDER_1;
+            } else {
+                input_state.slider = ((report.b6 & 0x20) ? STRATCOM_SLIDER_2 : STRATCOM_SLIDER_3);
+            }
         }
 
         /** \internal
@@ -366,53 +1182,587 @@ namespace {
          * The raw axis data ranges from -512 to +511 with negative values
          * encoded in two's complement.
          */
-        input_state.axisX = ( ((report.b2 & 0x03) << 8) | (report.b1) );
-        if(input_state.axisX & 0x200) { input_state.axisX = -( (input_state.axisX ^ 0x3FF) + 1); }
-        input_state.axisY = ( ((report.b3 & 0x0f) << 6) | ((report.b2 & 0xfc) >> 2) );
-        if(input_state.axisY & 0x200) { input_state.axisY = -( (input_state.axisY ^ 0x3FF) + 1); }
-        input_state.axisZ = ( ((report.b4 & 0x3f) << 4) | ((report.b3 & 0xf0) >> 4) );
-        if(input_state.axisZ & 0x200) { input_state.axisZ = -( (input_state.axisZ ^ 0x3FF) + 1); }
-
-        return STRATCOM_RET_SUCCESS;
-    }
+        if(fields & INPUT_FIELD_AXIS_X) {
+            input_state.axisX = ( ((report.b2 & 0x03) << 8) | (report.b1) );
+            if(input_state.axisX & 0x200) { input_state.axisX = -( (input_state.axisX ^ 0x3FF) + 1); }
+        }
+        if(fields & INPUT_FIELD_AXIS_Y) {
+            input_state.axisY = ( ((report.b3 & 0x0f) << 6) | ((report.b2 & 0xfc) >> 2) );
+            if(input_state.axisY & 0x200) { input_state.axisY = -( (input_state.axisY ^ 0x3FF) + 1); }
+        }
+        if(fields & INPUT_FIELD_AXIS_Z) {
+            input_state.axisZ = ( ((report.b4 & 0x3f) << 4) | ((report.b3 & 0xf0) >> 4) );
+            if(input_state.axisZ & 0x200) { input_state.axisZ = -( (input_state.axisZ ^ 0x3FF) + 1); }
+        }
+    }
+
+    /** Encode an input state into an input report. This is the inverse of evaluateInputReport().
+     * Axis positions outside the range of the device are clamped.
+     */
+    void encodeInputReport(stratcom_input_state const& input_state, input_report& report)
+    {
+        auto const raw_axis = [](stratcom_axis_word v) -> unsigned {
+            return static_cast<unsigned>(std::max(-512, std::min(511, static_cast<int>(v)))) & 0x3FF;
+        };
+        unsigned const x = raw_axis(input_state.axisX);
+        unsigned const y = raw_axis(input_state.axisY);
+        unsigned const z = raw_axis(input_state.axisZ);
+        unsigned slider = 0;
+        switch(input_state.slider) {
+        case STRATCOM_SLIDER_1: slider = 0x30; break;
+        case STRATCOM_SLIDER_2: slider = 0x20; break;
+        case STRATCOM_SLIDER_3: slider = 0x10; break;
+        default: break;
+        }
+        report.b0 = 0x01;
+        report.b1 = static_cast<std::uint8_t>(x & 0xFF);
+        report.b2 = static_cast<std::uint8_t>((x >> 8) | ((y & 0x3F) << 2));
+        report.b3 = static_cast<std::uint8_t>((y >> 6) | ((z & 0x0F) << 4));
+        report.b4 = static_cast<std::uint8_t>(z >> 4);
+        report.b5 = static_cast<std::uint8_t>(input_state.buttons & 0xFF);
+        report.b6 = static_cast<std::uint8_t>(((input_state.buttons >> 8) & 0x0F) | slider);
+    }
+
+    /** Replace the decoded raw axis positions of the selected fields by their calibrated positions.
+     */
+    void applyCalibration(stratcom_internal::axis_calibration& calibration, unsigned fields,
+                          stratcom_input_state& input_state)
+    {
+        if(fields & INPUT_FIELD_AXIS_X) {
+            input_state.axisX = calibration.calibrate(STRATCOM_AXIS_X, input_state.axisX);
+        }
+        if(fields & INPUT_FIELD_AXIS_Y) {
+            input_state.axisY = calibration.calibrate(STRATCOM_AXIS_Y, input_state.axisY);
+        }
+        if(fields & INPUT_FIELD_AXIS_Z) {
+            input_state.axisZ = calibration.calibrate(STRATCOM_AXIS_Z, input_state.axisZ);
+        }
+    }
+
+    /** Feed the current axis positions to the enabled velocity estimators.
+     * Axes that did not change are fed as well, as they contribute a velocity of 0 for the elapsed time.
+     */
+    void updateAxisVelocity(stratcom_device* device, stratcom_timestamp timestamp)
+    {
+        stratcom_internal::axis_velocity_estimator* const v = device->axis_velocity;
+        if(v[STRATCOM_AXIS_X].isEnabled()) { v[STRATCOM_AXIS_X].update(device->input_state.axisX, timestamp); }
+        if(v[STRATCOM_AXIS_Y].isEnabled()) { v[STRATCOM_AXIS_Y].update(device->input_state.axisY, timestamp); }
+        if(v[STRATCOM_AXIS_Z].isEnabled()) { v[STRATCOM_AXIS_Z].update(device->input_state.axisZ, timestamp); }
+    }
+
+    /** Pass a change of the input state on to the macro recorder.
+     * The REC LED blinks while REC is held and is restored afterwards.
+     */
+    void updateMacros(stratcom_device* device, stratcom_input_state const& old_state, stratcom_timestamp timestamp)
+    {
+        switch(device->macros->onInput(old_state, device->input_state, timestamp)) {
+        case stratcom_internal::macro_recorder::RECORDING_ARMED:
+            device->macro_led_request.store(MACRO_LED_BLINK);
+            break;
+        case stratcom_internal::macro_recorder::RECORDING_FINISHED:
+            device->macro_led_request.store(MACRO_LED_RESTORE);
+            break;
+        case stratcom_internal::macro_recorder::RECORDING_UNCHANGED:
+            break;
+        }
+    }
+
+    /** Pass a change of the internal input state on to all features that follow the input state.
+     * @param[in] old_state The input state before the change.
+     * @param[in] fields Combination of input_field flags of the fields that changed.
+     * @param[in] timestamp Time of the change.
+     */
+    void finishInputUpdate(stratcom_device* device, stratcom_input_state const& old_state, unsigned fields,
+                           stratcom_timestamp timestamp)
+    {
+        stratcom_button_word const old_buttons = old_state.buttons;
+        if(device->led_latency && (fields & INPUT_FIELD_BUTTONS)) {
+            device->led_latency->onButtonsPressed(
+                static_cast<stratcom_button_word>(device->input_state.buttons & ~old_buttons), timestamp);
+        }
+        if(device->calibration) {
+            applyCalibration(*device->calibration, fields, device->input_state);
+        }
+        updateAxisVelocity(device, timestamp);
+        if(device->macros && (fields != 0)) {
+            updateMacros(device, old_state, timestamp);
+        }
+        if(fields & INPUT_FIELD_BUTTONS) {
+            device->keymap.update(old_buttons, device->input_state.buttons, device->input_state.slider);
+        }
+        if(device->resampler) {
+            device->resampler->push(timestamp, device->input_state);
+        }
+    }
+
+    /** Update the device input state from a newly read input report.
+     * The report is compared against the previously processed report as a single 64-bit word.
+     * Only the fields whose report bits changed are decoded. If nothing changed, this function returns
+     * right after the comparison.
+     *
+     * This is also where lost reports are detected. The device only sends a report when its state changes.
+     * Receiving the same report twice in a row therefore means that the reports in between were lost,
+     * for instance a button press followed by its release. A single report changing more than one button
+     * at once hints at a lost report, but may also be caused by the user pressing buttons simultaneously.
+     * @param[in] device Device that the report was read from.
+     * @param[in] report The input report.
+     * @param[in] timestamp Arrival time of the input report.
+     * @param[out] out_changed_fields Combination of input_field flags of the fields that were decoded.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR if the report is not a valid input report.
+     */
+    stratcom_return processInputReport(stratcom_device* device, input_report const& report,
+                                       stratcom_timestamp timestamp, unsigned& out_changed_fields)
+    {
+        out_changed_fields = 0;
+        if(report.b0 != 0x01)
+        {
+            return STRATCOM_RET_ERROR;
+        }
+        device->input_timestamp = timestamp;
+        ++device->read_statistics.reports_read;
+        std::uint64_t const packed_report = packInputReport(report);
+        bool const debounce_pending = device->debouncer && device->debouncer->isPending();
+        unsigned fields = INPUT_FIELD_ALL;
+        if(device->has_last_report) {
+            std::uint64_t const delta = packed_report ^ device->last_report;
+            if(delta == 0) {
+                ++device->read_statistics.gaps_detected;
+                device->resync_pending = device->resync_mode;
+                if(!debounce_pending) {
+                    return STRATCOM_RET_SUCCESS;
+                }
+                // a button change held back by the debouncer may be due by now
+            }
+            std::uint64_t const button_delta = (delta & REPORT_BITS_BUTTONS);
+            if((button_delta & (button_delta - 1)) != 0) {
+                ++device->read_statistics.gaps_suspected;
+            }
+            fields = getChangedInputFields(delta);
+        }
+        device->last_report = packed_report;
+        device->has_last_report = true;
+        stratcom_input_state const old_state = device->input_state;
+        stratcom_button_word const old_buttons = old_state.buttons;
+        if(device->debouncer) {
+            evaluateInputReport(report, fields & ~INPUT_FIELD_BUTTONS, device->input_state);
+            if((fields & INPUT_FIELD_BUTTONS) || debounce_pending) {
+                auto const raw_buttons = static_cast<stratcom_button_word>((packed_report & REPORT_BITS_BUTTONS) >> 40);
+                device->input_state.buttons = device->debouncer->filter(raw_buttons, timestamp,
+                                                                        device->read_statistics.debounce_suppressed);
+                fields &= ~INPUT_FIELD_BUTTONS;
+                if(device->input_state.buttons != old_buttons) { fields |= INPUT_FIELD_BUTTONS; }
+            }
+        } else {
+            evaluateInputReport(report, fields, device->input_state);
+        }
+        finishInputUpdate(device, old_state, fields, timestamp);
+        out_changed_fields = fields;
+        return STRATCOM_RET_SUCCESS;
+    }
+
+    /** Take on button changes that the debouncer held back until the end of their window.
+     * The device only sends a report when its state changes, so after a short tap no report might
+     * follow that would resolve the change.
+     * @param[in] timestamp The current time.
+     * @param[out] out_changed_fields INPUT_FIELD_BUTTONS if the button state changed, 0 otherwise.
+     * @return STRATCOM_RET_SUCCESS if the button state changed, STRATCOM_RET_NO_DATA otherwise.
+     */
+    stratcom_return resolveDebounce(stratcom_device* device, stratcom_timestamp timestamp,
+                                    unsigned& out_changed_fields)
+    {
+        out_changed_fields = 0;
+        stratcom_input_state const old_state = device->input_state;
+        device->input_state.buttons = device->debouncer->filter(device->debouncer->getRawState(), timestamp,
+                                                                device->read_statistics.debounce_suppressed);
+        if(device->input_state.buttons == old_state.buttons) {
+            return STRATCOM_RET_NO_DATA;
+        }
+        device->input_timestamp = timestamp;
+        finishInputUpdate(device, old_state, INPUT_FIELD_BUTTONS, timestamp);
+        out_changed_fields = INPUT_FIELD_BUTTONS;
+        return STRATCOM_RET_SUCCESS;
+    }
+
+    /** Read an input report from the device and process it.
+     * While the debouncer holds back a button change, the wait for a report is cut short at the end of the
+     * debounce window, after which the change is taken on as if a report had arrived.
+     * @param[in] timeout_milliseconds Time to wait for a report. -1 blocks indefinitely, 0 returns immediately.
+     * @param[out] out_changed_fields Combination of input_field flags of the fields that were decoded.
+     * @return STRATCOM_RET_SUCCESS on success, STRATCOM_RET_ERROR on error, STRATCOM_RET_NO_DATA on timeout.
+     */
+    stratcom_return readInputReport(stratcom_device* device, int timeout_milliseconds, unsigned& out_changed_fields)
+    {
+        out_changed_fields = 0;
+        int const requested_timeout = timeout_milliseconds;
+        bool const debounce_pending = device->debouncer && device->debouncer->isPending();
+        stratcom_timestamp const due = debounce_pending ? device->debouncer->getNextExpiry() : 0;
+        bool wait_for_debounce = false;
+        if(debounce_pending) {
+            stratcom_timestamp const now = stratcom_get_timestamp();
+            stratcom_timestamp const remaining = (due > now) ? (due - now) : 0;
+            int const wait_milliseconds =
+                static_cast<int>(std::min<stratcom_timestamp>(remaining / 1000, 0x7fffffff));
+            if((timeout_milliseconds < 0) || (timeout_milliseconds >= wait_milliseconds)) {
+                timeout_milliseconds = wait_milliseconds;
+                wait_for_debounce = true;
+            }
+        }
+        input_report report;
+        stratcom_timestamp timestamp;
+        int const res = device_read_report(device, report, timeout_milliseconds, timestamp);
+        if(res == sizeof(report)) {
+            return processInputReport(device, report, timestamp, out_changed_fields);
+        } else if(res != 0) {
+            return STRATCOM_RET_ERROR;
+        }
+        if(wait_for_debounce) {
+            // the timeout only has millisecond resolution; sleep the remainder unless asked not to block
+            stratcom_timestamp const now = stratcom_get_timestamp();
+            if((requested_timeout != 0) && (due > now)) {
+                std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+            }
+            return resolveDebounce(device, stratcom_get_timestamp(), out_changed_fields);
+        }
+        return STRATCOM_RET_NO_DATA;
+    }
+
+    /** Generate input events for the selected fields of a pair of input states.
+     * Events are handed to the sink in a fixed order: slider, X-, Y-, Z-axis, then buttons in
+     * stratcom_iterate_buttons_range order.
+     * @tparam EventSink Type providing onSlider(), onAxis() and onButton() member functions.
+     */
+    template<typename EventSink>
+    void generateInputEvents(stratcom_input_state const& old_state, stratcom_input_state const& new_state,
+                             unsigned fields, EventSink& sink)
+    {
+        if((fields & INPUT_FIELD_SLIDER) && (old_state.slider != new_state.slider)) {
+            sink.onSlider(new_state.slider);
+        }
+        if((fields & INPUT_FIELD_AXIS_X) && (old_state.axisX != new_state.axisX)) {
+            sink.onAxis(STRATCOM_AXIS_X, new_state.axisX);
+        }
+        if((fields & INPUT_FIELD_AXIS_Y) && (old_state.axisY != new_state.axisY)) {
+            sink.onAxis(STRATCOM_AXIS_Y, new_state.axisY);
+        }
+        if((fields & INPUT_FIELD_AXIS_Z) && (old_state.axisZ != new_state.axisZ)) {
+            sink.onAxis(STRATCOM_AXIS_Z, new_state.axisZ);
+        }
+        if((fields & INPUT_FIELD_BUTTONS) && (old_state.buttons != new_state.buttons)) {
+            for(auto b = stratcom_iterate_buttons_range_begin(); b != stratcom_iterate_buttons_range_end();
+                b = stratcom_iterate_buttons_range_increment(b))
+            {
+                if((old_state.buttons & b) != (new_state.buttons & b)) {
+                    sink.onButton(b, ((new_state.buttons & b) == 0) ? 0 : 1);
+                }
+            }
+        }
+    }
+
+    /** Event sink building a linked list of stratcom_input_event.
+     * Each new event is prepended to the list.
+     * Throws std::bad_alloc if an event cannot be allocated; the events built so far remain owned by the builder.
+     */
+    class input_event_list_builder {
+    private:
+        stratcom_internal::allocator m_allocator;
+        stratcom_input_event* m_events;
+        std::uint64_t m_sequence;
+        stratcom_timestamp m_timestamp;
+        std::uint32_t m_flags;
+        std::int32_t m_axis_velocity[3];
+        std::uint32_t const* m_key_actions;             ///< indexed by the bit of the button; may be NULL.
+    public:
+        explicit input_event_list_builder(stratcom_internal::allocator const& alloc)
+            :m_allocator(alloc), m_events(nullptr), m_sequence(0), m_timestamp(0), m_flags(0),
+             m_key_actions(nullptr)
+        {
+            m_axis_velocity[0] = m_axis_velocity[1] = m_axis_velocity[2] = 0;
+        }
+
+        input_event_list_builder(stratcom_internal::allocator const& alloc, std::uint64_t sequence,
+                                 stratcom_timestamp timestamp)
+            :m_allocator(alloc), m_events(nullptr), m_sequence(sequence), m_timestamp(timestamp), m_flags(0),
+             m_key_actions(nullptr)
+        {
+            m_axis_velocity[0] = m_axis_velocity[1] = m_axis_velocity[2] = 0;
+        }
+
+        /** Set the velocities reported with subsequently built axis events.
+         * Pass NULL to report a velocity of 0.
+         */
+        void setAxisVelocities(stratcom_internal::axis_velocity_estimator const* axis_velocity)
+        {
+            for(int i = 0; i < 3; ++i) {
+                m_axis_velocity[i] = (axis_velocity && axis_velocity[i].isEnabled()) ?
+                                     axis_velocity[i].getVelocity() : 0;
+            }
+        }
+
+        /** Set the actions reported with subsequently built button events.
+         * Pass NULL to report an action of 0.
+         * @see stratcom_internal::keymap_binding::getActions()
+         */
+        void setKeyActions(std::uint32_t const* key_actions)
+        {
+            m_key_actions = key_actions;
+        }
+
+        /** Set the timestamp for all subsequently built events.
+         */
+        void setTimestamp(stratcom_timestamp timestamp)
+        {
+            m_timestamp = timestamp;
+        }
+
+        /** Set the flags for all subsequently built events.
+         */
+        void setFlags(std::uint32_t flags)
+        {
+            m_flags = flags;
+        }
+
+        ~input_event_list_builder()
+        {
+            stratcom_free_input_events(m_events);
+        }
+
+        void onSlider(stratcom_slider_state status)
+        {
+            auto ev = newEvent(STRATCOM_INPUT_EVENT_SLIDER);
+            ev->desc.slider.status = status;
+        }
+
+        void onAxis(stratcom_axis axis, stratcom_axis_word status)
+        {
+            auto ev = newEvent(STRATCOM_INPUT_EVENT_AXIS);
+            ev->desc.axis.axis = axis;
+            ev->desc.axis.status = status;
+            ev->velocity = m_axis_velocity[axis];
+        }
+
+        void onButton(stratcom_button button, int status)
+        {
+            auto ev = newEvent(STRATCOM_INPUT_EVENT_BUTTON);
+            ev->desc.button.button = button;
+            ev->desc.button.status = status;
+            if(m_key_actions && ((button & stratcom_internal::keymap::KEY_MASK) != 0)) {
+                ev->action = m_key_actions[stratcom_internal::keymap::keyIndex(button)];
+            }
+        }
+
+        stratcom_input_event* release()
+        {
+            auto ret = m_events;
+            m_events = nullptr;
+            return ret;
+        }
+    private:
+        stratcom_input_event* newEvent(stratcom_input_event_type type)
+        {
+            void* mem = stratcom_internal::allocate(m_allocator, sizeof(stratcom_input_event));
+            if(!mem) { throw std::bad_alloc(); }
+            auto ev = new (mem) stratcom_input_event;
+            ev->type = type;
+            ev->sequence = m_sequence;
+            ev->timestamp = m_timestamp;
+            ev->flags = m_flags;
+            ev->velocity = 0;
+            ev->action = 0;
+            ev->next = m_events;
+            m_events = ev;
+            return ev;
+        }
+
+        input_event_list_builder(input_event_list_builder const&);              // = delete
+        input_event_list_builder& operator=(input_event_list_builder const&);   // = delete
+    };
 }
 
 stratcom_return stratcom_read_input(stratcom_device* device)
 {
-    hid_set_nonblocking(device->device, false);
-    input_report report;
-    int const res = hid_read(device->device, &report.b0, sizeof(report));
-    if(res == sizeof(report)) {
-        return evaluateInputReport(report, device->input_state);
-    } else {
+    unsigned changed_fields;
+    stratcom_return const res = readInputReport(device, -1, changed_fields);
+    return (res == STRATCOM_RET_NO_DATA) ? STRATCOM_RET_ERROR : res;
+}
+
+stratcom_return stratcom_read_input_with_timeout(stratcom_device* device, int timeout_milliseconds)
+{
+    unsigned changed_fields;
+    return readInputReport(device, timeout_milliseconds, changed_fields);
+}
+
+stratcom_return stratcom_read_input_non_blocking(stratcom_device* device)
+{
+    unsigned changed_fields;
+    return readInputReport(device, 0, changed_fields);
+}
+
+stratcom_return stratcom_wait_input(stratcom_device* device, stratcom_wait_policy const* policy)
+{
+    stratcom_wait_policy block_policy;
+    block_policy.type = STRATCOM_WAIT_BLOCK;
+    block_policy.spin_microseconds = 0;
+    block_policy.max_spin_microseconds = 0;
+    if(policy && ((policy->type < STRATCOM_WAIT_BLOCK) || (policy->type > STRATCOM_WAIT_ADAPTIVE))) {
         return STRATCOM_RET_ERROR;
     }
+    STRATCOM_TRACE_SCOPE("wait_input");
+    stratcom_return const res = device->waiter->wait(policy ? *policy : block_policy,
+        [device](int timeout_milliseconds, stratcom_timestamp& out_arrival) -> stratcom_return {
+            unsigned changed_fields;
+            stratcom_return const ret = readInputReport(device, timeout_milliseconds, changed_fields);
+            out_arrival = device->input_timestamp;
+            return ret;
+        });
+    return (res == STRATCOM_RET_NO_DATA) ? STRATCOM_RET_ERROR : res;
 }
 
-stratcom_return stratcom_read_input_with_timeout(stratcom_device* device, int timeout_milliseconds)
+stratcom_return stratcom_get_wait_statistics(stratcom_device* device, stratcom_wait_policy_type type,
+                                             stratcom_wait_statistics* out_statistics)
 {
-    hid_set_nonblocking(device->device, false);
-    input_report report;
-    int const res = hid_read_timeout(device->device, &report.b0, sizeof(report), timeout_milliseconds);
-    if(res == sizeof(report)) {
-        return evaluateInputReport(report, device->input_state);
-    } else if(res != 0) {
+    if((type < STRATCOM_WAIT_BLOCK) || (type > STRATCOM_WAIT_ADAPTIVE)) {
         return STRATCOM_RET_ERROR;
     }
-    return STRATCOM_RET_NO_DATA;
+    device->waiter->getStatistics(type, *out_statistics);
+    return STRATCOM_RET_SUCCESS;
 }
 
-stratcom_return stratcom_read_input_non_blocking(stratcom_device* device)
+void stratcom_reset_wait_statistics(stratcom_device* device)
+{
+    device->waiter->resetStatistics();
+}
+
+int stratcom_get_poll_fd(stratcom_device* device)
+{
+    if(device->simulated) {
+        return device->simulated->getPollFd();
+    }
+#ifdef LIBSTRATCOM_HIDRAW
+    return device->hidraw_fd;
+#else
+    return -1;
+#endif
+}
+
+stratcom_device* stratcom_open_simulated_device()
 {
-    hid_set_nonblocking(device->device, true);
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_device> ret(
+        stratcom_internal::create<stratcom_device>(alloc, static_cast<hid_device*>(nullptr)));
+    if(!ret) {
+        return nullptr;
+    }
+    ret->simulated.reset(stratcom_internal::create<stratcom_internal::simulated_device>(alloc));
+    if(!ret->simulated || !allocateDeviceResources(ret.get())) {
+        return nullptr;
+    }
+    stratcom_read_button_led_state(ret.get());
+    stratcom_read_led_blink_intervals(ret.get());
+    return ret.release();
+}
+
+stratcom_return stratcom_simulated_device_push_state(stratcom_device* device, stratcom_input_state const* state)
+{
+    if(!device->simulated) {
+        return STRATCOM_RET_ERROR;
+    }
     input_report report;
-    int const res = hid_read(device->device, &report.b0, sizeof(report));
-    if(res == sizeof(report)) {
-        return evaluateInputReport(report, device->input_state);
-    } else if(res != 0) {
+    encodeInputReport(*state, report);
+    return device->simulated->pushReport(&report.b0, sizeof(report), stratcom_get_timestamp()) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_read_input_events(stratcom_device* device, int timeout_milliseconds,
+                                           stratcom_input_event** out_events)
+{
+    *out_events = nullptr;
+    stratcom_input_state const old_state = device->input_state;
+    unsigned changed_fields;
+    // during macro playback, wake up in time for the next step
+    bool const playing = device->macros && device->macros->isPlaying();
+    stratcom_timestamp const due = playing ? device->macros->getNextDueTime() : 0;
+    bool wait_for_step = false;
+    if(playing) {
+        stratcom_timestamp const now = stratcom_get_timestamp();
+        stratcom_timestamp const remaining = (due > now) ? (due - now) : 0;
+        int const wait_milliseconds = static_cast<int>(std::min<stratcom_timestamp>(remaining / 1000, 0x7fffffff));
+        if((timeout_milliseconds < 0) || (timeout_milliseconds >= wait_milliseconds)) {
+            timeout_milliseconds = wait_milliseconds;
+            wait_for_step = true;
+        }
+    }
+    stratcom_return res = readInputReport(device, timeout_milliseconds, changed_fields);
+    stratcom_internal::macro_recorder::step const* steps = nullptr;
+    std::size_t number_of_steps = 0;
+    stratcom_timestamp playback_start = 0;
+    if((res != STRATCOM_RET_ERROR) && device->macros) {
+        if((res == STRATCOM_RET_NO_DATA) && wait_for_step) {
+            // the timeout only has millisecond resolution; sleep the remainder
+            stratcom_timestamp const now = stratcom_get_timestamp();
+            if(due > now) { std::this_thread::sleep_for(std::chrono::microseconds(due - now)); }
+        }
+        number_of_steps = device->macros->takeDueSteps(stratcom_get_timestamp(), steps, playback_start);
+    }
+    if(number_of_steps != 0) {
+        res = STRATCOM_RET_SUCCESS;
+    } else if((res != STRATCOM_RET_SUCCESS) || ((changed_fields == 0) && !device->resync_pending)) {
+        return res;
+    }
+    try {
+        STRATCOM_TRACE_SCOPE("create_input_events");
+        input_event_list_builder builder(device->allocator, device->read_statistics.reports_read,
+                                         device->input_timestamp);
+        builder.setAxisVelocities(device->axis_velocity);
+        builder.setKeyActions(device->keymap.getActions());
+        generateInputEvents(old_state, device->input_state, changed_fields, builder);
+        if(device->resync_pending) {
+            // reports were lost; report the state of every button so that the client can rebuild its state
+            builder.setFlags(STRATCOM_INPUT_EVENT_FLAG_RESYNC);
+            for(auto b = stratcom_iterate_buttons_range_begin(); b != stratcom_iterate_buttons_range_end();
+                b = stratcom_iterate_buttons_range_increment(b))
+            {
+                builder.onButton(b, ((device->input_state.buttons & b) == 0) ? 0 : 1);
+            }
+            device->resync_pending = false;
+            ++device->read_statistics.resyncs;
+        }
+        if(number_of_steps != 0) {
+            // built from the last step to the first, so that the steps appear in order in the list
+            builder.setFlags(STRATCOM_INPUT_EVENT_FLAG_SYNTHETIC);
+            builder.setAxisVelocities(nullptr);
+            builder.setKeyActions(nullptr);
+            for(std::size_t i = number_of_steps; i-- > 0; ) {
+                auto const& step = steps[i];
+                builder.setTimestamp(playback_start + step.offset);
+                if(step.type == STRATCOM_INPUT_EVENT_AXIS) {
+                    builder.onAxis(static_cast<stratcom_axis>(step.control),
+                                   static_cast<stratcom_axis_word>(step.status));
+                } else {
+                    builder.onButton(static_cast<stratcom_button>(step.control), step.status);
+                }
+            }
+        }
+        *out_events = builder.release();
+    } catch(std::bad_alloc&) {
         return STRATCOM_RET_ERROR;
     }
-    return STRATCOM_RET_NO_DATA;
+    return STRATCOM_RET_SUCCESS;
+}
+
+std::uint64_t stratcom_get_input_sequence(stratcom_device* device)
+{
+    return device->read_statistics.reports_read;
+}
+
+void stratcom_get_read_statistics(stratcom_device* device, stratcom_read_statistics* out_statistics)
+{
+    *out_statistics = device->read_statistics;
+}
+
+void stratcom_set_resync_mode(stratcom_device* device, int enabled)
+{
+    device->resync_mode = (enabled != 0);
+    if(!device->resync_mode) { device->resync_pending = false; }
 }
 
 stratcom_input_state stratcom_get_input_state(stratcom_device* device)
@@ -436,11 +1786,538 @@ stratcom_axis_word stratcom_get_axis_value(stratcom_device* device, stratcom_axi
     return 0;
 }
 
+struct stratcom_state_history_ {
+    stratcom_internal::state_history history;
+
+    stratcom_state_history_(stratcom_internal::allocator const& alloc, uint32_t capacity)
+        :history(alloc, capacity)
+    {}
+};
+
+stratcom_state_history* stratcom_create_state_history(uint32_t capacity)
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_state_history> ret(
+        stratcom_internal::create<stratcom_state_history>(alloc, alloc, capacity));
+    if(!ret || !ret->history.isValid()) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+void stratcom_free_state_history(stratcom_state_history* history)
+{
+    stratcom_internal::destroy(history);
+}
+
+stratcom_return stratcom_state_history_push(stratcom_state_history* history, stratcom_timestamp timestamp,
+                                            stratcom_input_state const* state)
+{
+    return history->history.push(timestamp, *state) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+uint32_t stratcom_state_history_get_size(stratcom_state_history* history)
+{
+    return static_cast<uint32_t>(history->history.getSize());
+}
+
+stratcom_return stratcom_state_history_get_state_at(stratcom_state_history* history, stratcom_timestamp t,
+                                                    stratcom_input_state* out_state)
+{
+    return history->history.getStateAt(t, *out_state) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_state_history_query_buttons(stratcom_state_history* history,
+                                                     stratcom_timestamp t0, stratcom_timestamp t1,
+                                                     stratcom_button_word* out_held_any,
+                                                     stratcom_button_word* out_held_throughout)
+{
+    return history->history.queryButtons(t0, t1, *out_held_any, *out_held_throughout) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_state_history_query_axis_range(stratcom_state_history* history, stratcom_axis axis,
+                                                        stratcom_timestamp t0, stratcom_timestamp t1,
+                                                        stratcom_axis_word* out_min, stratcom_axis_word* out_max)
+{
+    return history->history.queryAxisRange(axis, t0, t1, *out_min, *out_max) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+float stratcom_get_axis_value_float(stratcom_device* device, stratcom_axis axis)
+{
+    if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z)) {
+        return 0.f;
+    }
+    if(device->calibration) {
+        return device->calibration->getFloatValue(axis);
+    }
+    return stratcom_internal::normalizeAxisValue(stratcom_get_axis_value(device, axis));
+}
+
+stratcom_return stratcom_set_axis_calibration(stratcom_device* device, stratcom_axis axis,
+                                              stratcom_axis_calibration const* calibration)
+{
+    if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z) ||
+       (calibration && !stratcom_internal::axis_calibration::isValidCalibration(*calibration)))
+    {
+        return STRATCOM_RET_ERROR;
+    }
+    if(!device->calibration) {
+        if(!calibration) {
+            return STRATCOM_RET_SUCCESS;
+        }
+        // while no axis is calibrated, the input state holds the raw positions
+        device->calibration.reset(stratcom_internal::create<stratcom_internal::axis_calibration>(
+            device->allocator, device->allocator, device->input_state));
+        if(!device->calibration) {
+            return STRATCOM_RET_ERROR;
+        }
+    }
+    if(!device->calibration->setCalibration(axis, calibration)) {
+        if(!device->calibration->hasCalibratedAxes()) { device->calibration.reset(); }
+        return STRATCOM_RET_ERROR;
+    }
+    stratcom_internal::axis_calibration& c = *device->calibration;
+    device->input_state.axisX = c.getValue(STRATCOM_AXIS_X);
+    device->input_state.axisY = c.getValue(STRATCOM_AXIS_Y);
+    device->input_state.axisZ = c.getValue(STRATCOM_AXIS_Z);
+    if(!c.hasCalibratedAxes()) {
+        device->calibration.reset();
+    }
+    return STRATCOM_RET_SUCCESS;
+}
+
+stratcom_return stratcom_set_axis_velocity_smoothing(stratcom_device* device, stratcom_axis axis,
+                                                     uint32_t smoothing_microseconds)
+{
+    if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z)) {
+        return STRATCOM_RET_ERROR;
+    }
+    device->axis_velocity[axis].setSmoothingTime(smoothing_microseconds);
+    return STRATCOM_RET_SUCCESS;
+}
+
+int32_t stratcom_get_axis_velocity(stratcom_device* device, stratcom_axis axis)
+{
+    if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z)) {
+        return 0;
+    }
+    auto const& v = device->axis_velocity[axis];
+    return v.isEnabled() ? v.getVelocity(stratcom_get_timestamp()) : 0;
+}
+
+int32_t stratcom_get_axis_acceleration(stratcom_device* device, stratcom_axis axis)
+{
+    if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z)) {
+        return 0;
+    }
+    auto const& v = device->axis_velocity[axis];
+    return v.isEnabled() ? v.getAcceleration(stratcom_get_timestamp()) : 0;
+}
+
+stratcom_return stratcom_enable_macros(stratcom_device* device, uint32_t max_steps)
+{
+    device->macro_led_request.store(MACRO_LED_RESTORE);
+    if(device->macro_led_blinking && (stratcom_flush_button_led_state(device) != STRATCOM_RET_SUCCESS)) {
+        device->macros.reset();
+        return STRATCOM_RET_ERROR;
+    }
+    device->macro_led_request.store(MACRO_LED_NONE);
+    device->macros.reset();
+    if(max_steps == 0) {
+        return STRATCOM_RET_SUCCESS;
+    }
+    device->macros.reset(stratcom_internal::create<stratcom_internal::macro_recorder>(
+        device->allocator, device->allocator, max_steps));
+    if(!device->macros || !device->macros->isValid()) {
+        device->macros.reset();
+        return STRATCOM_RET_ERROR;
+    }
+    return STRATCOM_RET_SUCCESS;
+}
+
+namespace {
+    /** Macro slot of a button. -1 if the button cannot hold a macro.
+     */
+    int getMacroSlot(stratcom_button button)
+    {
+        switch(button) {
+        case STRATCOM_BUTTON_1: return 0;
+        case STRATCOM_BUTTON_2: return 1;
+        case STRATCOM_BUTTON_3: return 2;
+        case STRATCOM_BUTTON_4: return 3;
+        case STRATCOM_BUTTON_5: return 4;
+        case STRATCOM_BUTTON_6: return 5;
+        default:                return -1;
+        }
+    }
+}
+
+uint32_t stratcom_get_macro_length(stratcom_device* device, stratcom_button button)
+{
+    int const slot = getMacroSlot(button);
+    if(!device->macros || (slot < 0)) {
+        return 0;
+    }
+    return device->macros->getLength(static_cast<unsigned>(slot));
+}
+
+stratcom_return stratcom_clear_macro(stratcom_device* device, stratcom_button button)
+{
+    int const slot = getMacroSlot(button);
+    if(!device->macros || (slot < 0)) {
+        return STRATCOM_RET_ERROR;
+    }
+    device->macros->clear(static_cast<unsigned>(slot));
+    return STRATCOM_RET_SUCCESS;
+}
+
+stratcom_return stratcom_set_debounce_window(stratcom_device* device, stratcom_button_word buttons,
+                                             uint32_t window_microseconds)
+{
+    if((buttons & ~0x0fff) != 0) {
+        return STRATCOM_RET_ERROR;
+    }
+    if(!device->debouncer) {
+        if(window_microseconds == 0) {
+            return STRATCOM_RET_SUCCESS;
+        }
+        device->debouncer.reset(stratcom_internal::create<stratcom_internal::button_debouncer>(
+            device->allocator, device->input_state.buttons));
+        if(!device->debouncer) {
+            return STRATCOM_RET_ERROR;
+        }
+    }
+    device->debouncer->setWindow(buttons, window_microseconds);
+    if(!device->debouncer->isEnabled()) {
+        // release any change that is still held back
+        device->input_state.buttons = device->debouncer->getRawState();
+        device->debouncer.reset();
+    }
+    return STRATCOM_RET_SUCCESS;
+}
+
+struct stratcom_keymap_ : public stratcom_internal::keymap {
+};
+
+stratcom_keymap* stratcom_compile_keymap(stratcom_keymap_entry const* entries, size_t number_of_entries)
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_keymap> ret(stratcom_internal::create<stratcom_keymap>(alloc));
+    if(!ret || !ret->compile(entries, number_of_entries)) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+void stratcom_free_keymap(stratcom_keymap* keymap)
+{
+    stratcom_internal::destroy(keymap);
+}
+
+uint32_t stratcom_keymap_lookup(stratcom_keymap const* keymap, stratcom_button_word buttons,
+                                stratcom_slider_state slider, stratcom_button button)
+{
+    if(((button & stratcom_internal::keymap::KEY_MASK) != button) || (button == STRATCOM_BUTTON_NONE)) {
+        return 0;
+    }
+    return keymap->lookup(buttons, slider, stratcom_internal::keymap::keyIndex(button));
+}
+
+stratcom_keymap const* stratcom_set_keymap(stratcom_device* device, stratcom_keymap const* keymap)
+{
+    // all keymaps set on a device are created by stratcom_compile_keymap()
+    return static_cast<stratcom_keymap const*>(device->keymap.exchange(keymap));
+}
+
 stratcom_slider_state stratcom_get_slider_state(stratcom_device* device)
 {
     return device->input_state.slider;
 }
 
+stratcom_timestamp stratcom_get_input_timestamp(stratcom_device* device)
+{
+    return device->input_timestamp;
+}
+
+stratcom_return stratcom_enable_resampling(stratcom_device* device, stratcom_resampler_config const* config)
+{
+    if(!config) {
+        device->resampler.reset();
+        return STRATCOM_RET_SUCCESS;
+    }
+    stratcom_internal::allocated_ptr<stratcom_internal::input_resampler> resampler(
+        stratcom_internal::create<stratcom_internal::input_resampler>(device->allocator, device->allocator, *config,
+                                                                     stratcom_get_timestamp(), device->input_state));
+    if(!resampler || !resampler->isValid()) {
+        return STRATCOM_RET_ERROR;
+    }
+    device->resampler = std::move(resampler);
+    return STRATCOM_RET_SUCCESS;
+}
+
+stratcom_return stratcom_sample_at(stratcom_device* device, stratcom_timestamp t, stratcom_sampled_state* out_sample)
+{
+    if(!device->resampler) {
+        return STRATCOM_RET_ERROR;
+    }
+    device->resampler->sample(t, *out_sample);
+    return STRATCOM_RET_SUCCESS;
+}
+
+struct stratcom_dispatcher_ {
+    stratcom_internal::dispatcher dispatcher;
+
+    explicit stratcom_dispatcher_(stratcom_internal::allocator const& alloc)
+        :dispatcher(alloc)
+    {}
+};
+
+stratcom_dispatcher* stratcom_create_dispatcher()
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    return stratcom_internal::create<stratcom_dispatcher>(alloc, alloc);
+}
+
+void stratcom_free_dispatcher(stratcom_dispatcher* dispatcher)
+{
+    stratcom_internal::destroy(dispatcher);
+}
+
+stratcom_return stratcom_dispatcher_on_button(stratcom_dispatcher* dispatcher, stratcom_button button,
+                                              stratcom_control_handler handler, void* user_data)
+{
+    unsigned control = stratcom_internal::dispatcher::CONTROL_BUTTONS;
+    for(auto b = stratcom_iterate_buttons_range_begin(); b != stratcom_iterate_buttons_range_end();
+        b = stratcom_iterate_buttons_range_increment(b), ++control)
+    {
+        if(b == button) {
+            return (handler && dispatcher->dispatcher.addHandler(control, handler, user_data)) ?
+                   STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+        }
+    }
+    return STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_dispatcher_on_axis(stratcom_dispatcher* dispatcher, stratcom_axis axis,
+                                            stratcom_control_handler handler, void* user_data)
+{
+    if(!handler || (axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z)) {
+        return STRATCOM_RET_ERROR;
+    }
+    unsigned const control = stratcom_internal::dispatcher::CONTROL_AXIS_X + (axis - STRATCOM_AXIS_X);
+    return dispatcher->dispatcher.addHandler(control, handler, user_data) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_dispatcher_on_slider(stratcom_dispatcher* dispatcher,
+                                              stratcom_control_handler handler, void* user_data)
+{
+    return (handler && dispatcher->dispatcher.addHandler(stratcom_internal::dispatcher::CONTROL_SLIDER,
+                                                         handler, user_data)) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_dispatcher_on_any(stratcom_dispatcher* dispatcher,
+                                           stratcom_control_handler handler, void* user_data)
+{
+    return (handler && dispatcher->dispatcher.addHandler(stratcom_internal::dispatcher::CONTROL_ANY,
+                                                         handler, user_data)) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_read_input_dispatch(stratcom_device* device, int timeout_milliseconds,
+                                             stratcom_dispatcher* dispatcher)
+{
+    stratcom_input_state const old_state = device->input_state;
+    unsigned changed_fields;
+    stratcom_return const res = readInputReport(device, timeout_milliseconds, changed_fields);
+    if((res == STRATCOM_RET_SUCCESS) && (changed_fields != 0)) {
+        STRATCOM_TRACE_SCOPE("dispatch_input");
+        dispatcher->dispatcher.dispatch(old_state, device->input_state, device->input_timestamp);
+    }
+    return res;
+}
+
+struct stratcom_gesture_engine_ {
+    stratcom_internal::gesture_engine engine;
+
+    stratcom_gesture_engine_(stratcom_internal::allocator const& alloc, uint32_t number_of_devices,
+                             stratcom_gesture_config const& config, stratcom_gesture_callback callback,
+                             void* user_data)
+        :engine(alloc, number_of_devices, config, callback, user_data, stratcom_get_timestamp())
+    {}
+};
+
+stratcom_gesture_engine* stratcom_create_gesture_engine(uint32_t number_of_devices,
+                                                        stratcom_gesture_config const* config,
+                                                        stratcom_gesture_callback callback,
+                                                        void* user_data)
+{
+    stratcom_gesture_config default_config;
+    default_config.long_press_time = 500000;
+    default_config.double_tap_interval = 250000;
+    default_config.enable_chords = 1;
+    if((number_of_devices == 0) || !callback) {
+        return nullptr;
+    }
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_gesture_engine> ret(stratcom_internal::create<stratcom_gesture_engine>(
+        alloc, alloc, number_of_devices, (config ? *config : default_config), callback, user_data));
+    if(!ret || !ret->engine.isValid()) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+void stratcom_free_gesture_engine(stratcom_gesture_engine* engine)
+{
+    stratcom_internal::destroy(engine);
+}
+
+stratcom_return stratcom_gesture_engine_process_events(stratcom_gesture_engine* engine, uint32_t device_index,
+                                                       stratcom_input_event const* events)
+{
+    return engine->engine.processEvents(device_index, events) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+void stratcom_gesture_engine_advance(stratcom_gesture_engine* engine, stratcom_timestamp now)
+{
+    engine->engine.advance(now);
+}
+
+struct stratcom_event_merger_ {
+    stratcom_internal::event_merger merger;
+
+    stratcom_event_merger_(stratcom_internal::allocator const& alloc, uint32_t number_of_devices, size_t queue_size,
+                           stratcom_timestamp reorder_window)
+        :merger(alloc, number_of_devices, queue_size, reorder_window)
+    {}
+};
+
+stratcom_event_merger* stratcom_create_event_merger(uint32_t number_of_devices, size_t queue_size,
+                                                    stratcom_timestamp reorder_window)
+{
+    if(number_of_devices == 0) {
+        return nullptr;
+    }
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_event_merger> ret(stratcom_internal::create<stratcom_event_merger>(
+        alloc, alloc, number_of_devices, queue_size, reorder_window));
+    if(!ret || !ret->merger.isValid()) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+void stratcom_free_event_merger(stratcom_event_merger* merger)
+{
+    stratcom_internal::destroy(merger);
+}
+
+stratcom_return stratcom_event_merger_push_events(stratcom_event_merger* merger, uint32_t device_index,
+                                                  stratcom_input_event const* events)
+{
+    if(device_index >= merger->merger.getNumberOfSources()) {
+        return STRATCOM_RET_ERROR;
+    }
+    bool success = true;
+    for(auto it = events; it; it = it->next) {
+        if(!merger->merger.push(device_index, *it)) {
+            success = false;
+        }
+    }
+    if(events) {
+        merger->merger.commit(device_index);
+    }
+    return success ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_return stratcom_read_merged_events(stratcom_event_merger* merger, int timeout_milliseconds,
+                                            stratcom_merged_event* out_events, size_t max_events, size_t* out_count)
+{
+    STRATCOM_TRACE_SCOPE("read_merged_events");
+    *out_count = merger->merger.read(out_events, max_events, timeout_milliseconds);
+    return (*out_count != 0) ? STRATCOM_RET_SUCCESS : STRATCOM_RET_NO_DATA;
+}
+
+void stratcom_get_event_merger_statistics(stratcom_event_merger* merger,
+                                          stratcom_event_merger_statistics* out_statistics)
+{
+    merger->merger.getStatistics(*out_statistics);
+}
+
+struct stratcom_log_writer_ {
+    stratcom_internal::log_writer writer;
+
+    stratcom_log_writer_(stratcom_internal::allocator const& alloc, uint32_t keyframe_interval)
+        :writer(alloc, keyframe_interval)
+    {}
+};
+
+struct stratcom_log_reader_ {
+    stratcom_internal::log_reader reader;
+
+    explicit stratcom_log_reader_(stratcom_internal::allocator const& alloc)
+        :reader(alloc)
+    {}
+};
+
+stratcom_log_writer* stratcom_log_writer_open(char const* filename, uint32_t keyframe_interval)
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_log_writer> ret(
+        stratcom_internal::create<stratcom_log_writer>(alloc, alloc, keyframe_interval));
+    if(!ret || !ret->writer.open(filename)) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+stratcom_return stratcom_log_writer_append(stratcom_log_writer* writer, stratcom_timestamp timestamp,
+                                           stratcom_input_state const* state)
+{
+    return writer->writer.append(timestamp, *state);
+}
+
+stratcom_return stratcom_log_writer_close(stratcom_log_writer* writer)
+{
+    stratcom_internal::allocated_ptr<stratcom_log_writer> guard(writer);
+    return writer->writer.close() ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+stratcom_log_reader* stratcom_log_reader_open(char const* filename)
+{
+    auto const& alloc = stratcom_internal::getGlobalAllocator();
+    stratcom_internal::allocated_ptr<stratcom_log_reader> ret(
+        stratcom_internal::create<stratcom_log_reader>(alloc, alloc));
+    if(!ret || !ret->reader.open(filename)) {
+        return nullptr;
+    }
+    return ret.release();
+}
+
+uint64_t stratcom_log_reader_get_record_count(stratcom_log_reader* reader)
+{
+    return reader->reader.getRecordCount();
+}
+
+stratcom_return stratcom_log_reader_seek(stratcom_log_reader* reader, stratcom_timestamp t)
+{
+    return reader->reader.seek(t);
+}
+
+stratcom_return stratcom_log_reader_next(stratcom_log_reader* reader, stratcom_timestamp* out_timestamp,
+                                         stratcom_input_state* out_state)
+{
+    return reader->reader.next(*out_timestamp, *out_state);
+}
+
+void stratcom_log_reader_close(stratcom_log_reader* reader)
+{
+    stratcom_internal::destroy(reader);
+}
+
 stratcom_button stratcom_iterate_buttons_range_begin()
 {
     return STRATCOM_BUTTON_1;
@@ -474,48 +2351,13 @@ stratcom_button stratcom_iterate_buttons_range_increment(stratcom_button button)
 stratcom_input_event* stratcom_create_input_events_from_states(stratcom_input_state* old_state,
                                                                stratcom_input_state* new_state)
 {
-    stratcom_input_event* ret = nullptr;
-
     try {
-        if(old_state->slider != new_state->slider) {
-            auto ev = new stratcom_input_event;
-            ev->type = STRATCOM_INPUT_EVENT_SLIDER;
-            ev->desc.slider.status = new_state->slider;
-            ev->next = ret;
-            ret = ev;
-        }
-
-        auto evaluate_axis_states = [&ret](stratcom_axis_word old_val, stratcom_axis_word new_val, stratcom_axis axis) {
-            if(old_val != new_val) {
-                auto ev = new stratcom_input_event;
-                ev->type = STRATCOM_INPUT_EVENT_AXIS;
-                ev->desc.axis.axis = axis;
-                ev->desc.axis.status = new_val;
-                ev->next = ret;
-                ret = ev;
-            }
-        };
-        evaluate_axis_states(old_state->axisX, new_state->axisX, STRATCOM_AXIS_X);
-        evaluate_axis_states(old_state->axisY, new_state->axisY, STRATCOM_AXIS_Y);
-        evaluate_axis_states(old_state->axisZ, new_state->axisZ, STRATCOM_AXIS_Z);
-
-        if(old_state->buttons != new_state->buttons) {
-            for(auto b = stratcom_iterate_buttons_range_begin(); b != stratcom_iterate_buttons_range_end();
-                b = stratcom_iterate_buttons_range_increment(b))
-            {
-                if((old_state->buttons & b) != (new_state->buttons & b)) {
-                    auto ev = new stratcom_input_event;
-                    ev->type = STRATCOM_INPUT_EVENT_BUTTON;
-                    ev->desc.button.button = b;
-                    ev->desc.button.status = ((new_state->buttons & b) == 0) ? 0 : 1;
-                    ev->next = ret;
-                    ret = ev;
-                }
-            }
-        }
-    } catch (std::bad_alloc&) { if(ret) { stratcom_free_input_events(ret); ret = nullptr; } }
-
-    return ret;
+        STRATCOM_TRACE_SCOPE("create_input_events");
+        input_event_list_builder builder(stratcom_internal::getGlobalAllocator());
+        generateInputEvents(*old_state, *new_state, INPUT_FIELD_ALL, builder);
+        return builder.release();
+    } catch (std::bad_alloc&) {}
+    return nullptr;
 }
 
 stratcom_input_event* stratcom_append_input_events_from_states(stratcom_input_event* events,
@@ -529,11 +2371,24 @@ stratcom_input_event* stratcom_append_input_events_from_states(stratcom_input_ev
     return new_events;
 }
 
+stratcom_return stratcom_diff_states_bulk(stratcom_input_state const* states, size_t n,
+                                          stratcom_compact_event_buffer* buffer)
+{
+    STRATCOM_TRACE_SCOPE("diff_states_bulk");
+    return stratcom_internal::diffStatesBulk(stratcom_internal::getGlobalAllocator(), states, n, *buffer) ?
+           STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+}
+
+void stratcom_free_compact_event_buffer(stratcom_compact_event_buffer* buffer)
+{
+    stratcom_internal::freeCompactEventBuffer(*buffer);
+}
+
 void stratcom_free_input_events(stratcom_input_event* events)
 {
     while(events) {
         auto to_delete = events;
         events = events->next;
-        delete to_delete;
+        stratcom_internal::deallocate(to_delete);
     }
 }
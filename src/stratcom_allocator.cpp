@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_allocator.hpp"
+
+#include <cstdlib>
+
+namespace stratcom_internal {
+
+    namespace {
+        struct allocation_header {
+            allocator alloc;
+            std::size_t size;                           ///< size requested from the allocator, including the header.
+        };
+
+        /** Size of the header, rounded up so that the memory following it keeps the alignment of the
+         * memory returned by the allocator.
+         */
+        std::size_t const HEADER_SIZE = ((sizeof(allocation_header) + alignof(std::max_align_t) - 1) /
+                                         alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+        void* defaultAlloc(void*, std::size_t size)
+        {
+            return std::malloc(size);
+        }
+
+        void defaultFree(void*, void* p, std::size_t)
+        {
+            std::free(p);
+        }
+
+        allocator g_global_allocator = { defaultAlloc, defaultFree, nullptr };
+
+        allocation_header* getHeader(void const* p)
+        {
+            return reinterpret_cast<allocation_header*>(const_cast<char*>(static_cast<char const*>(p)) - HEADER_SIZE);
+        }
+    }
+
+    allocator const& getGlobalAllocator()
+    {
+        return g_global_allocator;
+    }
+
+    void setGlobalAllocator(stratcom_alloc_fn alloc_fn, stratcom_free_fn free_fn, void* user_data)
+    {
+        if(alloc_fn && free_fn) {
+            g_global_allocator.alloc_fn = alloc_fn;
+            g_global_allocator.free_fn = free_fn;
+            g_global_allocator.user_data = user_data;
+        } else {
+            g_global_allocator.alloc_fn = defaultAlloc;
+            g_global_allocator.free_fn = defaultFree;
+            g_global_allocator.user_data = nullptr;
+        }
+    }
+
+    void* allocate(allocator const& alloc, std::size_t size)
+    {
+        if(size > std::numeric_limits<std::size_t>::max() - HEADER_SIZE) { return nullptr; }
+        std::size_t const total_size = size + HEADER_SIZE;
+        void* mem = alloc.alloc_fn(alloc.user_data, total_size);
+        if(!mem) { return nullptr; }
+        allocation_header* header = new (mem) allocation_header;
+        header->alloc = alloc;
+        header->size = total_size;
+        return static_cast<char*>(mem) + HEADER_SIZE;
+    }
+
+    void deallocate(void* p)
+    {
+        if(!p) { return; }
+        allocation_header const header = *getHeader(p);
+        header.alloc.free_fn(header.alloc.user_data, getHeader(p), header.size);
+    }
+
+    allocator const& getAllocatorOf(void const* p)
+    {
+        return getHeader(p)->alloc;
+    }
+}
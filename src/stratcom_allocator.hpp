@@ -0,0 +1,171 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_ALLOCATOR_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_ALLOCATOR_HPP_
+
+#include <stratcom.h>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace stratcom_internal {
+
+    /** \internal A user-provided allocator.
+     * @see stratcom_set_allocator()
+     */
+    struct allocator {
+        stratcom_alloc_fn alloc_fn;
+        stratcom_free_fn free_fn;
+        void* user_data;
+    };
+
+    /** The allocator set through stratcom_set_allocator(), or the malloc-based default.
+     */
+    allocator const& getGlobalAllocator();
+
+    /** @see stratcom_set_allocator()
+     */
+    void setGlobalAllocator(stratcom_alloc_fn alloc_fn, stratcom_free_fn free_fn, void* user_data);
+
+    /** Allocate memory through an allocator.
+     * Each allocation is preceded by a hidden header recording the allocator, so that deallocate() returns the
+     * memory to the right allocator, no matter which allocator is current at that point.
+     * @return Memory suitably aligned for any fundamental type, or nullptr on failure.
+     */
+    void* allocate(allocator const& alloc, std::size_t size);
+
+    /** Return memory obtained from allocate() to its allocator. Passing nullptr has no effect.
+     */
+    void deallocate(void* p);
+
+    /** Retrieve the allocator that a block of memory obtained from allocate() belongs to.
+     */
+    allocator const& getAllocatorOf(void const* p);
+
+    /** Allocate and construct an object through an allocator.
+     * @return The new object or nullptr if the allocation failed.
+     */
+    template<typename T, typename... Args>
+    T* create(allocator const& alloc, Args&&... args)
+    {
+        void* mem = allocate(alloc, sizeof(T));
+        if(!mem) { return nullptr; }
+        try {
+            return new (mem) T(std::forward<Args>(args)...);
+        } catch(...) {
+            deallocate(mem);
+            throw;
+        }
+    }
+
+    /** Destroy and deallocate an object obtained from create(). Passing nullptr has no effect.
+     */
+    template<typename T>
+    void destroy(T* p)
+    {
+        if(p) {
+            p->~T();
+            deallocate(p);
+        }
+    }
+
+    /** Allocate an array of value-initialized elements through an allocator.
+     * Release the array with deallocate().
+     * @return The new array or nullptr if the allocation failed.
+     */
+    template<typename T>
+    T* createArray(allocator const& alloc, std::size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Array elements are never destroyed.");
+        if(count > std::numeric_limits<std::size_t>::max() / sizeof(T)) { return nullptr; }
+        T* ret = static_cast<T*>(allocate(alloc, count * sizeof(T)));
+        if(ret) {
+            for(std::size_t i = 0; i < count; ++i) { new (ret + i) T(); }
+        }
+        return ret;
+    }
+
+    struct object_deleter {
+        template<typename T>
+        void operator()(T* p) const { destroy(p); }
+    };
+
+    struct array_deleter {
+        template<typename T>
+        void operator()(T* p) const { deallocate(p); }
+    };
+
+    /** Owning pointer to an object obtained from create().
+     */
+    template<typename T>
+    using allocated_ptr = std::unique_ptr<T, object_deleter>;
+
+    /** Owning pointer to an array obtained from createArray().
+     */
+    template<typename T>
+    using allocated_array = std::unique_ptr<T[], array_deleter>;
+
+    /** Adapter for using an allocator with standard library containers.
+     * All instances compare equal, as memory always returns to the allocator recorded in its header.
+     */
+    template<typename T>
+    class std_allocator {
+    public:
+        typedef T value_type;
+
+        allocator m_allocator;
+
+        explicit std_allocator(allocator const& alloc)
+            :m_allocator(alloc)
+        {}
+
+        template<typename U>
+        std_allocator(std_allocator<U> const& rhs)
+            :m_allocator(rhs.m_allocator)
+        {}
+
+        T* allocate(std::size_t n)
+        {
+            if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) { throw std::bad_alloc(); }
+            void* p = stratcom_internal::allocate(m_allocator, n * sizeof(T));
+            if(!p) { throw std::bad_alloc(); }
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, std::size_t)
+        {
+            stratcom_internal::deallocate(p);
+        }
+    };
+
+    template<typename T, typename U>
+    bool operator==(std_allocator<T> const&, std_allocator<U> const&) { return true; }
+
+    template<typename T, typename U>
+    bool operator!=(std_allocator<T> const&, std_allocator<U> const&) { return false; }
+}
+
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_calibration.hpp"
+
+#include <cmath>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Map a raw position to a normalized calibrated position in the range from -1.0 to 1.0.
+         */
+        float evaluateCalibration(stratcom_axis_calibration const& calibration, int raw)
+        {
+            float n;
+            if(raw >= calibration.center) {
+                n = static_cast<float>(raw - calibration.center) / (calibration.max - calibration.center);
+            } else {
+                n = -static_cast<float>(calibration.center - raw) / (calibration.center - calibration.min);
+            }
+            if(n > 1.f) { n = 1.f; }
+            if(n < -1.f) { n = -1.f; }
+            if(calibration.response_curve != 1.f) {
+                n = (n < 0.f) ? -std::pow(-n, calibration.response_curve) : std::pow(n, calibration.response_curve);
+            }
+            return n;
+        }
+
+        stratcom_axis_word toAxisWord(float n)
+        {
+            return static_cast<stratcom_axis_word>((n < 0.f) ? -std::floor(-n * 512.f + 0.5f) :
+                                                               std::floor(n * 511.f + 0.5f));
+        }
+    }
+
+    axis_calibration::axis_calibration(allocator const& alloc, stratcom_input_state const& raw_state)
+        :m_allocator(alloc)
+    {
+        m_raw[STRATCOM_AXIS_X] = raw_state.axisX;
+        m_raw[STRATCOM_AXIS_Y] = raw_state.axisY;
+        m_raw[STRATCOM_AXIS_Z] = raw_state.axisZ;
+        for(int axis = 0; axis < NUMBER_OF_AXES; ++axis) {
+            setCalibration(axis, nullptr);
+        }
+    }
+
+    bool axis_calibration::isValidCalibration(stratcom_axis_calibration const& calibration)
+    {
+        return (calibration.min >= -TABLE_OFFSET) && (calibration.min < calibration.center) &&
+               (calibration.center < calibration.max) && (calibration.max < TABLE_SIZE - TABLE_OFFSET) &&
+               (calibration.response_curve > 0.f);
+    }
+
+    bool axis_calibration::setCalibration(int axis, stratcom_axis_calibration const* calibration)
+    {
+        if(!calibration) {
+            for(int i = 0; i < TABLE_SIZE; ++i) {
+                m_table[axis][i] = static_cast<stratcom_axis_word>(i - TABLE_OFFSET);
+            }
+            m_float_table[axis].reset();
+            m_is_calibrated[axis] = false;
+            return true;
+        }
+
+        allocated_array<float> float_table;
+        if(calibration->build_float_table) {
+            float_table.reset(createArray<float>(m_allocator, TABLE_SIZE));
+            if(!float_table) { return false; }
+        }
+        for(int i = 0; i < TABLE_SIZE; ++i) {
+            float const n = evaluateCalibration(*calibration, i - TABLE_OFFSET);
+            m_table[axis][i] = toAxisWord(n);
+            if(float_table) { float_table[i] = n; }
+        }
+        m_float_table[axis] = std::move(float_table);
+        m_is_calibrated[axis] = true;
+        m_calibration[axis] = *calibration;
+        return true;
+    }
+
+    bool axis_calibration::hasCalibratedAxes() const
+    {
+        return m_is_calibrated[STRATCOM_AXIS_X] || m_is_calibrated[STRATCOM_AXIS_Y] ||
+               m_is_calibrated[STRATCOM_AXIS_Z];
+    }
+
+    bool axis_calibration::getCalibration(int axis, stratcom_axis_calibration& out_calibration) const
+    {
+        if(!m_is_calibrated[axis]) {
+            return false;
+        }
+        out_calibration = m_calibration[axis];
+        return true;
+    }
+
+    float axis_calibration::getFloatValue(int axis) const
+    {
+        if(m_float_table[axis]) {
+            return m_float_table[axis][m_raw[axis] + TABLE_OFFSET];
+        }
+        return normalizeAxisValue(getValue(axis));
+    }
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_CALIBRATION_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_CALIBRATION_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Calibration lookup tables for the three axes of a device.
+     * Every raw axis position indexes directly into a table of calibrated positions. Axes without a
+     * calibration use an identity table, so that all axes can be calibrated uniformly once any axis has
+     * a calibration. The raw positions are retained, so that changing a calibration can recalibrate
+     * the current position.
+     */
+    class axis_calibration {
+    public:
+        static int const NUMBER_OF_AXES = 3;
+        static int const TABLE_SIZE = 1024;
+        static int const TABLE_OFFSET = 512;            ///< table index of raw position 0.
+    private:
+        stratcom_axis_word m_table[NUMBER_OF_AXES][TABLE_SIZE];
+        allocated_array<float> m_float_table[NUMBER_OF_AXES];
+        allocator m_allocator;                          ///< allocator for the floating point tables.
+        bool m_is_calibrated[NUMBER_OF_AXES];
+        stratcom_axis_calibration m_calibration[NUMBER_OF_AXES];    ///< calibration of each calibrated axis.
+        stratcom_axis_word m_raw[NUMBER_OF_AXES];       ///< latest raw position of each axis.
+    public:
+        /** Construct with identity tables for all axes.
+         * @param[in] alloc Allocator for the floating point tables.
+         * @param[in] raw_state Input state holding the current raw axis positions.
+         */
+        axis_calibration(allocator const& alloc, stratcom_input_state const& raw_state);
+
+        /** Check whether a calibration describes a valid mapping.
+         */
+        static bool isValidCalibration(stratcom_axis_calibration const& calibration);
+
+        /** Rebuild the lookup tables of an axis.
+         * @param[in] axis Index of the axis.
+         * @param[in] calibration A valid calibration or NULL for the identity mapping.
+         * @return false if the floating point table could not be allocated. The axis is left unchanged.
+         */
+        bool setCalibration(int axis, stratcom_axis_calibration const* calibration);
+
+        /** Check whether any of the axes is calibrated.
+         */
+        bool hasCalibratedAxes() const;
+
+        /** Retrieve the calibration of an axis.
+         * @return false if the axis is not calibrated.
+         */
+        bool getCalibration(int axis, stratcom_axis_calibration& out_calibration) const;
+
+        /** Record a new raw position for an axis and return its calibrated position.
+         */
+        stratcom_axis_word calibrate(int axis, stratcom_axis_word raw)
+        {
+            m_raw[axis] = raw;
+            return m_table[axis][raw + TABLE_OFFSET];
+        }
+
+        /** Latest raw position of an axis.
+         */
+        stratcom_axis_word getRawValue(int axis) const
+        {
+            return m_raw[axis];
+        }
+
+        /** Calibrated position of the latest raw position of an axis.
+         */
+        stratcom_axis_word getValue(int axis) const
+        {
+            return m_table[axis][m_raw[axis] + TABLE_OFFSET];
+        }
+
+        /** Normalized calibrated position of the latest raw position of an axis.
+         * Falls back to scaling the integer position if the axis has no floating point table.
+         */
+        float getFloatValue(int axis) const;
+
+    private:
+        axis_calibration(axis_calibration const&);              // = delete
+        axis_calibration& operator=(axis_calibration const&);   // = delete
+    };
+
+    /** \internal Normalize an axis position to the range from -1.0 to 1.0.
+     */
+    inline float normalizeAxisValue(stratcom_axis_word value)
+    {
+        return (value < 0) ? (value / 512.f) : (value / 511.f);
+    }
+}
+
+#endif
@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_debounce.hpp"
+
+namespace stratcom_internal {
+
+    namespace {
+        stratcom_button_word const ALL_BUTTONS = 0x0fff;
+
+        /** Index of the lowest set bit of a non-zero mask.
+         */
+        unsigned lowestBit(unsigned mask)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned ret = 0;
+            while((mask & 1) == 0) {
+                mask >>= 1;
+                ++ret;
+            }
+            return ret;
+#endif
+        }
+
+        unsigned popCount(unsigned mask)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_popcount(mask));
+#else
+            unsigned ret = 0;
+            for(; mask != 0; mask &= (mask - 1)) { ++ret; }
+            return ret;
+#endif
+        }
+    }
+
+    button_debouncer::button_debouncer(stratcom_button_word buttons)
+        :m_enabled(0), m_locked(0), m_raw(buttons), m_stable(buttons)
+    {
+        for(unsigned i = 0; i < NUMBER_OF_BUTTONS; ++i) {
+            m_expiry[i] = 0;
+            m_window[i] = 0;
+        }
+    }
+
+    void button_debouncer::setWindow(stratcom_button_word buttons, std::uint32_t window_microseconds)
+    {
+        for(unsigned mask = (buttons & ALL_BUTTONS); mask != 0; mask &= (mask - 1)) {
+            m_window[lowestBit(mask)] = window_microseconds;
+        }
+        if(window_microseconds != 0) {
+            m_enabled = static_cast<stratcom_button_word>(m_enabled | (buttons & ALL_BUTTONS));
+        } else {
+            m_enabled = static_cast<stratcom_button_word>(m_enabled & ~buttons);
+        }
+        m_locked = static_cast<stratcom_button_word>(m_locked & m_enabled);
+    }
+
+    std::uint32_t button_debouncer::getWindow(unsigned index) const
+    {
+        return ((m_enabled & (1u << index)) != 0) ? m_window[index] : 0;
+    }
+
+    bool button_debouncer::isEnabled() const
+    {
+        return m_enabled != 0;
+    }
+
+    bool button_debouncer::isPending() const
+    {
+        return m_raw != m_stable;
+    }
+
+    stratcom_timestamp button_debouncer::getNextExpiry() const
+    {
+        stratcom_timestamp ret = 0;
+        bool first = true;
+        for(unsigned pending = ((m_raw ^ m_stable) & ALL_BUTTONS); pending != 0; pending &= (pending - 1)) {
+            unsigned const b = lowestBit(pending);
+            // a pending button that is no longer locked is taken on right away
+            stratcom_timestamp const expiry = ((m_locked & (1u << b)) != 0) ? m_expiry[b] : 0;
+            if(first || (expiry < ret)) {
+                ret = expiry;
+                first = false;
+            }
+        }
+        return ret;
+    }
+
+    stratcom_button_word button_debouncer::getRawState() const
+    {
+        return m_raw;
+    }
+
+    stratcom_button_word button_debouncer::filter(stratcom_button_word raw, stratcom_timestamp timestamp,
+                                                  std::uint64_t& suppressed_count)
+    {
+        for(unsigned locked = m_locked; locked != 0; locked &= (locked - 1)) {
+            unsigned const b = lowestBit(locked);
+            if(timestamp >= m_expiry[b]) {
+                m_locked = static_cast<stratcom_button_word>(m_locked & ~(1u << b));
+            }
+        }
+        suppressed_count += popCount(static_cast<unsigned>(raw ^ m_raw) & m_locked);
+        stratcom_button_word const accepted = static_cast<stratcom_button_word>((raw ^ m_stable) & ~m_locked);
+        m_stable = static_cast<stratcom_button_word>(m_stable ^ accepted);
+        for(unsigned lock = (accepted & m_enabled); lock != 0; lock &= (lock - 1)) {
+            unsigned const b = lowestBit(lock);
+            m_expiry[b] = timestamp + m_window[b];
+        }
+        m_locked = static_cast<stratcom_button_word>(m_locked | (accepted & m_enabled));
+        m_raw = raw;
+        return m_stable;
+    }
+}
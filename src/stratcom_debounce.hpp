@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_DEBOUNCE_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_DEBOUNCE_HPP_
+
+#include <stratcom.h>
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Debounces the buttons of a device.
+     * Debouncing is eager: a button change is passed on as soon as it is reported, after which the button
+     * is locked for its debounce window. Further changes of a locked button are suppressed. A button whose
+     * reported state differs from its debounced state when its window expires takes on the reported state
+     * with the next call to filter(). As the device does not report again unless something changes, the caller
+     * has to call filter() with the last reported state at getNextExpiry() if no report arrives until then.
+     * All buttons are filtered together with a few mask operations on the button word. Only the expiry of
+     * the locked buttons is checked individually.
+     */
+    class button_debouncer {
+    public:
+        static unsigned const NUMBER_OF_BUTTONS = 12;
+    private:
+        stratcom_timestamp m_expiry[NUMBER_OF_BUTTONS];     ///< end of the window of each locked button.
+        std::uint32_t m_window[NUMBER_OF_BUTTONS];          ///< debounce window of each button in microseconds.
+        stratcom_button_word m_enabled;                     ///< buttons with a non-zero window.
+        stratcom_button_word m_locked;                      ///< buttons within their debounce window.
+        stratcom_button_word m_raw;                         ///< button state of the last report.
+        stratcom_button_word m_stable;                      ///< debounced button state.
+    public:
+        /** Constructor.
+         * @param[in] buttons The current button state, taken as both the reported and the debounced state.
+         */
+        explicit button_debouncer(stratcom_button_word buttons);
+
+        /** @see stratcom_set_debounce_window()
+         */
+        void setWindow(stratcom_button_word buttons, std::uint32_t window_microseconds);
+
+        /** Debounce window of a button in microseconds.
+         * @param[in] index Index of the bit of the button in stratcom_button_word.
+         */
+        std::uint32_t getWindow(unsigned index) const;
+
+        /** Check whether any button has a non-zero debounce window.
+         */
+        bool isEnabled() const;
+
+        /** Check whether the reported state of any button differs from its debounced state.
+         */
+        bool isPending() const;
+
+        /** End of the earliest debounce window among the buttons whose reported state differs from their
+         * debounced state. Only meaningful if isPending().
+         */
+        stratcom_timestamp getNextExpiry() const;
+
+        /** The button state of the last report, before debouncing.
+         */
+        stratcom_button_word getRawState() const;
+
+        /** Debounce the button state of a new report.
+         * @param[in] raw Button state decoded from the report.
+         * @param[in] timestamp Arrival time of the report.
+         * @param[in,out] suppressed_count Incremented by the number of button changes that were suppressed.
+         * @return The debounced button state.
+         */
+        stratcom_button_word filter(stratcom_button_word raw, stratcom_timestamp timestamp,
+                                    std::uint64_t& suppressed_count);
+    private:
+        button_debouncer(button_debouncer const&);              // = delete
+        button_debouncer& operator=(button_debouncer const&);   // = delete
+    };
+}
+
+#endif
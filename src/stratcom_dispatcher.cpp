@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_dispatcher.hpp"
+
+#include <new>
+
+namespace stratcom_internal {
+
+    namespace {
+        std::uint32_t changedControls(stratcom_input_state const& old_state, stratcom_input_state const& new_state)
+        {
+            std::uint32_t const changed_buttons = static_cast<std::uint32_t>(old_state.buttons ^ new_state.buttons);
+            return ((changed_buttons << dispatcher::CONTROL_BUTTONS) & 0xfff0) |
+                   ((old_state.axisZ != new_state.axisZ) ? 0x08u : 0u) |
+                   ((old_state.axisY != new_state.axisY) ? 0x04u : 0u) |
+                   ((old_state.axisX != new_state.axisX) ? 0x02u : 0u) |
+                   ((old_state.slider != new_state.slider) ? 0x01u : 0u);
+        }
+
+        /** Index of the lowest set bit of a non-zero mask.
+         */
+        unsigned lowestBit(std::uint32_t mask)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned ret = 0;
+            while((mask & 1) == 0) {
+                mask >>= 1;
+                ++ret;
+            }
+            return ret;
+#endif
+        }
+    }
+
+    dispatcher::dispatcher(allocator const& alloc)
+        :m_registrations(std_allocator<registration>(alloc)), m_handlers(std_allocator<handler_entry>(alloc)),
+         m_handled_mask(0)
+    {
+        for(unsigned i = 0; i <= NUMBER_OF_CONTROLS; ++i) {
+            m_offsets[i] = 0;
+        }
+    }
+
+    bool dispatcher::addHandler(unsigned control, stratcom_control_handler handler, void* user_data)
+    {
+        registration r;
+        r.control = control;
+        r.entry.handler = handler;
+        r.entry.user_data = user_data;
+        try {
+            m_registrations.push_back(r);
+        } catch(std::bad_alloc&) {
+            return false;
+        }
+        try {
+            // every control gets its own copy of the handlers for any control;
+            // reserving up front guarantees that compile() does not throw
+            m_handlers.reserve(m_handlers.size() + ((control == CONTROL_ANY) ? NUMBER_OF_CONTROLS : 1));
+        } catch(std::bad_alloc&) {
+            m_registrations.pop_back();
+            return false;
+        }
+        compile();
+        return true;
+    }
+
+    void dispatcher::compile()
+    {
+        m_handlers.clear();
+        m_handled_mask = 0;
+        for(unsigned c = 0; c < NUMBER_OF_CONTROLS; ++c) {
+            m_offsets[c] = static_cast<std::uint32_t>(m_handlers.size());
+            for(auto const& r : m_registrations) {
+                if(r.control == c) { m_handlers.push_back(r.entry); }
+            }
+            for(auto const& r : m_registrations) {
+                if(r.control == CONTROL_ANY) { m_handlers.push_back(r.entry); }
+            }
+            if(m_handlers.size() != m_offsets[c]) {
+                m_handled_mask |= (1u << c);
+            }
+        }
+        m_offsets[NUMBER_OF_CONTROLS] = static_cast<std::uint32_t>(m_handlers.size());
+    }
+
+    void dispatcher::dispatch(stratcom_input_state const& old_state, stratcom_input_state const& new_state,
+                              stratcom_timestamp timestamp) const
+    {
+        std::uint32_t mask = changedControls(old_state, new_state) & m_handled_mask;
+        while(mask != 0) {
+            unsigned const c = lowestBit(mask);
+            mask &= (mask - 1);
+            stratcom_input_event_type type;
+            int control;
+            std::int32_t old_value;
+            std::int32_t new_value;
+            if(c == CONTROL_SLIDER) {
+                type = STRATCOM_INPUT_EVENT_SLIDER;
+                control = 0;
+                old_value = old_state.slider;
+                new_value = new_state.slider;
+            } else if(c < CONTROL_BUTTONS) {
+                stratcom_axis_word const stratcom_input_state::* const axes[] = {
+                    &stratcom_input_state::axisX, &stratcom_input_state::axisY, &stratcom_input_state::axisZ
+                };
+                type = STRATCOM_INPUT_EVENT_AXIS;
+                control = static_cast<int>(STRATCOM_AXIS_X) + static_cast<int>(c - CONTROL_AXIS_X);
+                old_value = old_state.*axes[c - CONTROL_AXIS_X];
+                new_value = new_state.*axes[c - CONTROL_AXIS_X];
+            } else {
+                stratcom_button_word const button = static_cast<stratcom_button_word>(1u << (c - CONTROL_BUTTONS));
+                type = STRATCOM_INPUT_EVENT_BUTTON;
+                control = button;
+                old_value = ((old_state.buttons & button) != 0) ? 1 : 0;
+                new_value = ((new_state.buttons & button) != 0) ? 1 : 0;
+            }
+            for(std::uint32_t i = m_offsets[c]; i != m_offsets[c + 1]; ++i) {
+                m_handlers[i].handler(m_handlers[i].user_data, type, control, old_value, new_value, timestamp);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_DISPATCHER_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_DISPATCHER_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace stratcom_internal {
+
+    /** \internal Invokes handler functions for the controls that changed between two input states.
+     * Every control owns one bit in a 16-bit mask: bit 0 is the slider, bits 1 to 3 are the X-, Y- and Z-axis
+     * and bits 4 to 15 are the buttons, in the order of their bits in stratcom_button_word. This is also the
+     * order in which events are generated by stratcom_read_input_events().
+     * Registrations are compiled into a single flat array holding the handlers of all controls back to back,
+     * so that dispatching only visits the set bits of the changed mask and never allocates.
+     */
+    class dispatcher {
+    public:
+        static unsigned const CONTROL_SLIDER = 0;
+        static unsigned const CONTROL_AXIS_X = 1;
+        static unsigned const CONTROL_BUTTONS = 4;
+        static unsigned const NUMBER_OF_CONTROLS = 16;
+        static unsigned const CONTROL_ANY = NUMBER_OF_CONTROLS;
+    private:
+        struct handler_entry {
+            stratcom_control_handler handler;
+            void* user_data;
+        };
+        struct registration {
+            unsigned control;                           ///< control index or CONTROL_ANY.
+            handler_entry entry;
+        };
+        typedef std::vector<registration, std_allocator<registration>> registration_list;
+        typedef std::vector<handler_entry, std_allocator<handler_entry>> handler_table;
+
+        registration_list m_registrations;
+        handler_table m_handlers;                       ///< handlers of all controls, grouped by control.
+        std::uint32_t m_offsets[NUMBER_OF_CONTROLS + 1];///< handlers of control i are [m_offsets[i], m_offsets[i+1]).
+        std::uint32_t m_handled_mask;                   ///< bits of all controls with at least one handler.
+    public:
+        explicit dispatcher(allocator const& alloc);
+
+        /** Register a handler for a control.
+         * @param[in] control Index of the control or CONTROL_ANY.
+         * @return false if memory could not be allocated.
+         */
+        bool addHandler(unsigned control, stratcom_control_handler handler, void* user_data);
+
+        /** Invoke the handlers of all controls that differ between old_state and new_state.
+         * Must not be called concurrently with addHandler().
+         */
+        void dispatch(stratcom_input_state const& old_state, stratcom_input_state const& new_state,
+                      stratcom_timestamp timestamp) const;
+    private:
+        void compile();
+
+        dispatcher(dispatcher const&);              // = delete
+        dispatcher& operator=(dispatcher const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_gestures.hpp"
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Duration of a timer wheel tick in microseconds.
+         */
+        stratcom_timestamp const TICK_DURATION = 1000;
+
+        stratcom_button_word const SHIFT_BUTTONS = STRATCOM_BUTTON_SHIFT1 | STRATCOM_BUTTON_SHIFT2 |
+                                                   STRATCOM_BUTTON_SHIFT3;
+        stratcom_button_word const NUMBER_BUTTONS = STRATCOM_BUTTON_1 | STRATCOM_BUTTON_2 | STRATCOM_BUTTON_3 |
+                                                    STRATCOM_BUTTON_4 | STRATCOM_BUTTON_5 | STRATCOM_BUTTON_6;
+
+        std::uint32_t buttonIndex(stratcom_button button)
+        {
+            std::uint32_t index = 0;
+            for(stratcom_button_word b = button; (b & 0x01) == 0; b >>= 1) { ++index; }
+            return index;
+        }
+
+        std::uint64_t tickAtOrAfter(stratcom_timestamp t)
+        {
+            return (t + TICK_DURATION - 1) / TICK_DURATION;
+        }
+    }
+
+    gesture_engine::gesture_engine(allocator const& alloc, std::uint32_t number_of_devices, stratcom_gesture_config const& config,
+                                   stratcom_gesture_callback callback, void* user_data, stratcom_timestamp now)
+        :m_number_of_devices(number_of_devices),
+         m_buttons(createArray<button_state>(alloc, number_of_devices * NUMBER_OF_BUTTONS)),
+         m_shift_buttons(createArray<stratcom_button_word>(alloc, number_of_devices)),
+         m_config(config), m_callback(callback), m_user_data(user_data), m_now(now),
+         m_wheel(now / TICK_DURATION)
+    {
+        if(!isValid()) { return; }
+        for(std::uint32_t i = 0; i < number_of_devices * NUMBER_OF_BUTTONS; ++i) {
+            m_buttons[i].timer.id = i;
+            m_buttons[i].deadline = 0;
+            m_buttons[i].phase = PHASE_IDLE;
+        }
+        for(std::uint32_t i = 0; i < number_of_devices; ++i) {
+            m_shift_buttons[i] = 0;
+        }
+    }
+
+    bool gesture_engine::isValid() const
+    {
+        return m_buttons && m_shift_buttons;
+    }
+
+    bool gesture_engine::processEvents(std::uint32_t device_index, stratcom_input_event const* events)
+    {
+        if(device_index >= m_number_of_devices) {
+            return false;
+        }
+        for(stratcom_input_event const* it = events; it; it = it->next) {
+            if((it->type != STRATCOM_INPUT_EVENT_BUTTON) || (it->desc.button.button == STRATCOM_BUTTON_NONE) ||
+               (it->desc.button.button >= (1u << NUMBER_OF_BUTTONS)))
+            {
+                continue;
+            }
+            stratcom_timestamp const t = (it->timestamp != 0) ? it->timestamp : stratcom_get_timestamp();
+            advance(t);
+            onButton(device_index, it->desc.button.button, (it->desc.button.status != 0), m_now);
+        }
+        return true;
+    }
+
+    void gesture_engine::advance(stratcom_timestamp now)
+    {
+        if(now <= m_now) { return; }
+        m_now = now;
+        m_wheel.advance(now / TICK_DURATION, [this](timer_wheel::timer& timer) { onTimerExpired(timer); });
+    }
+
+    void gesture_engine::onButton(std::uint32_t device_index, stratcom_button button, bool is_pressed,
+                                  stratcom_timestamp t)
+    {
+        std::uint32_t const index = device_index * NUMBER_OF_BUTTONS + buttonIndex(button);
+        button_state& state = m_buttons[index];
+        stratcom_button_word& shift_buttons = m_shift_buttons[device_index];
+        if(button & SHIFT_BUTTONS) {
+            shift_buttons = is_pressed ? (shift_buttons | button) : (shift_buttons & ~button);
+        }
+
+        bool const was_pressed = (state.phase != PHASE_IDLE) && (state.phase != PHASE_WAIT_FOR_SECOND_TAP);
+        if(was_pressed == is_pressed) {
+            // resync events may repeat the current button state
+            return;
+        }
+
+        if(is_pressed) {
+            if(m_config.enable_chords && (button & NUMBER_BUTTONS) && (shift_buttons != 0)) {
+                if(state.phase == PHASE_WAIT_FOR_SECOND_TAP) {
+                    m_wheel.cancel(state.timer);
+                    emit(STRATCOM_GESTURE_TAP, index, 0, t);
+                }
+                state.phase = PHASE_CHORD;
+                emit(STRATCOM_GESTURE_CHORD, index, shift_buttons, t);
+            } else if(state.phase == PHASE_WAIT_FOR_SECOND_TAP) {
+                m_wheel.cancel(state.timer);
+                state.phase = PHASE_PRESSED_SECOND_TAP;
+                emit(STRATCOM_GESTURE_DOUBLE_TAP, index, 0, t);
+            } else {
+                state.phase = PHASE_PRESSED;
+                if(m_config.long_press_time > 0) {
+                    startTimer(state, t + m_config.long_press_time);
+                }
+            }
+        } else {
+            if(state.phase == PHASE_PRESSED) {
+                m_wheel.cancel(state.timer);
+                if(m_config.double_tap_interval > 0) {
+                    state.phase = PHASE_WAIT_FOR_SECOND_TAP;
+                    startTimer(state, t + m_config.double_tap_interval);
+                    return;
+                }
+                emit(STRATCOM_GESTURE_TAP, index, 0, t);
+            }
+            state.phase = PHASE_IDLE;
+        }
+    }
+
+    void gesture_engine::onTimerExpired(timer_wheel::timer& timer)
+    {
+        button_state& state = m_buttons[timer.id];
+        if(state.phase == PHASE_PRESSED) {
+            state.phase = PHASE_LONG_PRESSED;
+            emit(STRATCOM_GESTURE_LONG_PRESS, timer.id, 0, state.deadline);
+        } else if(state.phase == PHASE_WAIT_FOR_SECOND_TAP) {
+            state.phase = PHASE_IDLE;
+            emit(STRATCOM_GESTURE_TAP, timer.id, 0, state.deadline);
+        }
+    }
+
+    void gesture_engine::startTimer(button_state& state, stratcom_timestamp deadline)
+    {
+        state.deadline = deadline;
+        m_wheel.schedule(state.timer, tickAtOrAfter(deadline));
+    }
+
+    void gesture_engine::emit(stratcom_gesture_type type, std::uint32_t state_index,
+                              stratcom_button_word shift_buttons, stratcom_timestamp t)
+    {
+        stratcom_gesture gesture;
+        gesture.type = type;
+        gesture.device_index = state_index / NUMBER_OF_BUTTONS;
+        gesture.button = static_cast<stratcom_button>(1u << (state_index % NUMBER_OF_BUTTONS));
+        gesture.shift_buttons = shift_buttons;
+        gesture.timestamp = t;
+        m_callback(m_user_data, &gesture);
+    }
+}
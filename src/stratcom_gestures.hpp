@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_GESTURES_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_GESTURES_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+#include "stratcom_timer_wheel.hpp"
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Recognizes gestures in the button events of a fixed number of devices.
+     * Each button of each device owns exactly one timer, which is used for both the long press time and the
+     * double tap interval, as a button can only ever wait for one of the two. All timers share a single
+     * timer wheel with a resolution of one millisecond. Deadlines are rounded up to the next tick, so that
+     * gestures are never recognized early.
+     */
+    class gesture_engine {
+    private:
+        enum button_phase {
+            PHASE_IDLE,                                 ///< released.
+            PHASE_PRESSED,                              ///< pressed, waiting for long press time.
+            PHASE_LONG_PRESSED,                         ///< pressed, long press already reported.
+            PHASE_WAIT_FOR_SECOND_TAP,                  ///< released after a tap, waiting for double tap interval.
+            PHASE_PRESSED_SECOND_TAP,                   ///< pressed, double tap already reported.
+            PHASE_CHORD                                 ///< pressed as part of a chord.
+        };
+        struct button_state {
+            timer_wheel::timer timer;
+            stratcom_timestamp deadline;
+            button_phase phase;
+        };
+
+        std::uint32_t m_number_of_devices;
+        allocated_array<button_state> m_buttons;      ///< m_number_of_devices * NUMBER_OF_BUTTONS entries.
+        allocated_array<stratcom_button_word> m_shift_buttons;  ///< held shift buttons per device.
+        stratcom_gesture_config m_config;
+        stratcom_gesture_callback m_callback;
+        void* m_user_data;
+        stratcom_timestamp m_now;
+        timer_wheel m_wheel;
+    public:
+        static std::uint32_t const NUMBER_OF_BUTTONS = 12;
+
+        gesture_engine(allocator const& alloc, std::uint32_t number_of_devices, stratcom_gesture_config const& config,
+                       stratcom_gesture_callback callback, void* user_data, stratcom_timestamp now);
+
+        /** Check whether the button states were allocated successfully.
+         */
+        bool isValid() const;
+
+        /** @see stratcom_gesture_engine_process_events()
+         */
+        bool processEvents(std::uint32_t device_index, stratcom_input_event const* events);
+
+        /** @see stratcom_gesture_engine_advance()
+         */
+        void advance(stratcom_timestamp now);
+
+    private:
+        void onButton(std::uint32_t device_index, stratcom_button button, bool is_pressed, stratcom_timestamp t);
+        void onTimerExpired(timer_wheel::timer& timer);
+        void startTimer(button_state& state, stratcom_timestamp deadline);
+        void emit(stratcom_gesture_type type, std::uint32_t state_index, stratcom_button_word shift_buttons,
+                  stratcom_timestamp t);
+
+        gesture_engine(gesture_engine const&);              // = delete
+        gesture_engine& operator=(gesture_engine const&);   // = delete
+    };
+}
+
+#endif
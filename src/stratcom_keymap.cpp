@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_keymap.hpp"
+
+#include <cstring>
+#include <thread>
+
+namespace stratcom_internal {
+
+    namespace {
+#if defined(__GNUC__)
+        unsigned lowestBit(unsigned word)
+        {
+            return static_cast<unsigned>(__builtin_ctz(word));
+        }
+#else
+        unsigned lowestBit(unsigned word)
+        {
+            unsigned ret = 0;
+            while((word & 1) == 0) { word >>= 1; ++ret; }
+            return ret;
+        }
+#endif
+    }
+
+    keymap::keymap()
+    {
+        std::memset(m_actions, 0, sizeof(m_actions));
+    }
+
+    unsigned keymap::keyIndex(stratcom_button_word button)
+    {
+        return lowestBit(button);
+    }
+
+    bool keymap::compile(stratcom_keymap_entry const* entries, std::size_t number_of_entries)
+    {
+        std::memset(m_actions, 0, sizeof(m_actions));
+        for(std::size_t i = 0; i < number_of_entries; ++i) {
+            stratcom_keymap_entry const& e = entries[i];
+            unsigned const button = static_cast<unsigned>(e.button);
+            bool const valid_button = (button != 0) && ((button & KEY_MASK) == button) &&
+                                      ((button & (button - 1)) == 0);
+            bool const valid_slider = (e.slider == STRATCOM_KEYMAP_ANY_SLIDER) ||
+                                      ((e.slider >= 0) && (e.slider < static_cast<int>(NUMBER_OF_SLIDER_STATES)));
+            bool const valid_shift = (e.shift_buttons == STRATCOM_KEYMAP_ANY_SHIFT) ||
+                                     ((e.shift_buttons & SHIFT_MASK) == e.shift_buttons);
+            if(!valid_button || !valid_slider || !valid_shift) {
+                std::memset(m_actions, 0, sizeof(m_actions));
+                return false;
+            }
+            unsigned const key = lowestBit(button);
+            for(unsigned slider = 0; slider < NUMBER_OF_SLIDER_STATES; ++slider) {
+                if((e.slider != STRATCOM_KEYMAP_ANY_SLIDER) && (e.slider != static_cast<int>(slider))) { continue; }
+                for(unsigned shift = 0; shift < NUMBER_OF_SHIFT_STATES; ++shift) {
+                    stratcom_button_word const shift_buttons = static_cast<stratcom_button_word>(shift << SHIFT_BITS);
+                    if((e.shift_buttons != STRATCOM_KEYMAP_ANY_SHIFT) && (e.shift_buttons != shift_buttons)) {
+                        continue;
+                    }
+                    m_actions[(slider << 6) | (shift << 3) | key] = e.action;
+                }
+            }
+        }
+        return true;
+    }
+
+    keymap_binding::keymap_binding()
+        :m_keymap(nullptr), m_epoch(0)
+    {
+        std::memset(m_actions, 0, sizeof(m_actions));
+    }
+
+    keymap const* keymap_binding::exchange(keymap const* new_keymap)
+    {
+        keymap const* const old_keymap = m_keymap.exchange(new_keymap);
+        // a reader that made the epoch odd before the exchange may still hold the old keymap;
+        // any later reader is guaranteed to see the new one
+        std::uint32_t const epoch = m_epoch.load();
+        if((epoch & 1) != 0) {
+            while(m_epoch.load() == epoch) { std::this_thread::yield(); }
+        }
+        return old_keymap;
+    }
+
+    void keymap_binding::update(stratcom_button_word old_buttons, stratcom_button_word new_buttons,
+                                stratcom_slider_state slider)
+    {
+        unsigned pressed = (new_buttons & ~old_buttons & keymap::KEY_MASK);
+        if(pressed == 0) { return; }
+        m_epoch.fetch_add(1);
+        keymap const* const km = m_keymap.load();
+        while(pressed != 0) {
+            unsigned const key = lowestBit(pressed);
+            m_actions[key] = km ? km->lookup(new_buttons, slider, key) : 0;
+            pressed &= (pressed - 1);
+        }
+        m_epoch.fetch_add(1);
+    }
+
+    std::uint32_t const* keymap_binding::getActions() const
+    {
+        return m_actions;
+    }
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_KEYMAP_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_KEYMAP_HPP_
+
+#include <stratcom.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Compiled keymap.
+     * Holds the action of every key in every layer in a flat table. The eight keys are the buttons in the low
+     * byte of stratcom_button_word, the layers are formed by the slider position and the shift buttons in
+     * bits 8 to 10. The index of an entry is assembled from these bits directly:
+     * <tt>slider << 6 | shift_buttons >> 8 << 3 | key</tt>.
+     */
+    class keymap {
+    public:
+        static unsigned const NUMBER_OF_KEYS = 8;
+        static stratcom_button_word const KEY_MASK = 0x00FF;
+        static stratcom_button_word const SHIFT_MASK = (STRATCOM_BUTTON_SHIFT1 | STRATCOM_BUTTON_SHIFT2 |
+                                                        STRATCOM_BUTTON_SHIFT3);
+    private:
+        static unsigned const SHIFT_BITS = 8;
+        static unsigned const NUMBER_OF_SHIFT_STATES = 8;
+        static unsigned const NUMBER_OF_SLIDER_STATES = 4;
+        static std::size_t const TABLE_SIZE = NUMBER_OF_SLIDER_STATES * NUMBER_OF_SHIFT_STATES * NUMBER_OF_KEYS;
+
+        std::uint32_t m_actions[TABLE_SIZE];
+    public:
+        keymap();
+
+        /** Index of the key of a button.
+         * @param[in] button A single button from KEY_MASK.
+         */
+        static unsigned keyIndex(stratcom_button_word button);
+
+        /** Fill the table from a list of mappings. Later entries take precedence over earlier ones.
+         * @return false if an entry is invalid, in which case the table is left empty.
+         */
+        bool compile(stratcom_keymap_entry const* entries, std::size_t number_of_entries);
+
+        /** Look up the action of a key.
+         * @param[in] buttons The buttons held; only the shift buttons are considered.
+         * @param[in] slider The slider position.
+         * @param[in] key Index of the key, which is the index of its bit in stratcom_button_word.
+         */
+        std::uint32_t lookup(stratcom_button_word buttons, stratcom_slider_state slider, unsigned key) const
+        {
+            return m_actions[((static_cast<unsigned>(slider) & (NUMBER_OF_SLIDER_STATES - 1)) << 6) |
+                             (((buttons & SHIFT_MASK) >> SHIFT_BITS) << 3) | key];
+        }
+    };
+
+    /** \internal The keymap of a device together with the actions of its keys.
+     * The keymap may be swapped from any thread while the device is read. The reading thread marks the
+     * short section in which it accesses the keymap by making an epoch counter odd, so that swapping only has
+     * to wait for that section to end before the previous keymap is guaranteed to be unused. Reading never waits.
+     * The action of a key is resolved when it is pressed and kept after it is released, so that the release
+     * reports the same action as the press, even if the layer changed in between.
+     */
+    class keymap_binding {
+    private:
+        std::atomic<keymap const*> m_keymap;
+        std::atomic<std::uint32_t> m_epoch;             ///< odd while the reading thread accesses the keymap.
+        std::uint32_t m_actions[keymap::NUMBER_OF_KEYS];    ///< action of the last press of each key.
+    public:
+        keymap_binding();
+
+        /** Replace the keymap. May be called from any thread.
+         * @return The previous keymap, which is no longer accessed when this function returns.
+         */
+        keymap const* exchange(keymap const* new_keymap);
+
+        /** Resolve the actions of the keys pressed by a change of buttons. Called by the reading thread.
+         */
+        void update(stratcom_button_word old_buttons, stratcom_button_word new_buttons, stratcom_slider_state slider);
+
+        /** Actions of the keys, indexed by key.
+         */
+        std::uint32_t const* getActions() const;
+
+    private:
+        keymap_binding(keymap_binding const&);              // = delete
+        keymap_binding& operator=(keymap_binding const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_latency.hpp"
+
+#include <limits>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Map an LED to its index. LEDs occupy two adjacent bits each in the LED state.
+         */
+        unsigned ledIndex(stratcom_button_led led)
+        {
+            unsigned ret = 0;
+            while((static_cast<unsigned>(led) >> (2 * ret)) > 1) { ++ret; }
+            return ret;
+        }
+
+        unsigned bucketIndex(std::uint64_t latency)
+        {
+            unsigned ret = 0;
+            while((ret + 1 < STRATCOM_LATENCY_HISTOGRAM_BUCKETS) && ((latency >> (ret + 1)) != 0)) { ++ret; }
+            return ret;
+        }
+    }
+
+    led_latency_tracker::led_latency_tracker(std::uint16_t flushed_state)
+        :m_flushed_state(flushed_state)
+    {
+        for(auto& p : m_pending) { p.store(0, std::memory_order_relaxed); }
+        resetHistogram();
+    }
+
+    void led_latency_tracker::onButtonsPressed(stratcom_button_word pressed, stratcom_timestamp arrival)
+    {
+        while(pressed != 0) {
+            stratcom_button_word const button = static_cast<stratcom_button_word>(pressed & (~pressed + 1));
+            pressed = static_cast<stratcom_button_word>(pressed & ~button);
+            stratcom_button_led const led = stratcom_get_led_for_button(static_cast<stratcom_button>(button));
+            if(led != STRATCOM_LEDBUTTON_NONE) {
+                m_pending[ledIndex(led)].store(arrival, std::memory_order_release);
+            }
+        }
+    }
+
+    void led_latency_tracker::onLedStateFlushed(std::uint16_t led_state, std::uint16_t ignore_mask,
+                                                stratcom_timestamp completion)
+    {
+        std::uint16_t const changed = static_cast<std::uint16_t>((led_state ^ m_flushed_state) & ~ignore_mask);
+        m_flushed_state = led_state;
+        for(unsigned i = 0; i < NUMBER_OF_LEDS; ++i) {
+            stratcom_timestamp arrival = m_pending[i].load(std::memory_order_acquire);
+            if(arrival == 0) { continue; }
+            stratcom_timestamp const age = (completion > arrival) ? (completion - arrival) : 0;
+            if(age > MAX_PENDING_AGE) {
+                // the press was never answered; a newer press might have replaced it in the meantime
+                m_pending[i].compare_exchange_strong(arrival, 0, std::memory_order_acq_rel);
+            } else if((changed & (0x3u << (2 * i))) != 0) {
+                if(m_pending[i].compare_exchange_strong(arrival, 0, std::memory_order_acq_rel)) {
+                    record(age);
+                }
+            }
+        }
+    }
+
+    void led_latency_tracker::record(std::uint64_t latency)
+    {
+        m_buckets[bucketIndex(latency)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(latency, std::memory_order_relaxed);
+        std::uint64_t min = m_min.load(std::memory_order_relaxed);
+        while((latency < min) && !m_min.compare_exchange_weak(min, latency, std::memory_order_relaxed)) {}
+        std::uint64_t max = m_max.load(std::memory_order_relaxed);
+        while((latency > max) && !m_max.compare_exchange_weak(max, latency, std::memory_order_relaxed)) {}
+        m_count.fetch_add(1, std::memory_order_release);
+    }
+
+    void led_latency_tracker::getHistogram(stratcom_latency_histogram& out_histogram) const
+    {
+        out_histogram.count = m_count.load(std::memory_order_acquire);
+        out_histogram.sum = m_sum.load(std::memory_order_relaxed);
+        std::uint64_t const min = m_min.load(std::memory_order_relaxed);
+        out_histogram.min = (min == std::numeric_limits<std::uint64_t>::max()) ? 0 : min;
+        out_histogram.max = m_max.load(std::memory_order_relaxed);
+        for(unsigned i = 0; i < STRATCOM_LATENCY_HISTOGRAM_BUCKETS; ++i) {
+            out_histogram.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void led_latency_tracker::resetHistogram()
+    {
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+        for(auto& b : m_buckets) { b.store(0, std::memory_order_relaxed); }
+    }
+}
@@ -0,0 +1,84 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_LATENCY_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_LATENCY_HPP_
+
+#include <stratcom.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Measures the time from a button press to the LED feedback for that button.
+     * Presses are recorded by the thread reading from the device and matched by the thread flushing the
+     * LED state, which need not be the same thread. All state shared between the two is atomic.
+     * @see stratcom_enable_led_latency_measurement()
+     */
+    class led_latency_tracker {
+    private:
+        static unsigned const NUMBER_OF_LEDS = 7;
+        /** Presses older than this in microseconds are not considered answered by an LED change.
+         */
+        static stratcom_timestamp const MAX_PENDING_AGE = 1000000;
+
+        std::atomic<stratcom_timestamp> m_pending[NUMBER_OF_LEDS];  ///< arrival time of the last unmatched press
+                                                                    ///  for each LED; 0 if there is none.
+        std::uint16_t m_flushed_state;                  ///< LED state sent by the last successful flush.
+        std::atomic<std::uint64_t> m_count;
+        std::atomic<std::uint64_t> m_sum;
+        std::atomic<std::uint64_t> m_min;
+        std::atomic<std::uint64_t> m_max;
+        std::atomic<std::uint64_t> m_buckets[STRATCOM_LATENCY_HISTOGRAM_BUCKETS];
+    public:
+        /** @param[in] flushed_state The LED state of the physical device.
+         */
+        explicit led_latency_tracker(std::uint16_t flushed_state);
+
+        /** Record the buttons that were pressed in an input report.
+         * @param[in] pressed Buttons that changed from released to pressed.
+         * @param[in] arrival Arrival time of the input report.
+         */
+        void onButtonsPressed(stratcom_button_word pressed, stratcom_timestamp arrival);
+
+        /** Match pending presses against a successfully flushed LED state.
+         * Pending presses older than MAX_PENDING_AGE are dropped instead of being matched.
+         * @param[in] led_state The LED state that was sent to the device.
+         * @param[in] ignore_mask Bits of led_state that were changed by the library itself rather than by
+         *                        the application. Changes of these bits do not match presses.
+         * @param[in] completion Time at which the device acknowledged the LED state.
+         */
+        void onLedStateFlushed(std::uint16_t led_state, std::uint16_t ignore_mask, stratcom_timestamp completion);
+
+        void getHistogram(stratcom_latency_histogram& out_histogram) const;
+
+        void resetHistogram();
+
+    private:
+        void record(std::uint64_t latency);
+
+        led_latency_tracker(led_latency_tracker const&);              // = delete
+        led_latency_tracker& operator=(led_latency_tracker const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,459 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_log.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/** \internal
+ * Input Log File Format.
+ * All multi-byte integers are stored in little endian byte order. Varints use the LEB128 encoding, with
+ * 7 bits of payload per byte and the highest bit set on all but the last byte.
+ *
+ *  - Header: The four characters 'SCLG', followed by the format version byte and three zero bytes.
+ *  - Records: One record per input state that differs from its predecessor.
+ *  - Index: Optional. One entry per keyframe record, consisting of three 64-bit integers:
+ *           The file offset of the keyframe, its timestamp and the number of records preceding it.
+ *  - Trailer: Optional. The file offset of the index and the total number of records as 64-bit integers,
+ *             followed by the four characters 'SCLI', the format version byte and three zero bytes.
+ *
+ * A record starts with a tag byte, which determines the fields that follow:
+ *     KSSL ZYXB
+ * B: button diff present, X/Y/Z: axis diff present, L: slider changed, SS: new slider state,
+ * K: keyframe. The tag is followed by the varint time in microseconds since the previous record, then
+ * the button diff as a 16-bit XOR mask against the previous button word, then the axis diffs as
+ * zigzag-encoded varints of the difference to the previous axis value.
+ * Keyframes are encoded like regular records, but against an all-zero input state at time 0.
+ * They can therefore be decoded without any of the preceding records.
+ */
+namespace stratcom_internal {
+
+    namespace {
+        std::size_t const BUFFER_SIZE = 64 * 1024;
+        std::uint32_t const DEFAULT_KEYFRAME_INTERVAL = 4096;
+        std::uint8_t const FORMAT_VERSION = 1;
+
+        std::size_t const HEADER_SIZE = 8;
+        std::size_t const INDEX_ENTRY_SIZE = 24;
+        std::size_t const TRAILER_SIZE = 24;
+        /** Upper bound for the size of a single encoded record. */
+        std::size_t const MAX_RECORD_SIZE = 1 + 10 + 2 + 3 * 3;
+
+        std::uint8_t const TAG_BUTTONS      = 0x01;
+        std::uint8_t const TAG_AXIS_X       = 0x02;
+        std::uint8_t const TAG_AXIS_Y       = 0x04;
+        std::uint8_t const TAG_AXIS_Z       = 0x08;
+        std::uint8_t const TAG_SLIDER       = 0x10;
+        unsigned const TAG_SLIDER_SHIFT     = 5;
+        std::uint8_t const TAG_KEYFRAME     = 0x80;
+
+        std::uint64_t zigzagEncode(std::int32_t v)
+        {
+            return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+        }
+
+        std::int32_t zigzagDecode(std::uint64_t v)
+        {
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(v >> 1) ^
+                                             (~static_cast<std::uint32_t>(v & 1) + 1));
+        }
+
+        void writeUint64(std::uint8_t* dst, std::uint64_t v)
+        {
+            for(int i = 0; i < 8; ++i) { dst[i] = static_cast<std::uint8_t>(v >> (8 * i)); }
+        }
+
+        std::uint64_t readUint64(std::uint8_t const* src)
+        {
+            std::uint64_t v = 0;
+            for(int i = 0; i < 8; ++i) { v |= static_cast<std::uint64_t>(src[i]) << (8 * i); }
+            return v;
+        }
+
+        stratcom_input_state zeroState()
+        {
+            stratcom_input_state state;
+            std::memset(&state, 0, sizeof(state));
+            return state;
+        }
+    }
+
+    log_writer::log_writer(allocator const& alloc, std::uint32_t keyframe_interval)
+        :m_allocator(alloc), m_file(nullptr), m_buffer_fill(0), m_flushed_bytes(0),
+         m_keyframe_interval((keyframe_interval > 0) ? keyframe_interval : DEFAULT_KEYFRAME_INTERVAL),
+         m_record_count(0), m_last_timestamp(0), m_last_state(zeroState()), m_index(std_allocator<log_index_entry>(alloc)),
+         m_failed(false)
+    {
+    }
+
+    log_writer::~log_writer()
+    {
+        if(m_file) { close(); }
+    }
+
+    bool log_writer::open(char const* filename)
+    {
+        m_buffer.reset(createArray<std::uint8_t>(m_allocator, BUFFER_SIZE));
+        if(!m_buffer) { return false; }
+        m_file = std::fopen(filename, "wb");
+        if(!m_file) { return false; }
+        std::uint8_t const header[HEADER_SIZE] = { 'S', 'C', 'L', 'G', FORMAT_VERSION, 0, 0, 0 };
+        for(std::size_t i = 0; i < HEADER_SIZE; ++i) { put(header[i]); }
+        return true;
+    }
+
+    stratcom_return log_writer::append(stratcom_timestamp timestamp, stratcom_input_state const& state)
+    {
+        if(m_failed || (timestamp < m_last_timestamp)) {
+            return STRATCOM_RET_ERROR;
+        }
+        bool const is_keyframe = ((m_record_count % m_keyframe_interval) == 0);
+        if(!is_keyframe && (state.buttons == m_last_state.buttons) && (state.axisX == m_last_state.axisX) &&
+           (state.axisY == m_last_state.axisY) && (state.axisZ == m_last_state.axisZ) &&
+           (state.slider == m_last_state.slider))
+        {
+            return STRATCOM_RET_SUCCESS;
+        }
+        if((m_buffer_fill + MAX_RECORD_SIZE > BUFFER_SIZE) && !flush()) {
+            return STRATCOM_RET_ERROR;
+        }
+        if(is_keyframe) {
+            log_index_entry entry;
+            entry.offset = m_flushed_bytes + m_buffer_fill;
+            entry.timestamp = timestamp;
+            entry.record_number = m_record_count;
+            try {
+                m_index.push_back(entry);
+            } catch(std::bad_alloc&) {
+                return STRATCOM_RET_ERROR;
+            }
+        }
+
+        stratcom_input_state const base = is_keyframe ? zeroState() : m_last_state;
+        stratcom_timestamp const base_timestamp = is_keyframe ? 0 : m_last_timestamp;
+        std::uint8_t tag = (is_keyframe ? TAG_KEYFRAME : 0);
+        if(state.buttons != base.buttons) { tag |= TAG_BUTTONS; }
+        if(state.axisX != base.axisX)     { tag |= TAG_AXIS_X; }
+        if(state.axisY != base.axisY)     { tag |= TAG_AXIS_Y; }
+        if(state.axisZ != base.axisZ)     { tag |= TAG_AXIS_Z; }
+        if(state.slider != base.slider) {
+            tag |= TAG_SLIDER | static_cast<std::uint8_t>((state.slider & 0x03) << TAG_SLIDER_SHIFT);
+        }
+
+        put(tag);
+        putVarint(timestamp - base_timestamp);
+        if(tag & TAG_BUTTONS) {
+            stratcom_button_word const diff = (state.buttons ^ base.buttons);
+            put(static_cast<std::uint8_t>(diff & 0xff));
+            put(static_cast<std::uint8_t>(diff >> 8));
+        }
+        if(tag & TAG_AXIS_X) { putVarint(zigzagEncode(state.axisX - base.axisX)); }
+        if(tag & TAG_AXIS_Y) { putVarint(zigzagEncode(state.axisY - base.axisY)); }
+        if(tag & TAG_AXIS_Z) { putVarint(zigzagEncode(state.axisZ - base.axisZ)); }
+
+        m_last_timestamp = timestamp;
+        m_last_state = state;
+        ++m_record_count;
+        return STRATCOM_RET_SUCCESS;
+    }
+
+    bool log_writer::close()
+    {
+        std::uint64_t const index_offset = m_flushed_bytes + m_buffer_fill;
+        std::uint8_t entry[INDEX_ENTRY_SIZE];
+        for(auto const& e : m_index) {
+            if((m_buffer_fill + INDEX_ENTRY_SIZE > BUFFER_SIZE) && !flush()) { break; }
+            writeUint64(entry, e.offset);
+            writeUint64(entry + 8, e.timestamp);
+            writeUint64(entry + 16, e.record_number);
+            for(std::size_t i = 0; i < INDEX_ENTRY_SIZE; ++i) { put(entry[i]); }
+        }
+        if((m_buffer_fill + TRAILER_SIZE <= BUFFER_SIZE) || flush()) {
+            std::uint8_t trailer[TRAILER_SIZE] = { 0 };
+            writeUint64(trailer, index_offset);
+            writeUint64(trailer + 8, m_record_count);
+            trailer[16] = 'S'; trailer[17] = 'C'; trailer[18] = 'L'; trailer[19] = 'I';
+            trailer[20] = FORMAT_VERSION;
+            for(std::size_t i = 0; i < TRAILER_SIZE; ++i) { put(trailer[i]); }
+        }
+        flush();
+        if(std::fclose(m_file) != 0) { m_failed = true; }
+        m_file = nullptr;
+        return !m_failed;
+    }
+
+    bool log_writer::flush()
+    {
+        if(!m_failed && (m_buffer_fill > 0)) {
+            if(std::fwrite(m_buffer.get(), 1, m_buffer_fill, m_file) != m_buffer_fill) {
+                m_failed = true;
+            }
+            m_flushed_bytes += m_buffer_fill;
+            m_buffer_fill = 0;
+        }
+        return !m_failed;
+    }
+
+    void log_writer::put(std::uint8_t b)
+    {
+        m_buffer[m_buffer_fill++] = b;
+    }
+
+    void log_writer::putVarint(std::uint64_t v)
+    {
+        while(v >= 0x80) {
+            put(static_cast<std::uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        put(static_cast<std::uint8_t>(v));
+    }
+
+
+    log_reader::log_reader(allocator const& alloc)
+        :m_allocator(alloc), m_file(nullptr), m_buffer_pos(0), m_buffer_end(0), m_buffer_offset(0), m_data_end(0),
+         m_index(std_allocator<log_index_entry>(alloc)), m_record_count(0), m_lookahead_front(0), m_lookahead_size(0)
+    {
+        m_decoder.timestamp = 0;
+        m_decoder.state = zeroState();
+    }
+
+    log_reader::~log_reader()
+    {
+        if(m_file) { std::fclose(m_file); }
+    }
+
+    bool log_reader::open(char const* filename)
+    {
+        m_buffer.reset(createArray<std::uint8_t>(m_allocator, BUFFER_SIZE));
+        if(!m_buffer) { return false; }
+        m_file = std::fopen(filename, "rb");
+        if(!m_file) { return false; }
+
+        std::uint8_t header[HEADER_SIZE];
+        if((std::fread(header, 1, HEADER_SIZE, m_file) != HEADER_SIZE) ||
+           (std::memcmp(header, "SCLG", 4) != 0) || (header[4] != FORMAT_VERSION))
+        {
+            return false;
+        }
+        if(std::fseek(m_file, 0, SEEK_END) != 0) { return false; }
+        long const file_size = std::ftell(m_file);
+        if(file_size < 0) { return false; }
+
+        try {
+            if(!loadIndex(static_cast<std::uint64_t>(file_size))) {
+                // the writer did not finish the file; recover what was written
+                m_data_end = static_cast<std::uint64_t>(file_size);
+                if(!rebuildIndex()) { return false; }
+            }
+        } catch(std::bad_alloc&) {
+            return false;
+        }
+        return seekTo(HEADER_SIZE);
+    }
+
+    std::uint64_t log_reader::getRecordCount() const
+    {
+        return m_record_count;
+    }
+
+    stratcom_return log_reader::next(stratcom_timestamp& out_timestamp, stratcom_input_state& out_state)
+    {
+        if(m_lookahead_size > 0) {
+            record const& r = m_lookahead[m_lookahead_front];
+            out_timestamp = r.timestamp;
+            out_state = r.state;
+            m_lookahead_front = (m_lookahead_front + 1) % 2;
+            --m_lookahead_size;
+            return STRATCOM_RET_SUCCESS;
+        }
+        bool is_keyframe;
+        if(!decode(is_keyframe)) {
+            return STRATCOM_RET_NO_DATA;
+        }
+        out_timestamp = m_decoder.timestamp;
+        out_state = m_decoder.state;
+        return STRATCOM_RET_SUCCESS;
+    }
+
+    stratcom_return log_reader::seek(stratcom_timestamp t)
+    {
+        if(m_index.empty()) {
+            return STRATCOM_RET_ERROR;
+        }
+        auto it = std::upper_bound(m_index.begin(), m_index.end(), t,
+                                   [](stratcom_timestamp lhs, log_index_entry const& rhs)
+                                   { return lhs < rhs.timestamp; });
+        if(it != m_index.begin()) { --it; }
+        m_lookahead_front = 0;
+        m_lookahead_size = 0;
+        bool is_keyframe;
+        if(!seekTo(it->offset) || !decode(is_keyframe)) {
+            return STRATCOM_RET_ERROR;
+        }
+        // decode forward to the last record at or before t
+        m_lookahead[0] = m_decoder;
+        m_lookahead_size = 1;
+        while(decode(is_keyframe)) {
+            if(m_decoder.timestamp > t) {
+                m_lookahead[1] = m_decoder;
+                m_lookahead_size = 2;
+                break;
+            }
+            m_lookahead[0] = m_decoder;
+        }
+        return STRATCOM_RET_SUCCESS;
+    }
+
+    bool log_reader::loadIndex(std::uint64_t file_size)
+    {
+        if(file_size < HEADER_SIZE + TRAILER_SIZE) { return false; }
+        std::uint8_t trailer[TRAILER_SIZE];
+        if((std::fseek(m_file, static_cast<long>(file_size - TRAILER_SIZE), SEEK_SET) != 0) ||
+           (std::fread(trailer, 1, TRAILER_SIZE, m_file) != TRAILER_SIZE) ||
+           (std::memcmp(trailer + 16, "SCLI", 4) != 0) || (trailer[20] != FORMAT_VERSION))
+        {
+            return false;
+        }
+        std::uint64_t const index_offset = readUint64(trailer);
+        std::uint64_t const index_end = file_size - TRAILER_SIZE;
+        if((index_offset < HEADER_SIZE) || (index_offset > index_end) ||
+           (((index_end - index_offset) % INDEX_ENTRY_SIZE) != 0))
+        {
+            return false;
+        }
+        m_index.resize(static_cast<std::size_t>((index_end - index_offset) / INDEX_ENTRY_SIZE));
+        if(std::fseek(m_file, static_cast<long>(index_offset), SEEK_SET) != 0) { return false; }
+        std::uint8_t entry[INDEX_ENTRY_SIZE];
+        for(auto& e : m_index) {
+            if(std::fread(entry, 1, INDEX_ENTRY_SIZE, m_file) != INDEX_ENTRY_SIZE) { return false; }
+            e.offset = readUint64(entry);
+            e.timestamp = readUint64(entry + 8);
+            e.record_number = readUint64(entry + 16);
+        }
+        m_data_end = index_offset;
+        m_record_count = readUint64(trailer + 8);
+        return true;
+    }
+
+    bool log_reader::rebuildIndex()
+    {
+        m_index.clear();
+        m_record_count = 0;
+        if(!seekTo(HEADER_SIZE)) { return false; }
+        for(;;) {
+            log_index_entry entry;
+            entry.offset = tell();
+            bool is_keyframe;
+            if(!decode(is_keyframe)) { break; }
+            if(is_keyframe) {
+                entry.timestamp = m_decoder.timestamp;
+                entry.record_number = m_record_count;
+                m_index.push_back(entry);
+            }
+            ++m_record_count;
+        }
+        return true;
+    }
+
+    std::uint64_t log_reader::tell() const
+    {
+        return m_buffer_offset + m_buffer_pos;
+    }
+
+    bool log_reader::seekTo(std::uint64_t offset)
+    {
+        if((offset >= m_buffer_offset) && (offset <= m_buffer_offset + m_buffer_end)) {
+            m_buffer_pos = static_cast<std::size_t>(offset - m_buffer_offset);
+            return true;
+        }
+        if(std::fseek(m_file, static_cast<long>(offset), SEEK_SET) != 0) { return false; }
+        m_buffer_offset = offset;
+        m_buffer_pos = 0;
+        m_buffer_end = 0;
+        return true;
+    }
+
+    bool log_reader::get(std::uint8_t& b)
+    {
+        if(tell() >= m_data_end) { return false; }
+        if(m_buffer_pos == m_buffer_end) {
+            m_buffer_offset += m_buffer_end;
+            m_buffer_pos = 0;
+            m_buffer_end = std::fread(m_buffer.get(), 1, BUFFER_SIZE, m_file);
+            if(m_buffer_end == 0) { return false; }
+        }
+        b = m_buffer[m_buffer_pos++];
+        return true;
+    }
+
+    bool log_reader::getVarint(std::uint64_t& v)
+    {
+        v = 0;
+        for(unsigned shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b;
+            if(!get(b)) { return false; }
+            v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if((b & 0x80) == 0) { return true; }
+        }
+        return false;
+    }
+
+    bool log_reader::decode(bool& out_is_keyframe)
+    {
+        std::uint8_t tag;
+        std::uint64_t time_delta;
+        if(!get(tag) || !getVarint(time_delta)) { return false; }
+        out_is_keyframe = ((tag & TAG_KEYFRAME) != 0);
+        record r;
+        if(out_is_keyframe) {
+            r.timestamp = 0;
+            r.state = zeroState();
+        } else {
+            r = m_decoder;
+        }
+        r.timestamp += time_delta;
+        if(tag & TAG_BUTTONS) {
+            std::uint8_t lo, hi;
+            if(!get(lo) || !get(hi)) { return false; }
+            r.state.buttons ^= static_cast<stratcom_button_word>(lo | (hi << 8));
+        }
+        std::uint64_t v;
+        if(tag & TAG_AXIS_X) {
+            if(!getVarint(v)) { return false; }
+            r.state.axisX = static_cast<stratcom_axis_word>(r.state.axisX + zigzagDecode(v));
+        }
+        if(tag & TAG_AXIS_Y) {
+            if(!getVarint(v)) { return false; }
+            r.state.axisY = static_cast<stratcom_axis_word>(r.state.axisY + zigzagDecode(v));
+        }
+        if(tag & TAG_AXIS_Z) {
+            if(!getVarint(v)) { return false; }
+            r.state.axisZ = static_cast<stratcom_axis_word>(r.state.axisZ + zigzagDecode(v));
+        }
+        if(tag & TAG_SLIDER) {
+            r.state.slider = static_cast<stratcom_slider_state>((tag >> TAG_SLIDER_SHIFT) & 0x03);
+        }
+        m_decoder = r;
+        return true;
+    }
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_LOG_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_LOG_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace stratcom_internal {
+
+    /** \internal Entry of the keyframe index of an input log.
+     */
+    struct log_index_entry {
+        std::uint64_t offset;                           ///< file offset of the keyframe record.
+        stratcom_timestamp timestamp;                   ///< timestamp of the keyframe record.
+        std::uint64_t record_number;                    ///< number of records preceding the keyframe.
+    };
+
+    typedef std::vector<log_index_entry, std_allocator<log_index_entry>> log_index;
+
+    /** \internal Streaming writer for delta-encoded input logs.
+     * Records are encoded into a large buffer that is written to the file whenever it fills up.
+     * The keyframe index is kept in memory and appended to the file upon closing.
+     * See stratcom_log.cpp for a description of the file format.
+     */
+    class log_writer {
+    private:
+        allocator m_allocator;
+        std::FILE* m_file;
+        allocated_array<std::uint8_t> m_buffer;
+        std::size_t m_buffer_fill;
+        std::uint64_t m_flushed_bytes;                  ///< bytes already written to the file.
+        std::uint32_t m_keyframe_interval;
+        std::uint64_t m_record_count;
+        stratcom_timestamp m_last_timestamp;
+        stratcom_input_state m_last_state;
+        log_index m_index;
+        bool m_failed;                                  ///< true after a write error.
+    public:
+        log_writer(allocator const& alloc, std::uint32_t keyframe_interval);
+        ~log_writer();
+
+        /** Create the log file and write the file header.
+         */
+        bool open(char const* filename);
+
+        /** @see stratcom_log_writer_append()
+         */
+        stratcom_return append(stratcom_timestamp timestamp, stratcom_input_state const& state);
+
+        /** Write all buffered records and the keyframe index and close the file.
+         */
+        bool close();
+
+    private:
+        bool flush();
+        void put(std::uint8_t b);
+        void putVarint(std::uint64_t v);
+
+        log_writer(log_writer const&);              // = delete
+        log_writer& operator=(log_writer const&);   // = delete
+    };
+
+    /** \internal Reader for input logs written by log_writer.
+     * The file is read through a large buffer. Seeking uses the keyframe index, which is read from the
+     * end of the file or, if the writer did not close the file properly, rebuilt by scanning all records.
+     */
+    class log_reader {
+    private:
+        struct record {
+            stratcom_timestamp timestamp;
+            stratcom_input_state state;
+        };
+
+        allocator m_allocator;
+        std::FILE* m_file;
+        allocated_array<std::uint8_t> m_buffer;
+        std::size_t m_buffer_pos;
+        std::size_t m_buffer_end;
+        std::uint64_t m_buffer_offset;                  ///< file offset of the first byte in the buffer.
+        std::uint64_t m_data_end;                       ///< file offset of the end of the record data.
+        log_index m_index;
+        std::uint64_t m_record_count;
+        record m_decoder;                               ///< the most recently decoded record.
+        record m_lookahead[2];                          ///< records decoded ahead of time while seeking.
+        std::size_t m_lookahead_front;
+        std::size_t m_lookahead_size;
+    public:
+        explicit log_reader(allocator const& alloc);
+        ~log_reader();
+
+        /** Open a log file and load or rebuild its keyframe index.
+         */
+        bool open(char const* filename);
+
+        std::uint64_t getRecordCount() const;
+
+        /** @see stratcom_log_reader_next()
+         */
+        stratcom_return next(stratcom_timestamp& out_timestamp, stratcom_input_state& out_state);
+
+        /** @see stratcom_log_reader_seek()
+         */
+        stratcom_return seek(stratcom_timestamp t);
+
+    private:
+        bool loadIndex(std::uint64_t file_size);
+        bool rebuildIndex();
+        std::uint64_t tell() const;
+        bool seekTo(std::uint64_t offset);
+        bool get(std::uint8_t& b);
+        bool getVarint(std::uint64_t& v);
+        bool decode(bool& out_is_keyframe);
+
+        log_reader(log_reader const&);              // = delete
+        log_reader& operator=(log_reader const&);   // = delete
+    };
+}
+
+#endif
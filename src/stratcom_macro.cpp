@@ -0,0 +1,190 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_macro.hpp"
+
+namespace stratcom_internal {
+
+    namespace {
+        /** The buttons 1 to 6, which select macro slots 0 to 5.
+         */
+        stratcom_button_word const SLOT_BUTTONS = 0x003f;
+        stratcom_button_word const ALL_BUTTONS = 0x0fff;
+
+        unsigned lowestBit(unsigned mask)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned ret = 0;
+            while((mask & 1) == 0) {
+                mask >>= 1;
+                ++ret;
+            }
+            return ret;
+#endif
+        }
+    }
+
+    macro_recorder::macro_recorder(allocator const& alloc, std::uint32_t capacity)
+        :m_steps(createArray<step>(alloc, static_cast<std::size_t>(capacity) * NUMBER_OF_SLOTS)),
+         m_capacity(capacity), m_armed(false), m_recording_slot(-1), m_recording_start(0), m_ignored(0),
+         m_playing_slot(-1), m_playback_position(0), m_playback_start(0)
+    {
+        for(unsigned i = 0; i < NUMBER_OF_SLOTS; ++i) {
+            m_length[i] = 0;
+        }
+    }
+
+    bool macro_recorder::isValid() const
+    {
+        return static_cast<bool>(m_steps);
+    }
+
+    std::uint32_t macro_recorder::getLength(unsigned slot) const
+    {
+        return m_length[slot];
+    }
+
+    void macro_recorder::clear(unsigned slot)
+    {
+        m_length[slot] = 0;
+        if(m_playing_slot == static_cast<int>(slot)) {
+            m_playing_slot = -1;
+        }
+    }
+
+    macro_recorder::recording_change macro_recorder::onInput(stratcom_input_state const& old_state,
+                                                             stratcom_input_state const& new_state,
+                                                             stratcom_timestamp timestamp)
+    {
+        stratcom_button_word const changed = static_cast<stratcom_button_word>(old_state.buttons ^ new_state.buttons);
+        stratcom_button_word const pressed = static_cast<stratcom_button_word>(changed & new_state.buttons);
+        if(!m_armed) {
+            if(pressed & STRATCOM_BUTTON_REC) {
+                m_armed = true;
+                m_recording_slot = -1;
+                m_playing_slot = -1;
+                return RECORDING_ARMED;
+            }
+            unsigned const trigger = pressed & SLOT_BUTTONS;
+            for(unsigned mask = trigger; mask != 0; mask &= (mask - 1)) {
+                unsigned const slot = lowestBit(mask);
+                if(m_length[slot] != 0) {
+                    m_playing_slot = static_cast<int>(slot);
+                    m_playback_position = 0;
+                    m_playback_start = timestamp;
+                    break;
+                }
+            }
+            return RECORDING_UNCHANGED;
+        }
+
+        if((changed & STRATCOM_BUTTON_REC) && !(new_state.buttons & STRATCOM_BUTTON_REC)) {
+            m_armed = false;
+            m_recording_slot = -1;
+            m_ignored = 0;
+            return RECORDING_FINISHED;
+        }
+        if(m_recording_slot < 0) {
+            if(pressed & SLOT_BUTTONS) {
+                unsigned const slot = lowestBit(pressed & SLOT_BUTTONS);
+                m_recording_slot = static_cast<int>(slot);
+                m_length[slot] = 0;
+                m_recording_start = timestamp;
+                m_ignored = static_cast<stratcom_button_word>(1u << slot);
+            }
+            return RECORDING_UNCHANGED;
+        }
+
+        if(old_state.axisX != new_state.axisX) {
+            record(timestamp, STRATCOM_INPUT_EVENT_AXIS, STRATCOM_AXIS_X, new_state.axisX);
+        }
+        if(old_state.axisY != new_state.axisY) {
+            record(timestamp, STRATCOM_INPUT_EVENT_AXIS, STRATCOM_AXIS_Y, new_state.axisY);
+        }
+        if(old_state.axisZ != new_state.axisZ) {
+            record(timestamp, STRATCOM_INPUT_EVENT_AXIS, STRATCOM_AXIS_Z, new_state.axisZ);
+        }
+        unsigned const recorded = changed & ALL_BUTTONS & ~(m_ignored | STRATCOM_BUTTON_REC);
+        for(unsigned mask = recorded; mask != 0; mask &= (mask - 1)) {
+            unsigned const b = (1u << lowestBit(mask));
+            record(timestamp, STRATCOM_INPUT_EVENT_BUTTON, b, ((new_state.buttons & b) != 0) ? 1 : 0);
+        }
+        // the selecting button is recorded again once it was released
+        m_ignored = static_cast<stratcom_button_word>(m_ignored & new_state.buttons);
+        return RECORDING_UNCHANGED;
+    }
+
+    void macro_recorder::record(stratcom_timestamp timestamp, stratcom_input_event_type type, unsigned control,
+                                std::int32_t status)
+    {
+        std::uint32_t& length = m_length[m_recording_slot];
+        stratcom_timestamp const offset = timestamp - m_recording_start;
+        if((length == m_capacity) || (offset > 0xffffffffu)) {
+            // the macro is full; further changes are dropped
+            return;
+        }
+        step& s = m_steps[static_cast<std::size_t>(m_recording_slot) * m_capacity + length];
+        s.offset = static_cast<std::uint32_t>(offset);
+        s.type = static_cast<std::uint16_t>(type);
+        s.control = static_cast<std::uint16_t>(control);
+        s.status = status;
+        ++length;
+    }
+
+    bool macro_recorder::isArmed() const
+    {
+        return m_armed;
+    }
+
+    bool macro_recorder::isPlaying() const
+    {
+        return m_playing_slot >= 0;
+    }
+
+    stratcom_timestamp macro_recorder::getNextDueTime() const
+    {
+        return m_playback_start +
+               m_steps[static_cast<std::size_t>(m_playing_slot) * m_capacity + m_playback_position].offset;
+    }
+
+    std::size_t macro_recorder::takeDueSteps(stratcom_timestamp now, step const*& out_steps,
+                                             stratcom_timestamp& out_start)
+    {
+        if(m_playing_slot < 0) {
+            return 0;
+        }
+        step const* const steps = &m_steps[static_cast<std::size_t>(m_playing_slot) * m_capacity];
+        std::uint32_t const length = m_length[m_playing_slot];
+        std::uint32_t const first = m_playback_position;
+        while((m_playback_position < length) && (m_playback_start + steps[m_playback_position].offset <= now)) {
+            ++m_playback_position;
+        }
+        out_steps = steps + first;
+        out_start = m_playback_start;
+        if(m_playback_position == length) {
+            m_playing_slot = -1;
+        }
+        return m_playback_position - first;
+    }
+}
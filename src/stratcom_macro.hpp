@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_MACRO_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_MACRO_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Records and plays back sequences of button and axis changes, driven by the REC button.
+     * Pressing REC arms the recorder. The first of the buttons 1 to 6 pressed while REC is held selects the
+     * macro slot to record to; all further button and axis changes until REC is released are recorded with their
+     * time relative to the selection. Pressing a button with a recorded macro while REC is not held starts the
+     * playback of that macro.
+     * The steps of all slots are kept in a single array that is allocated upon construction, so recording and
+     * playback never allocate.
+     */
+    class macro_recorder {
+    public:
+        static unsigned const NUMBER_OF_SLOTS = 6;
+
+        /** A recorded change.
+         */
+        struct step {
+            std::uint32_t offset;                       ///< time since the start of the macro in microseconds.
+            std::uint16_t type;                         ///< stratcom_input_event_type.
+            std::uint16_t control;                      ///< stratcom_button or stratcom_axis.
+            std::int32_t status;                        ///< new button status or axis position.
+        };
+
+        /** Change of the recording state caused by an input.
+         */
+        enum recording_change {
+            RECORDING_UNCHANGED,
+            RECORDING_ARMED,                            ///< REC was pressed.
+            RECORDING_FINISHED                          ///< REC was released.
+        };
+    private:
+        allocated_array<step> m_steps;                  ///< m_capacity steps for each slot.
+        std::uint32_t m_capacity;
+        std::uint32_t m_length[NUMBER_OF_SLOTS];
+        bool m_armed;                                   ///< true while REC is held.
+        int m_recording_slot;                           ///< slot being recorded to. -1 if none.
+        stratcom_timestamp m_recording_start;
+        stratcom_button_word m_ignored;                 ///< the selecting button, until it is released.
+        int m_playing_slot;                             ///< slot being played back. -1 if none.
+        std::uint32_t m_playback_position;              ///< index of the next step to play back.
+        stratcom_timestamp m_playback_start;
+    public:
+        /** Constructor.
+         * @param[in] capacity Maximum number of steps per macro.
+         */
+        macro_recorder(allocator const& alloc, std::uint32_t capacity);
+
+        /** Check whether the steps were allocated successfully.
+         */
+        bool isValid() const;
+
+        std::uint32_t getLength(unsigned slot) const;
+
+        /** Erase a macro. Stops its playback.
+         */
+        void clear(unsigned slot);
+
+        /** Process a change of the input state.
+         * @param[in] old_state State before the change.
+         * @param[in] new_state State after the change.
+         * @param[in] timestamp Time of the change.
+         */
+        recording_change onInput(stratcom_input_state const& old_state, stratcom_input_state const& new_state,
+                                 stratcom_timestamp timestamp);
+
+        /** Check whether REC is held.
+         */
+        bool isArmed() const;
+
+        bool isPlaying() const;
+
+        /** Time at which the next step of the playback is due. Only valid while isPlaying().
+         */
+        stratcom_timestamp getNextDueTime() const;
+
+        /** Advance the playback to a point in time.
+         * @param[in] now The current time.
+         * @param[out] out_steps Receives a pointer to the steps that became due, in order.
+         * @param[out] out_start Receives the time at which the playback started. Add the offset of a step
+         *                       to obtain the time at which it became due.
+         * @return Number of steps that became due.
+         */
+        std::size_t takeDueSteps(stratcom_timestamp now, step const*& out_steps, stratcom_timestamp& out_start);
+    private:
+        void record(stratcom_timestamp timestamp, stratcom_input_event_type type, unsigned control,
+                    std::int32_t status);
+
+        macro_recorder(macro_recorder const&);              // = delete
+        macro_recorder& operator=(macro_recorder const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,286 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_merge.hpp"
+
+#include <chrono>
+#include <limits>
+
+namespace stratcom_internal {
+
+    namespace {
+        std::size_t const BITS_PER_WORD = 64;
+
+        /** Order of heap nodes: by timestamp, ties are broken by the source index.
+         */
+        bool isBefore(stratcom_timestamp t1, std::uint32_t s1, stratcom_timestamp t2, std::uint32_t s2)
+        {
+            return (t1 < t2) || ((t1 == t2) && (s1 < s2));
+        }
+
+        std::size_t roundUpToPowerOfTwo(std::size_t n)
+        {
+            std::size_t ret = 1;
+            while((ret < n) && (ret <= std::numeric_limits<std::size_t>::max() / 2)) { ret *= 2; }
+            return ret;
+        }
+
+#if defined(__GNUC__)
+        unsigned lowestBit(std::uint64_t word)
+        {
+            return static_cast<unsigned>(__builtin_ctzll(word));
+        }
+#else
+        unsigned lowestBit(std::uint64_t word)
+        {
+            unsigned ret = 0;
+            while((word & 1) == 0) { word >>= 1; ++ret; }
+            return ret;
+        }
+#endif
+    }
+
+    event_merger::event_merger(allocator const& alloc, std::uint32_t number_of_sources, std::size_t queue_size,
+                               stratcom_timestamp reorder_window)
+        :m_number_of_sources(number_of_sources), m_queue_mask(roundUpToPowerOfTwo(queue_size) - 1),
+         m_reorder_window(reorder_window), m_heap_size(0),
+         m_ready_words((number_of_sources + BITS_PER_WORD - 1) / BITS_PER_WORD), m_last_released(0),
+         m_events_merged(0), m_events_late(0), m_consumer_waiting(false)
+    {
+        if(number_of_sources == 0) { return; }
+        std::size_t const capacity = m_queue_mask + 1;
+        if(capacity > std::numeric_limits<std::size_t>::max() / number_of_sources) { return; }
+        m_sources.reset(createArray<source>(alloc, number_of_sources));
+        m_events.reset(createArray<stratcom_merged_event>(alloc, capacity * number_of_sources));
+        m_heap.reset(createArray<heap_node>(alloc, number_of_sources));
+        m_ready.reset(createArray<std::atomic<std::uint64_t>>(alloc, m_ready_words));
+    }
+
+    bool event_merger::isValid() const
+    {
+        return m_sources && m_events && m_heap && m_ready;
+    }
+
+    std::uint32_t event_merger::getNumberOfSources() const
+    {
+        return m_number_of_sources;
+    }
+
+    bool event_merger::push(std::uint32_t source_index, stratcom_input_event const& event)
+    {
+        source& s = m_sources[source_index];
+        std::uint64_t const w = s.write_pos.load(std::memory_order_relaxed);
+        if(w - s.read_pos.load(std::memory_order_acquire) > m_queue_mask) {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        stratcom_merged_event& e = m_events[source_index * (m_queue_mask + 1) + (w & m_queue_mask)];
+        e.device_index = source_index;
+        e.event = event;
+        e.event.next = nullptr;
+        s.write_pos.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    void event_merger::commit(std::uint32_t source_index)
+    {
+        m_ready[source_index / BITS_PER_WORD].fetch_or(std::uint64_t(1) << (source_index % BITS_PER_WORD));
+        // the consumer raises the flag before checking the ready bits under the mutex,
+        // so either it sees the bit set above or we see the flag and wake it up
+        if(m_consumer_waiting.load()) {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_cv.notify_one();
+        }
+    }
+
+    std::size_t event_merger::read(stratcom_merged_event* out_events, std::size_t max_events,
+                                   int timeout_milliseconds)
+    {
+        if(max_events == 0) { return 0; }
+        stratcom_timestamp const start = stratcom_get_timestamp();
+        stratcom_timestamp const timeout = static_cast<stratcom_timestamp>(timeout_milliseconds) * 1000;
+        for(;;) {
+            collectReadySources();
+            stratcom_timestamp const now = stratcom_get_timestamp();
+            std::size_t const n = releaseReadyEvents(out_events, max_events, now);
+            if((n != 0) || (timeout_milliseconds == 0)) { return n; }
+            bool has_deadline = (timeout_milliseconds > 0);
+            stratcom_timestamp wait_time = 0;
+            if(has_deadline) {
+                if(now - start >= timeout) { return 0; }
+                wait_time = timeout - (now - start);
+            }
+            if(m_heap_size != 0) {
+                // the oldest pending event is released when it leaves the reordering window
+                stratcom_timestamp const age = (now > m_heap[0].timestamp) ? (now - m_heap[0].timestamp) : 0;
+                stratcom_timestamp const until_release = m_reorder_window - age;
+                if(!has_deadline || (until_release < wait_time)) {
+                    wait_time = until_release;
+                    has_deadline = true;
+                }
+            }
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_consumer_waiting.store(true);
+            if(!hasReadySources()) {
+                if(has_deadline) {
+                    m_cv.wait_for(lk, std::chrono::microseconds(wait_time));
+                } else {
+                    m_cv.wait(lk);
+                }
+            }
+            m_consumer_waiting.store(false);
+        }
+    }
+
+    void event_merger::getStatistics(stratcom_event_merger_statistics& out_statistics) const
+    {
+        out_statistics.events_merged = m_events_merged.load(std::memory_order_relaxed);
+        out_statistics.events_late = m_events_late.load(std::memory_order_relaxed);
+        out_statistics.events_dropped = 0;
+        for(std::uint32_t i = 0; i < m_number_of_sources; ++i) {
+            out_statistics.events_dropped += m_sources[i].dropped.load(std::memory_order_relaxed);
+        }
+    }
+
+    stratcom_merged_event const& event_merger::head(std::uint32_t source_index) const
+    {
+        std::uint64_t const r = m_sources[source_index].read_pos.load(std::memory_order_relaxed);
+        return m_events[source_index * (m_queue_mask + 1) + (r & m_queue_mask)];
+    }
+
+    bool event_merger::isEmpty(std::uint32_t source_index) const
+    {
+        source const& s = m_sources[source_index];
+        return s.read_pos.load(std::memory_order_relaxed) == s.write_pos.load(std::memory_order_acquire);
+    }
+
+    bool event_merger::hasReadySources() const
+    {
+        for(std::size_t w = 0; w < m_ready_words; ++w) {
+            if(m_ready[w].load() != 0) { return true; }
+        }
+        return false;
+    }
+
+    /** Add all sources flagged by producers since the last call to the heap, unless they already are.
+     */
+    void event_merger::collectReadySources()
+    {
+        for(std::size_t w = 0; w < m_ready_words; ++w) {
+            if(m_ready[w].load(std::memory_order_relaxed) == 0) { continue; }
+            std::uint64_t bits = m_ready[w].exchange(0, std::memory_order_acquire);
+            while(bits != 0) {
+                std::uint32_t const source_index = static_cast<std::uint32_t>(w * BITS_PER_WORD + lowestBit(bits));
+                bits &= (bits - 1);
+                source& s = m_sources[source_index];
+                if(!s.in_heap && !isEmpty(source_index)) {
+                    heap_node const node = { head(source_index).event.timestamp, source_index };
+                    heapPush(node);
+                    s.in_heap = true;
+                }
+            }
+        }
+    }
+
+    /** Perform the k-way merge.
+     * The oldest pending event can be released when no older event can arrive anymore. This is certain if every
+     * source has an event pending, as the events of each source arrive in order. Otherwise it is assumed once the
+     * event has aged beyond the reordering window.
+     */
+    std::size_t event_merger::releaseReadyEvents(stratcom_merged_event* out_events, std::size_t max_events,
+                                                 stratcom_timestamp now)
+    {
+        std::size_t n = 0;
+        while((n < max_events) && (m_heap_size != 0)) {
+            heap_node const top = m_heap[0];
+            if((m_heap_size < m_number_of_sources) &&
+               ((now < top.timestamp) || (now - top.timestamp < m_reorder_window)))
+            {
+                break;
+            }
+            source& s = m_sources[top.source];
+            std::uint64_t const r = s.read_pos.load(std::memory_order_relaxed);
+            out_events[n++] = head(top.source);
+            s.read_pos.store(r + 1, std::memory_order_release);
+            m_events_merged.store(m_events_merged.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if(top.timestamp < m_last_released) {
+                m_events_late.store(m_events_late.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            } else {
+                m_last_released = top.timestamp;
+            }
+            if(isEmpty(top.source)) {
+                heapPopTop();
+                s.in_heap = false;
+            } else {
+                heap_node const node = { head(top.source).event.timestamp, top.source };
+                heapReplaceTop(node);
+            }
+        }
+        return n;
+    }
+
+    void event_merger::heapPush(heap_node node)
+    {
+        std::uint32_t i = m_heap_size++;
+        while(i > 0) {
+            std::uint32_t const parent = (i - 1) / 2;
+            if(!isBefore(node.timestamp, node.source, m_heap[parent].timestamp, m_heap[parent].source)) { break; }
+            m_heap[i] = m_heap[parent];
+            i = parent;
+        }
+        m_heap[i] = node;
+    }
+
+    void event_merger::heapReplaceTop(heap_node node)
+    {
+        m_heap[0] = node;
+        siftDown(0);
+    }
+
+    void event_merger::heapPopTop()
+    {
+        --m_heap_size;
+        if(m_heap_size != 0) {
+            m_heap[0] = m_heap[m_heap_size];
+            siftDown(0);
+        }
+    }
+
+    void event_merger::siftDown(std::uint32_t index)
+    {
+        heap_node const node = m_heap[index];
+        for(;;) {
+            std::uint32_t child = 2 * index + 1;
+            if(child >= m_heap_size) { break; }
+            if((child + 1 < m_heap_size) &&
+               isBefore(m_heap[child + 1].timestamp, m_heap[child + 1].source,
+                        m_heap[child].timestamp, m_heap[child].source))
+            {
+                ++child;
+            }
+            if(!isBefore(m_heap[child].timestamp, m_heap[child].source, node.timestamp, node.source)) { break; }
+            m_heap[index] = m_heap[child];
+            index = child;
+        }
+        m_heap[index] = node;
+    }
+}
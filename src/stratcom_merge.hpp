@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_MERGE_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_MERGE_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace stratcom_internal {
+
+    /** \internal Merges the input events of several sources into a single stream ordered by timestamp.
+     * Each source owns a single-producer single-consumer ring of events, so that producers of different
+     * sources never contend with each other or with the consumer. The consumer performs a k-way merge over
+     * the heads of all non-empty rings, which are kept in a binary min-heap keyed by timestamp. The oldest
+     * event is released once every source has an event pending, or once it is older than the reordering window.
+     * Producers flag their source in a bitmask after pushing, so the consumer only visits sources that
+     * received new events. All memory is allocated upon construction.
+     */
+    class event_merger {
+    private:
+        struct source {
+            std::atomic<std::uint64_t> write_pos;
+            std::atomic<std::uint64_t> read_pos;
+            std::atomic<std::uint64_t> dropped;
+            bool in_heap;                               ///< only accessed by the consumer.
+        };
+
+        struct heap_node {
+            stratcom_timestamp timestamp;               ///< timestamp of the oldest pending event of the source.
+            std::uint32_t source;
+        };
+
+        std::uint32_t m_number_of_sources;
+        std::size_t m_queue_mask;                       ///< ring capacity - 1; the capacity is a power of two.
+        stratcom_timestamp m_reorder_window;
+        allocated_array<source> m_sources;
+        allocated_array<stratcom_merged_event> m_events;    ///< rings of all sources, back to back.
+        allocated_array<heap_node> m_heap;
+        std::uint32_t m_heap_size;
+        allocated_array<std::atomic<std::uint64_t>> m_ready;    ///< one bit per source with new events.
+        std::size_t m_ready_words;
+        stratcom_timestamp m_last_released;
+        std::atomic<std::uint64_t> m_events_merged;
+        std::atomic<std::uint64_t> m_events_late;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::atomic<bool> m_consumer_waiting;
+    public:
+        event_merger(allocator const& alloc, std::uint32_t number_of_sources, std::size_t queue_size,
+                     stratcom_timestamp reorder_window);
+
+        /** Check whether all memory was allocated successfully.
+         */
+        bool isValid() const;
+
+        std::uint32_t getNumberOfSources() const;
+
+        /** Queue an event of a source. Must only be called by the single producer of that source.
+         * Call commit() after pushing a batch of events to notify the consumer.
+         * @return false if the ring of the source is full and the event was dropped.
+         */
+        bool push(std::uint32_t source_index, stratcom_input_event const& event);
+
+        /** Flag the source as having new events and wake up a waiting consumer.
+         */
+        void commit(std::uint32_t source_index);
+
+        /** Take the oldest events that are ready for release. Must only be called by the single consumer.
+         * @param[out] out_events Array receiving the events.
+         * @param[in] max_events Size of the out_events array.
+         * @param[in] timeout_milliseconds Time to wait for an event to become ready. -1 blocks indefinitely,
+         *                                 0 returns immediately.
+         * @return Number of events written to out_events.
+         */
+        std::size_t read(stratcom_merged_event* out_events, std::size_t max_events, int timeout_milliseconds);
+
+        /** @see stratcom_get_event_merger_statistics()
+         */
+        void getStatistics(stratcom_event_merger_statistics& out_statistics) const;
+
+    private:
+        stratcom_merged_event const& head(std::uint32_t source_index) const;
+        bool isEmpty(std::uint32_t source_index) const;
+        bool hasReadySources() const;
+        void collectReadySources();
+        std::size_t releaseReadyEvents(stratcom_merged_event* out_events, std::size_t max_events,
+                                       stratcom_timestamp now);
+        void heapPush(heap_node node);
+        void heapReplaceTop(heap_node node);
+        void heapPopTop();
+        void siftDown(std::uint32_t index);
+
+        event_merger(event_merger const&);              // = delete
+        event_merger& operator=(event_merger const&);   // = delete
+    };
+}
+
+#endif
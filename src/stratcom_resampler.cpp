@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_resampler.hpp"
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Number of states inspected by a linear search from the newest state before
+         * falling back to binary search.
+         */
+        std::size_t const LINEAR_SEARCH_LIMIT = 8;
+
+        stratcom_axis_word interpolate(stratcom_axis_word a, stratcom_axis_word b,
+                                       stratcom_timestamp offset, stratcom_timestamp interval)
+        {
+            std::int64_t const delta = static_cast<std::int64_t>(b) - a;
+            std::int64_t const scaled = delta * static_cast<std::int64_t>(offset);
+            std::int64_t const half = static_cast<std::int64_t>(interval / 2);
+            // round to nearest
+            std::int64_t const step = (scaled >= 0) ? ((scaled + half) / static_cast<std::int64_t>(interval)) :
+                                                      ((scaled - half) / static_cast<std::int64_t>(interval));
+            return static_cast<stratcom_axis_word>(a + step);
+        }
+    }
+
+    input_resampler::input_resampler(allocator const& alloc, stratcom_resampler_config const& config,
+                                     stratcom_timestamp start_time, stratcom_input_state const& start_state)
+        :m_entries(createArray<entry>(alloc, (config.history_size > 0) ? config.history_size : 1)),
+         m_capacity((config.history_size > 0) ? config.history_size : 1), m_count(0), m_config(config),
+         m_last_sample_time(start_time)
+    {
+        if(m_entries) {
+            push(start_time, start_state);
+        }
+    }
+
+    bool input_resampler::isValid() const
+    {
+        return static_cast<bool>(m_entries);
+    }
+
+    void input_resampler::push(stratcom_timestamp timestamp, stratcom_input_state const& state)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        entry& e = m_entries[m_count % m_capacity];
+        e.timestamp = timestamp;
+        e.state = state;
+        ++m_count;
+    }
+
+    input_resampler::entry const& input_resampler::at(std::size_t index) const
+    {
+        return m_entries[index % m_capacity];
+    }
+
+    std::size_t input_resampler::oldestIndex() const
+    {
+        return (m_count > m_capacity) ? (m_count - m_capacity) : 0;
+    }
+
+    /** Find the newest state that became effective at or before t.
+     * The common case of sampling close to the present is answered by a short linear search,
+     * everything else by binary search over the ring buffer.
+     * @return Index of the state or npos if t is older than all states in the buffer.
+     */
+    std::size_t input_resampler::findAtOrBefore(stratcom_timestamp t) const
+    {
+        std::size_t const oldest = oldestIndex();
+        std::size_t idx = m_count;
+        for(std::size_t i = 0; (i < LINEAR_SEARCH_LIMIT) && (idx > oldest); ++i) {
+            --idx;
+            if(at(idx).timestamp <= t) { return idx; }
+        }
+        if(idx == oldest) { return npos; }
+        // binary search for the last index in [oldest, idx) with timestamp <= t
+        std::size_t first = oldest;
+        std::size_t last = idx;
+        while(first < last) {
+            std::size_t const mid = first + (last - first) / 2;
+            if(at(mid).timestamp <= t) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return (first == oldest) ? npos : (first - 1);
+    }
+
+    void input_resampler::sample(stratcom_timestamp t, stratcom_sampled_state& out_sample)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        std::size_t const idx = findAtOrBefore(t);
+        if(idx == npos) {
+            // t is older than all of the history; hold the oldest known state
+            out_sample.state = at(oldestIndex()).state;
+            out_sample.pressed = 0;
+            out_sample.released = 0;
+            return;
+        }
+
+        entry const& current = at(idx);
+        out_sample.state = current.state;
+
+        if((m_config.axis_mode == STRATCOM_RESAMPLE_LINEAR) && (idx + 1 < m_count)) {
+            entry const& next = at(idx + 1);
+            stratcom_timestamp const interval = next.timestamp - current.timestamp;
+            if((interval > 0) && (interval <= m_config.max_interpolation_interval)) {
+                stratcom_timestamp const offset = t - current.timestamp;
+                out_sample.state.axisX = interpolate(current.state.axisX, next.state.axisX, offset, interval);
+                out_sample.state.axisY = interpolate(current.state.axisY, next.state.axisY, offset, interval);
+                out_sample.state.axisZ = interpolate(current.state.axisZ, next.state.axisZ, offset, interval);
+            }
+        }
+
+        // collect all button edges in (m_last_sample_time, t]
+        stratcom_button_word pressed = 0;
+        stratcom_button_word released = 0;
+        if(t > m_last_sample_time) {
+            std::size_t const start = findAtOrBefore(m_last_sample_time);
+            std::size_t i = (start == npos) ? oldestIndex() : start;
+            stratcom_button_word previous = at(i).state.buttons;
+            for(++i; i <= idx; ++i) {
+                stratcom_button_word const buttons = at(i).state.buttons;
+                stratcom_button_word const edges = previous ^ buttons;
+                pressed |= (edges & buttons);
+                released |= (edges & previous);
+                previous = buttons;
+            }
+            m_last_sample_time = t;
+        }
+        out_sample.pressed = pressed;
+        out_sample.released = released;
+        // a press that was released again before t must still be visible in this sample
+        out_sample.state.buttons |= pressed;
+    }
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_RESAMPLER_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_RESAMPLER_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+#include <mutex>
+
+namespace stratcom_internal {
+
+    /** \internal Resamples the irregular stream of input states of a device at arbitrary points in time.
+     * Input states are kept in a ring buffer that is allocated once upon construction.
+     * Pushing and sampling may happen concurrently from different threads.
+     */
+    class input_resampler {
+    private:
+        struct entry {
+            stratcom_timestamp timestamp;
+            stratcom_input_state state;
+        };
+        static std::size_t const npos = static_cast<std::size_t>(-1);
+
+        allocated_array<entry> m_entries;
+        std::size_t m_capacity;
+        std::size_t m_count;                            ///< total number of states pushed.
+        stratcom_resampler_config m_config;
+        stratcom_timestamp m_last_sample_time;
+        std::mutex m_mutex;
+    public:
+        input_resampler(allocator const& alloc, stratcom_resampler_config const& config,
+                        stratcom_timestamp start_time, stratcom_input_state const& start_state);
+
+        /** Check whether the ring buffer was allocated successfully.
+         */
+        bool isValid() const;
+
+        /** Add a new input state.
+         * @param[in] timestamp Time at which the state became effective. Must not be older than any
+         *                      state pushed before.
+         * @param[in] state The new input state.
+         */
+        void push(stratcom_timestamp timestamp, stratcom_input_state const& state);
+
+        /** Sample the input state at a point in time.
+         * @see stratcom_sample_at()
+         */
+        void sample(stratcom_timestamp t, stratcom_sampled_state& out_sample);
+
+    private:
+        entry const& at(std::size_t index) const;
+        std::size_t oldestIndex() const;
+        std::size_t findAtOrBefore(stratcom_timestamp t) const;
+
+        input_resampler(input_resampler const&);              // = delete
+        input_resampler& operator=(input_resampler const&);   // = delete
+    };
+}
+
+#endif
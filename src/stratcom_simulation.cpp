@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_simulation.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Set the readiness state of the signalling pipe. Must be called with the queue mutex held.
+         */
+        void signalPipe(int const (&pipe_fds)[2], bool readable)
+        {
+#ifndef _WIN32
+            if(pipe_fds[0] < 0) { return; }
+            if(readable) {
+                char const c = 0;
+                ssize_t const res = write(pipe_fds[1], &c, 1);
+                (void)res;
+            } else {
+                char buffer[16];
+                while(read(pipe_fds[0], buffer, sizeof(buffer)) > 0) {}
+            }
+#else
+            (void)pipe_fds;
+            (void)readable;
+#endif
+        }
+    }
+
+    simulated_device::simulated_device()
+        :m_queue_front(0), m_queue_size(0)
+    {
+        std::memset(m_feature_reports, 0, sizeof(m_feature_reports));
+        for(std::size_t i = 0; i < NUMBER_OF_FEATURE_REPORTS; ++i) {
+            m_feature_reports[i][0] = static_cast<std::uint8_t>(i + 1);
+        }
+        m_pipe[0] = -1;
+        m_pipe[1] = -1;
+#ifndef _WIN32
+        if(pipe(m_pipe) == 0) {
+            for(int fd : m_pipe) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+            }
+        } else {
+            m_pipe[0] = -1;
+            m_pipe[1] = -1;
+        }
+#endif
+    }
+
+    simulated_device::~simulated_device()
+    {
+#ifndef _WIN32
+        for(int fd : m_pipe) {
+            if(fd >= 0) { close(fd); }
+        }
+#endif
+    }
+
+    int simulated_device::getPollFd() const
+    {
+        return m_pipe[0];
+    }
+
+    bool simulated_device::pushReport(std::uint8_t const* data, std::size_t size, stratcom_timestamp timestamp)
+    {
+        if(size > REPORT_SIZE) { return false; }
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if(m_queue_size == QUEUE_SIZE) { return false; }
+            queued_report& queued = m_queue[(m_queue_front + m_queue_size) % QUEUE_SIZE];
+            std::memcpy(queued.data, data, size);
+            queued.size = size;
+            queued.timestamp = timestamp;
+            if(m_queue_size++ == 0) { signalPipe(m_pipe, true); }
+        }
+        m_report_available.notify_one();
+        return true;
+    }
+
+    int simulated_device::readReport(std::uint8_t* data, std::size_t size, int timeout_milliseconds,
+                                     stratcom_timestamp& out_timestamp)
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        auto const has_report = [this]() { return m_queue_size > 0; };
+        if(timeout_milliseconds < 0) {
+            m_report_available.wait(lk, has_report);
+        } else if(!m_report_available.wait_for(lk, std::chrono::milliseconds(timeout_milliseconds), has_report)) {
+            return 0;
+        }
+        queued_report const& queued = m_queue[m_queue_front];
+        std::size_t const bytes_read = std::min(size, queued.size);
+        std::memcpy(data, queued.data, bytes_read);
+        out_timestamp = queued.timestamp;
+        m_queue_front = (m_queue_front + 1) % QUEUE_SIZE;
+        if(--m_queue_size == 0) { signalPipe(m_pipe, false); }
+        return static_cast<int>(bytes_read);
+    }
+
+    int simulated_device::sendFeatureReport(std::uint8_t const* data, std::size_t size)
+    {
+        if((size != FEATURE_REPORT_SIZE) || (data[0] < 1) || (data[0] > NUMBER_OF_FEATURE_REPORTS)) { return -1; }
+        std::lock_guard<std::mutex> lk(m_mutex);
+        std::memcpy(m_feature_reports[data[0] - 1], data, size);
+        return static_cast<int>(size);
+    }
+
+    int simulated_device::getFeatureReport(std::uint8_t* data, std::size_t size)
+    {
+        if((size != FEATURE_REPORT_SIZE) || (data[0] < 1) || (data[0] > NUMBER_OF_FEATURE_REPORTS)) { return -1; }
+        std::lock_guard<std::mutex> lk(m_mutex);
+        std::memcpy(data, m_feature_reports[data[0] - 1], size);
+        return static_cast<int>(size);
+    }
+}
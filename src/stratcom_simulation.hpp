@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_SIMULATION_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_SIMULATION_HPP_
+
+#include <stratcom.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace stratcom_internal {
+
+    /** \internal Backend of a simulated device.
+     * Input reports pushed by the application are queued in a fixed-size ring buffer and handed out by
+     * readReport() in the same way the HID layer hands out reports of a physical device. Feature reports
+     * are stored and read back, so the LED state of a simulated device behaves like that of a physical one.
+     * Pushing and reading may happen concurrently from different threads. No member function allocates.
+     * On POSIX systems, the read end of a pipe signals the availability of input reports, so that simulated
+     * devices can be waited on with poll() like hidraw devices.
+     */
+    class simulated_device {
+    public:
+        static std::size_t const REPORT_SIZE = 8;      ///< maximum size of a queued input report.
+        static std::size_t const QUEUE_SIZE = 256;     ///< number of input reports that can be queued.
+    private:
+        static std::size_t const FEATURE_REPORT_SIZE = 3;
+        static std::size_t const NUMBER_OF_FEATURE_REPORTS = 2;
+
+        struct queued_report {
+            std::uint8_t data[REPORT_SIZE];
+            std::size_t size;
+            stratcom_timestamp timestamp;                   ///< time at which the report was pushed.
+        };
+
+        queued_report m_queue[QUEUE_SIZE];
+        std::size_t m_queue_front;
+        std::size_t m_queue_size;
+        std::uint8_t m_feature_reports[NUMBER_OF_FEATURE_REPORTS][FEATURE_REPORT_SIZE];  ///< indexed by report id - 1.
+        std::mutex m_mutex;
+        std::condition_variable m_report_available;
+        int m_pipe[2];                                  ///< readable while the queue is not empty; -1 if unavailable.
+    public:
+        simulated_device();
+        ~simulated_device();
+
+        /** File descriptor that is readable while input reports are queued. -1 if not available.
+         */
+        int getPollFd() const;
+
+        /** Queue an input report.
+         * @return false if the report is too large or the queue is full.
+         */
+        bool pushReport(std::uint8_t const* data, std::size_t size, stratcom_timestamp timestamp);
+
+        /** Take the oldest input report from the queue.
+         * @param[in] timeout_milliseconds Time to wait for a report. -1 blocks indefinitely, 0 returns immediately.
+         * @return Number of bytes read, 0 if no report was available within the timeout.
+         */
+        int readReport(std::uint8_t* data, std::size_t size, int timeout_milliseconds,
+                       stratcom_timestamp& out_timestamp);
+
+        /** Store a feature report. The report id is taken from the first byte.
+         * @return Number of bytes written, -1 for unknown report ids.
+         */
+        int sendFeatureReport(std::uint8_t const* data, std::size_t size);
+
+        /** Read back a feature report. The report id must be set in the first byte.
+         * @return Number of bytes read, -1 for unknown report ids.
+         */
+        int getFeatureReport(std::uint8_t* data, std::size_t size);
+
+    private:
+        simulated_device(simulated_device const&);              // = delete
+        simulated_device& operator=(simulated_device const&);   // = delete
+    };
+}
+
+#endif
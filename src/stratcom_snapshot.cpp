@@ -0,0 +1,254 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_snapshot.hpp"
+
+#include "stratcom_calibration.hpp"
+
+#include <cstring>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** \internal
+         * Snapshot format.
+         * All values are stored little-endian:
+         *   magic 'S' 'C', format version, section flags
+         *   LED state (2 bytes), blink on time, blink off time
+         *   for each calibrated axis: min, center, max (2 bytes each), response curve (IEEE 754, 4 bytes),
+         *                             build float table (1 byte)
+         *   if SECTION_DEBOUNCE: mask of debounced buttons (2 bytes), window of each (4 bytes each)
+         *   if SECTION_VELOCITY: mask of estimated axes (1 byte), smoothing time of each (4 bytes each)
+         */
+        std::uint8_t const MAGIC_0 = 'S';
+        std::uint8_t const MAGIC_1 = 'C';
+        std::uint8_t const FORMAT_VERSION = 1;
+        std::uint16_t const LED_BITS = (STRATCOM_LEDBUTTON_ALL | (STRATCOM_LEDBUTTON_ALL << 1));
+        enum section_flags {
+            SECTION_CALIBRATION_X = 0x01,
+            SECTION_CALIBRATION_Y = 0x02,
+            SECTION_CALIBRATION_Z = 0x04,
+            SECTION_DEBOUNCE      = 0x08,
+            SECTION_VELOCITY      = 0x10,
+            SECTION_RESYNC_MODE   = 0x20,
+            SECTION_ALL           = 0x3f
+        };
+
+        /** Sequential writer that stops writing once the buffer is full.
+         */
+        class byte_writer {
+        private:
+            std::uint8_t* m_buffer;
+            std::size_t m_size;
+            std::size_t m_position;
+        public:
+            byte_writer(void* buffer, std::size_t size)
+                :m_buffer(static_cast<std::uint8_t*>(buffer)), m_size(size), m_position(0)
+            {}
+
+            void put(std::uint32_t value, std::size_t bytes)
+            {
+                for(std::size_t i = 0; i < bytes; ++i, ++m_position) {
+                    if(m_position < m_size) {
+                        m_buffer[m_position] = static_cast<std::uint8_t>(value >> (8 * i));
+                    }
+                }
+            }
+
+            /** Number of bytes written, or 0 if the buffer was too small.
+             */
+            std::size_t finish() const
+            {
+                return (m_position <= m_size) ? m_position : 0;
+            }
+        };
+
+        /** Sequential reader that fails once reading past the end.
+         */
+        class byte_reader {
+        private:
+            std::uint8_t const* m_data;
+            std::size_t m_size;
+            std::size_t m_position;
+            bool m_failed;
+        public:
+            byte_reader(void const* data, std::size_t size)
+                :m_data(static_cast<std::uint8_t const*>(data)), m_size(size), m_position(0), m_failed(false)
+            {}
+
+            std::uint32_t get(std::size_t bytes)
+            {
+                if(m_size - m_position < bytes) {
+                    m_failed = true;
+                    return 0;
+                }
+                std::uint32_t ret = 0;
+                for(std::size_t i = 0; i < bytes; ++i, ++m_position) {
+                    ret |= static_cast<std::uint32_t>(m_data[m_position]) << (8 * i);
+                }
+                return ret;
+            }
+
+            /** Check whether all data was read without failure.
+             */
+            bool isComplete() const
+            {
+                return !m_failed && (m_position == m_size);
+            }
+        };
+
+        std::uint32_t floatBits(float f)
+        {
+            std::uint32_t ret;
+            static_assert(sizeof(ret) == sizeof(f), "float must be 32 bits wide.");
+            std::memcpy(&ret, &f, sizeof(ret));
+            return ret;
+        }
+
+        float bitsToFloat(std::uint32_t bits)
+        {
+            float ret;
+            std::memcpy(&ret, &bits, sizeof(ret));
+            return ret;
+        }
+    }
+
+    device_snapshot::device_snapshot()
+        :led_button_state(0), blink_on_time(0), blink_off_time(0), resync_mode(false)
+    {
+        for(unsigned i = 0; i < NUMBER_OF_AXES; ++i) {
+            is_calibrated[i] = false;
+            std::memset(&calibration[i], 0, sizeof(calibration[i]));
+            velocity_smoothing[i] = 0;
+        }
+        for(unsigned i = 0; i < NUMBER_OF_BUTTONS; ++i) {
+            debounce_window[i] = 0;
+        }
+    }
+
+    std::size_t writeSnapshot(device_snapshot const& snapshot, void* buffer, std::size_t buffer_size)
+    {
+        unsigned debounced = 0;
+        for(unsigned i = 0; i < device_snapshot::NUMBER_OF_BUTTONS; ++i) {
+            if(snapshot.debounce_window[i] != 0) { debounced |= (1u << i); }
+        }
+        unsigned estimated = 0;
+        for(unsigned i = 0; i < device_snapshot::NUMBER_OF_AXES; ++i) {
+            if(snapshot.velocity_smoothing[i] != 0) { estimated |= (1u << i); }
+        }
+        unsigned const sections = (snapshot.is_calibrated[0] ? SECTION_CALIBRATION_X : 0) |
+                                  (snapshot.is_calibrated[1] ? SECTION_CALIBRATION_Y : 0) |
+                                  (snapshot.is_calibrated[2] ? SECTION_CALIBRATION_Z : 0) |
+                                  ((debounced != 0) ? SECTION_DEBOUNCE : 0) |
+                                  ((estimated != 0) ? SECTION_VELOCITY : 0) |
+                                  (snapshot.resync_mode ? SECTION_RESYNC_MODE : 0);
+        byte_writer w(buffer, buffer_size);
+        w.put(MAGIC_0, 1);
+        w.put(MAGIC_1, 1);
+        w.put(FORMAT_VERSION, 1);
+        w.put(sections, 1);
+        w.put(snapshot.led_button_state, 2);
+        w.put(snapshot.blink_on_time, 1);
+        w.put(snapshot.blink_off_time, 1);
+        for(unsigned i = 0; i < device_snapshot::NUMBER_OF_AXES; ++i) {
+            if(!snapshot.is_calibrated[i]) { continue; }
+            stratcom_axis_calibration const& c = snapshot.calibration[i];
+            w.put(static_cast<std::uint16_t>(c.min), 2);
+            w.put(static_cast<std::uint16_t>(c.center), 2);
+            w.put(static_cast<std::uint16_t>(c.max), 2);
+            w.put(floatBits(c.response_curve), 4);
+            w.put(c.build_float_table ? 1 : 0, 1);
+        }
+        if(debounced != 0) {
+            w.put(debounced, 2);
+            for(unsigned i = 0; i < device_snapshot::NUMBER_OF_BUTTONS; ++i) {
+                if(debounced & (1u << i)) { w.put(snapshot.debounce_window[i], 4); }
+            }
+        }
+        if(estimated != 0) {
+            w.put(estimated, 1);
+            for(unsigned i = 0; i < device_snapshot::NUMBER_OF_AXES; ++i) {
+                if(estimated & (1u << i)) { w.put(snapshot.velocity_smoothing[i], 4); }
+            }
+        }
+        return w.finish();
+    }
+
+    bool readSnapshot(void const* data, std::size_t size, device_snapshot& out_snapshot)
+    {
+        device_snapshot s;
+        byte_reader r(data, size);
+        if((r.get(1) != MAGIC_0) || (r.get(1) != MAGIC_1) || (r.get(1) != FORMAT_VERSION)) {
+            return false;
+        }
+        unsigned const sections = r.get(1);
+        if((sections & ~SECTION_ALL) != 0) {
+            return false;
+        }
+        s.led_button_state = static_cast<std::uint16_t>(r.get(2));
+        if(((s.led_button_state & ~LED_BITS) != 0) ||
+           ((s.led_button_state & (s.led_button_state >> 1) & STRATCOM_LEDBUTTON_ALL) != 0))
+        {
+            // an LED can not be lit and blinking at the same time
+            return false;
+        }
+        s.blink_on_time = static_cast<std::uint8_t>(r.get(1));
+        s.blink_off_time = static_cast<std::uint8_t>(r.get(1));
+        s.resync_mode = (sections & SECTION_RESYNC_MODE) != 0;
+        for(unsigned i = 0; i < device_snapshot::NUMBER_OF_AXES; ++i) {
+            if(!(sections & (SECTION_CALIBRATION_X << i))) { continue; }
+            stratcom_axis_calibration& c = s.calibration[i];
+            c.min = static_cast<stratcom_axis_word>(static_cast<std::uint16_t>(r.get(2)));
+            c.center = static_cast<stratcom_axis_word>(static_cast<std::uint16_t>(r.get(2)));
+            c.max = static_cast<stratcom_axis_word>(static_cast<std::uint16_t>(r.get(2)));
+            c.response_curve = bitsToFloat(r.get(4));
+            c.build_float_table = static_cast<int>(r.get(1));
+            if(!axis_calibration::isValidCalibration(c)) {
+                return false;
+            }
+            s.is_calibrated[i] = true;
+        }
+        if(sections & SECTION_DEBOUNCE) {
+            unsigned const debounced = r.get(2);
+            if((debounced == 0) || (debounced >= (1u << device_snapshot::NUMBER_OF_BUTTONS))) {
+                return false;
+            }
+            for(unsigned i = 0; i < device_snapshot::NUMBER_OF_BUTTONS; ++i) {
+                if(debounced & (1u << i)) { s.debounce_window[i] = r.get(4); }
+            }
+        }
+        if(sections & SECTION_VELOCITY) {
+            unsigned const estimated = r.get(1);
+            if((estimated == 0) || (estimated >= (1u << device_snapshot::NUMBER_OF_AXES))) {
+                return false;
+            }
+            for(unsigned i = 0; i < device_snapshot::NUMBER_OF_AXES; ++i) {
+                if(estimated & (1u << i)) { s.velocity_smoothing[i] = r.get(4); }
+            }
+        }
+        if(!r.isComplete()) {
+            return false;
+        }
+        out_snapshot = s;
+        return true;
+    }
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_SNAPSHOT_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_SNAPSHOT_HPP_
+
+#include <stratcom.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal The state of a device that can be saved and restored.
+     * @see stratcom_save_device_state()
+     */
+    struct device_snapshot {
+        static unsigned const NUMBER_OF_AXES = 3;
+        static unsigned const NUMBER_OF_BUTTONS = 12;
+
+        std::uint16_t led_button_state;
+        std::uint8_t blink_on_time;
+        std::uint8_t blink_off_time;
+        bool resync_mode;
+        bool is_calibrated[NUMBER_OF_AXES];
+        stratcom_axis_calibration calibration[NUMBER_OF_AXES];
+        std::uint32_t debounce_window[NUMBER_OF_BUTTONS];       ///< 0 for buttons that are not debounced.
+        std::uint32_t velocity_smoothing[NUMBER_OF_AXES];       ///< 0 for axes without velocity estimation.
+
+        device_snapshot();
+    };
+
+    /** Serialize a snapshot.
+     * Only the parts of the snapshot that differ from a freshly opened device are written.
+     * @return Number of bytes written, or 0 if the buffer is too small.
+     */
+    std::size_t writeSnapshot(device_snapshot const& snapshot, void* buffer, std::size_t buffer_size);
+
+    /** Deserialize a snapshot written by writeSnapshot().
+     * @return false if the data is not a valid snapshot.
+     */
+    bool readSnapshot(void const* data, std::size_t size, device_snapshot& out_snapshot);
+}
+
+#endif
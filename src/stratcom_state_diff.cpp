@@ -0,0 +1,209 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_state_diff.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define LIBSTRATCOM_STATE_DIFF_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Byte offsets of the fields in stratcom_input_state, as seen by the byte-wise comparison.
+         */
+        unsigned const BYTES_BUTTONS = 0x003;
+        unsigned const BYTES_AXIS_X  = 0x00c;
+        unsigned const BYTES_AXIS_Y  = 0x030;
+        unsigned const BYTES_AXIS_Z  = 0x0c0;
+        unsigned const BYTES_SLIDER  = 0xf00;
+        std::size_t const STATE_SIZE = 12;
+
+        /** Upper bound for the number of events generated by a single pair of states.
+         */
+        std::size_t const MAX_EVENTS_PER_STATE = 16;
+        stratcom_button_word const ALL_BUTTONS = 0x0fff;
+
+        unsigned changedBytes(stratcom_input_state const& old_state, stratcom_input_state const& new_state)
+        {
+            return ((old_state.buttons != new_state.buttons) ? BYTES_BUTTONS : 0) |
+                   ((old_state.axisX != new_state.axisX) ? BYTES_AXIS_X : 0) |
+                   ((old_state.axisY != new_state.axisY) ? BYTES_AXIS_Y : 0) |
+                   ((old_state.axisZ != new_state.axisZ) ? BYTES_AXIS_Z : 0) |
+                   ((old_state.slider != new_state.slider) ? BYTES_SLIDER : 0);
+        }
+
+        /** Index of the highest set bit of a non-zero mask.
+         */
+        unsigned highestBit(unsigned mask)
+        {
+#if defined(__GNUC__)
+            return 31u - static_cast<unsigned>(__builtin_clz(mask));
+#else
+            unsigned ret = 0;
+            while(mask >>= 1) { ++ret; }
+            return ret;
+#endif
+        }
+
+        stratcom_compact_event* emitAxis(stratcom_compact_event* out, std::uint64_t index, stratcom_axis axis,
+                                         stratcom_axis_word status)
+        {
+            out->state_index = index;
+            out->type = STRATCOM_INPUT_EVENT_AXIS;
+            out->control = static_cast<std::uint16_t>(axis);
+            out->status = status;
+            return out + 1;
+        }
+
+        /** Write the events for one pair of states, in the order of the list built by
+         * stratcom_create_input_events_from_states(): buttons from last to first, Z-, Y-, X-axis, slider.
+         * @param[in] changed_bytes Bytes of the state that differ, as returned by changedBytes().
+         * @return One past the last event written.
+         */
+        stratcom_compact_event* emitEvents(stratcom_input_state const& old_state,
+                                           stratcom_input_state const& new_state, std::uint64_t index,
+                                           unsigned changed_bytes, stratcom_compact_event* out)
+        {
+            if(changed_bytes & BYTES_BUTTONS) {
+                unsigned changed = static_cast<unsigned>(old_state.buttons ^ new_state.buttons) & ALL_BUTTONS;
+                while(changed != 0) {
+                    unsigned const b = 1u << highestBit(changed);
+                    changed &= ~b;
+                    out->state_index = index;
+                    out->type = STRATCOM_INPUT_EVENT_BUTTON;
+                    out->control = static_cast<std::uint16_t>(b);
+                    out->status = ((new_state.buttons & b) != 0) ? 1 : 0;
+                    ++out;
+                }
+            }
+            if(changed_bytes & BYTES_AXIS_Z) { out = emitAxis(out, index, STRATCOM_AXIS_Z, new_state.axisZ); }
+            if(changed_bytes & BYTES_AXIS_Y) { out = emitAxis(out, index, STRATCOM_AXIS_Y, new_state.axisY); }
+            if(changed_bytes & BYTES_AXIS_X) { out = emitAxis(out, index, STRATCOM_AXIS_X, new_state.axisX); }
+            if(changed_bytes & BYTES_SLIDER) {
+                out->state_index = index;
+                out->type = STRATCOM_INPUT_EVENT_SLIDER;
+                out->control = 0;
+                out->status = new_state.slider;
+                ++out;
+            }
+            return out;
+        }
+
+        /** Make room for at least required additional events, growing the buffer geometrically.
+         */
+        bool reserve(allocator const& alloc, stratcom_compact_event_buffer& buffer, std::size_t required)
+        {
+            if(buffer.capacity - buffer.size >= required) { return true; }
+            std::size_t new_capacity = (buffer.capacity < 256) ? 256 : buffer.capacity;
+            while(new_capacity - buffer.size < required) {
+                if(new_capacity > (static_cast<std::size_t>(-1) / sizeof(stratcom_compact_event)) / 2) {
+                    return false;
+                }
+                new_capacity *= 2;
+            }
+            void* mem = allocate(alloc, new_capacity * sizeof(stratcom_compact_event));
+            if(!mem) { return false; }
+            if(buffer.size != 0) {
+                std::memcpy(mem, buffer.events, buffer.size * sizeof(stratcom_compact_event));
+            }
+            deallocate(buffer.events);
+            buffer.events = static_cast<stratcom_compact_event*>(mem);
+            buffer.capacity = new_capacity;
+            return true;
+        }
+
+#if defined(LIBSTRATCOM_STATE_DIFF_SSE2)
+        /** Compare four adjacent pairs of states at once.
+         * Loads the 48 bytes of four states and the same 48 bytes shifted by one state and compares them
+         * byte-wise, so that bits [12*k, 12*k+12) of the result are the changed bytes of pair k.
+         */
+        std::uint64_t changedBytesX4(unsigned char const* p)
+        {
+            __m128i const a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+            __m128i const a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16));
+            __m128i const a2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 32));
+            __m128i const b0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + STATE_SIZE));
+            __m128i const b1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + STATE_SIZE + 16));
+            __m128i const b2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + STATE_SIZE + 32));
+            std::uint64_t const equal =
+                static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a0, b0)))) |
+                (static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a1, b1)))) << 16) |
+                (static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a2, b2)))) << 32);
+            return ~equal & 0xffffffffffffull;
+        }
+#endif
+    }
+
+    bool diffStatesBulk(allocator const& alloc, stratcom_input_state const* states, std::size_t n,
+                        stratcom_compact_event_buffer& buffer)
+    {
+        std::size_t const initial_size = buffer.size;
+        std::size_t i = 1;
+#if defined(LIBSTRATCOM_STATE_DIFF_SSE2)
+        static_assert((sizeof(stratcom_input_state) == STATE_SIZE) && (offsetof(stratcom_input_state, slider) == 8),
+                      "Byte masks do not match the layout of stratcom_input_state.");
+        unsigned char const* const bytes = reinterpret_cast<unsigned char const*>(states);
+        // pairs (i-1, i) up to (i+2, i+3) read the states [i-1, i+3]
+        for(; i + 4 <= n; i += 4) {
+            std::uint64_t const changed = changedBytesX4(bytes + (i - 1) * STATE_SIZE);
+            if(changed == 0) { continue; }
+            if(!reserve(alloc, buffer, 4 * MAX_EVENTS_PER_STATE)) {
+                buffer.size = initial_size;
+                return false;
+            }
+            stratcom_compact_event* out = buffer.events + buffer.size;
+            for(std::size_t k = 0; k < 4; ++k) {
+                unsigned const changed_bytes = static_cast<unsigned>(changed >> (k * STATE_SIZE)) & 0xfff;
+                if(changed_bytes != 0) {
+                    out = emitEvents(states[i + k - 1], states[i + k], i + k, changed_bytes, out);
+                }
+            }
+            buffer.size = static_cast<std::size_t>(out - buffer.events);
+        }
+#endif
+        for(; i < n; ++i) {
+            unsigned const changed_bytes = changedBytes(states[i - 1], states[i]);
+            if(changed_bytes == 0) { continue; }
+            if(!reserve(alloc, buffer, MAX_EVENTS_PER_STATE)) {
+                buffer.size = initial_size;
+                return false;
+            }
+            stratcom_compact_event* const out = buffer.events + buffer.size;
+            buffer.size = static_cast<std::size_t>(emitEvents(states[i - 1], states[i], i, changed_bytes, out) -
+                                                   buffer.events);
+        }
+        return true;
+    }
+
+    void freeCompactEventBuffer(stratcom_compact_event_buffer& buffer)
+    {
+        deallocate(buffer.events);
+        buffer.events = nullptr;
+        buffer.size = 0;
+        buffer.capacity = 0;
+    }
+}
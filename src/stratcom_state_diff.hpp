@@ -0,0 +1,45 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_STATE_DIFF_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_STATE_DIFF_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+
+namespace stratcom_internal {
+
+    /** \internal Append the events for all pairs of adjacent states to a compact event buffer.
+     * @see stratcom_diff_states_bulk()
+     * @return false if the buffer could not be grown.
+     */
+    bool diffStatesBulk(allocator const& alloc, stratcom_input_state const* states, std::size_t n,
+                        stratcom_compact_event_buffer& buffer);
+
+    /** @see stratcom_free_compact_event_buffer()
+     */
+    void freeCompactEventBuffer(stratcom_compact_event_buffer& buffer);
+}
+
+#endif
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_state_history.hpp"
+
+namespace stratcom_internal {
+
+    namespace {
+        std::size_t const npos = static_cast<std::size_t>(-1);
+    }
+
+    state_history::state_history(allocator const& alloc, std::size_t capacity)
+        :m_capacity(capacity), m_size(0), m_head(0),
+         m_timestamps(createArray<stratcom_timestamp>(alloc, capacity)),
+         m_buttons(createArray<stratcom_button_word>(alloc, capacity)),
+         m_slider(createArray<std::uint8_t>(alloc, capacity))
+    {
+        for(auto& a : m_axis) {
+            a.reset(createArray<stratcom_axis_word>(alloc, capacity));
+        }
+    }
+
+    bool state_history::isValid() const
+    {
+        return (m_capacity > 0) && m_timestamps && m_buttons && m_axis[0] && m_axis[1] && m_axis[2] && m_slider;
+    }
+
+    std::size_t state_history::getSize() const
+    {
+        return m_size;
+    }
+
+    bool state_history::push(stratcom_timestamp timestamp, stratcom_input_state const& state)
+    {
+        if((m_size > 0) && (timestamp < m_timestamps[physicalIndex(m_size - 1)])) {
+            return false;
+        }
+        std::size_t idx;
+        if(m_size < m_capacity) {
+            idx = physicalIndex(m_size);
+            ++m_size;
+        } else {
+            // overwrite the oldest state
+            idx = m_head;
+            m_head = (m_head + 1) % m_capacity;
+        }
+        m_timestamps[idx] = timestamp;
+        m_buttons[idx] = state.buttons;
+        m_axis[STRATCOM_AXIS_X][idx] = state.axisX;
+        m_axis[STRATCOM_AXIS_Y][idx] = state.axisY;
+        m_axis[STRATCOM_AXIS_Z][idx] = state.axisZ;
+        m_slider[idx] = static_cast<std::uint8_t>(state.slider);
+        return true;
+    }
+
+    bool state_history::getStateAt(stratcom_timestamp t, stratcom_input_state& out_state) const
+    {
+        std::size_t const index = findAtOrBefore(t);
+        if(index == npos) {
+            return false;
+        }
+        std::size_t const idx = physicalIndex(index);
+        out_state.buttons = m_buttons[idx];
+        out_state.axisX = m_axis[STRATCOM_AXIS_X][idx];
+        out_state.axisY = m_axis[STRATCOM_AXIS_Y][idx];
+        out_state.axisZ = m_axis[STRATCOM_AXIS_Z][idx];
+        out_state.slider = static_cast<stratcom_slider_state>(m_slider[idx]);
+        return true;
+    }
+
+    bool state_history::queryButtons(stratcom_timestamp t0, stratcom_timestamp t1,
+                                     stratcom_button_word& out_held_any,
+                                     stratcom_button_word& out_held_throughout) const
+    {
+        std::size_t first, last;
+        if(!findRange(t0, t1, first, last)) {
+            return false;
+        }
+        stratcom_button_word any = 0;
+        stratcom_button_word all = static_cast<stratcom_button_word>(~0u);
+        stratcom_button_word const* buttons = m_buttons.get();
+        forEachSegment(first, last, [&any, &all, buttons](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; ++i) {
+                any |= buttons[i];
+                all &= buttons[i];
+            }
+        });
+        out_held_any = any;
+        out_held_throughout = all;
+        return true;
+    }
+
+    bool state_history::queryAxisRange(stratcom_axis axis, stratcom_timestamp t0, stratcom_timestamp t1,
+                                       stratcom_axis_word& out_min, stratcom_axis_word& out_max) const
+    {
+        std::size_t first, last;
+        if((axis < STRATCOM_AXIS_X) || (axis > STRATCOM_AXIS_Z) || !findRange(t0, t1, first, last)) {
+            return false;
+        }
+        stratcom_axis_word const* values = m_axis[axis].get();
+        stratcom_axis_word min_value = values[physicalIndex(first)];
+        stratcom_axis_word max_value = min_value;
+        forEachSegment(first, last, [&min_value, &max_value, values](std::size_t begin, std::size_t end) {
+            for(std::size_t i = begin; i < end; ++i) {
+                min_value = (values[i] < min_value) ? values[i] : min_value;
+                max_value = (values[i] > max_value) ? values[i] : max_value;
+            }
+        });
+        out_min = min_value;
+        out_max = max_value;
+        return true;
+    }
+
+    std::size_t state_history::physicalIndex(std::size_t index) const
+    {
+        std::size_t const idx = m_head + index;
+        return (idx < m_capacity) ? idx : (idx - m_capacity);
+    }
+
+    /** Binary search for the newest state that became effective at or before t.
+     * @return Logical index of the state or npos if t is older than all states in the history.
+     */
+    std::size_t state_history::findAtOrBefore(stratcom_timestamp t) const
+    {
+        std::size_t first = 0;
+        std::size_t last = m_size;
+        while(first < last) {
+            std::size_t const mid = first + (last - first) / 2;
+            if(m_timestamps[physicalIndex(mid)] <= t) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return (first == 0) ? npos : (first - 1);
+    }
+
+    /** Determine the logical index range of all states that were effective at any point in [t0, t1].
+     */
+    bool state_history::findRange(stratcom_timestamp t0, stratcom_timestamp t1, std::size_t& out_first,
+                                  std::size_t& out_last) const
+    {
+        if(t1 < t0) {
+            return false;
+        }
+        out_last = findAtOrBefore(t1);
+        if(out_last == npos) {
+            return false;
+        }
+        std::size_t const first = findAtOrBefore(t0);
+        out_first = (first == npos) ? 0 : first;
+        return true;
+    }
+}
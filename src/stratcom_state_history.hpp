@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_STATE_HISTORY_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_STATE_HISTORY_HPP_
+
+#include <stratcom.h>
+
+#include "stratcom_allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Ring buffer of timestamped input states in structure-of-arrays layout.
+     * Each field of the input state is kept in its own array, packed to its natural size. Queries over a
+     * range of states therefore run over at most two contiguous segments per array, one on either side of
+     * the wrap-around point of the ring.
+     * Indices passed between the member functions are logical indices, where 0 is the oldest state.
+     */
+    class state_history {
+    private:
+        std::size_t m_capacity;
+        std::size_t m_size;
+        std::size_t m_head;                             ///< physical index of the oldest state.
+        allocated_array<stratcom_timestamp> m_timestamps;
+        allocated_array<stratcom_button_word> m_buttons;
+        allocated_array<stratcom_axis_word> m_axis[3];
+        allocated_array<std::uint8_t> m_slider;
+    public:
+        state_history(allocator const& alloc, std::size_t capacity);
+
+        /** Check whether the arrays were allocated successfully.
+         */
+        bool isValid() const;
+
+        std::size_t getSize() const;
+
+        /** @see stratcom_state_history_push()
+         */
+        bool push(stratcom_timestamp timestamp, stratcom_input_state const& state);
+
+        /** @see stratcom_state_history_get_state_at()
+         */
+        bool getStateAt(stratcom_timestamp t, stratcom_input_state& out_state) const;
+
+        /** @see stratcom_state_history_query_buttons()
+         */
+        bool queryButtons(stratcom_timestamp t0, stratcom_timestamp t1,
+                          stratcom_button_word& out_held_any, stratcom_button_word& out_held_throughout) const;
+
+        /** @see stratcom_state_history_query_axis_range()
+         */
+        bool queryAxisRange(stratcom_axis axis, stratcom_timestamp t0, stratcom_timestamp t1,
+                            stratcom_axis_word& out_min, stratcom_axis_word& out_max) const;
+
+    private:
+        std::size_t physicalIndex(std::size_t index) const;
+        std::size_t findAtOrBefore(stratcom_timestamp t) const;
+        bool findRange(stratcom_timestamp t0, stratcom_timestamp t1, std::size_t& out_first,
+                       std::size_t& out_last) const;
+
+        /** Invoke f(begin, end) for the physical array segments that make up the logical index range
+         * [first, last].
+         */
+        template<typename Func>
+        void forEachSegment(std::size_t first, std::size_t last, Func&& f) const
+        {
+            std::size_t const begin = physicalIndex(first);
+            std::size_t const count = last - first + 1;
+            if(begin + count <= m_capacity) {
+                f(begin, begin + count);
+            } else {
+                f(begin, m_capacity);
+                f(std::size_t(0), begin + count - m_capacity);
+            }
+        }
+
+        state_history(state_history const&);              // = delete
+        state_history& operator=(state_history const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,179 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_TIMER_WHEEL_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_TIMER_WHEEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Hierarchical timer wheel.
+     * Timers are intrusive list nodes owned by the caller, so the wheel never allocates.
+     * Starting and cancelling a timer are O(1). Timers are kept in one of LEVELS wheels of SLOTS
+     * slots each, where a slot on level L spans SLOTS^L ticks. Whenever the current tick enters a new
+     * slot on a higher level, the timers in that slot are redistributed to the lower levels.
+     */
+    class timer_wheel {
+    public:
+        /** A timer. Must not be moved or destroyed while it is scheduled.
+         */
+        struct timer {
+            timer* prev;
+            timer* next;
+            std::uint64_t expiry;                       ///< tick at which the timer expires.
+            std::uint32_t id;                           ///< user-defined identifier.
+
+            timer()
+                :prev(nullptr), next(nullptr), expiry(0), id(0)
+            {}
+
+            bool isScheduled() const
+            {
+                return prev != nullptr;
+            }
+        };
+    private:
+        static unsigned const SLOT_BITS = 6;
+        static unsigned const SLOTS = (1u << SLOT_BITS);
+        static unsigned const LEVELS = 4;
+
+        timer m_slots[LEVELS][SLOTS];                   ///< sentinel nodes of circular lists.
+        std::uint64_t m_current;                        ///< the current tick.
+        std::size_t m_scheduled;                        ///< number of scheduled timers.
+    public:
+        explicit timer_wheel(std::uint64_t current_tick)
+            :m_current(current_tick), m_scheduled(0)
+        {
+            for(unsigned l = 0; l < LEVELS; ++l) {
+                for(unsigned s = 0; s < SLOTS; ++s) {
+                    m_slots[l][s].prev = &m_slots[l][s];
+                    m_slots[l][s].next = &m_slots[l][s];
+                }
+            }
+        }
+
+        std::uint64_t currentTick() const
+        {
+            return m_current;
+        }
+
+        /** Schedule a timer. A timer that is already scheduled is rescheduled.
+         * Timers that would expire at or before the current tick expire at the next tick.
+         */
+        void schedule(timer& t, std::uint64_t expiry_tick)
+        {
+            if(t.isScheduled()) { cancel(t); }
+            t.expiry = (expiry_tick > m_current) ? expiry_tick : (m_current + 1);
+            insert(t);
+            ++m_scheduled;
+        }
+
+        /** Cancel a scheduled timer. Cancelling a timer that is not scheduled has no effect.
+         */
+        void cancel(timer& t)
+        {
+            if(!t.isScheduled()) { return; }
+            unlink(t);
+            --m_scheduled;
+        }
+
+        /** Advance the current tick, expiring all timers up to and including the new tick.
+         * @param[in] tick The new current tick. Ticks before the current tick are ignored.
+         * @param[in] on_expired Function object called with a reference to each expired timer, in order of expiry.
+         *                       It may schedule and cancel timers.
+         */
+        template<typename Func>
+        void advance(std::uint64_t tick, Func&& on_expired)
+        {
+            while(m_current < tick) {
+                if(m_scheduled == 0) {
+                    m_current = tick;
+                    return;
+                }
+                ++m_current;
+                for(unsigned l = 1; l < LEVELS; ++l) {
+                    if((m_current & ((std::uint64_t(1) << (l * SLOT_BITS)) - 1)) != 0) { break; }
+                    cascade(l, slotIndex(m_current, l));
+                }
+                timer& head = m_slots[0][slotIndex(m_current, 0)];
+                while(head.next != &head) {
+                    timer& t = *head.next;
+                    unlink(t);
+                    --m_scheduled;
+                    on_expired(t);
+                }
+            }
+        }
+    private:
+        static unsigned slotIndex(std::uint64_t tick, unsigned level)
+        {
+            return static_cast<unsigned>((tick >> (level * SLOT_BITS)) & (SLOTS - 1));
+        }
+
+        void insert(timer& t)
+        {
+            std::uint64_t const delta = t.expiry - m_current;
+            unsigned level = 0;
+            while((level + 1 < LEVELS) && (delta >= (std::uint64_t(1) << ((level + 1) * SLOT_BITS)))) {
+                ++level;
+            }
+            std::uint64_t slot_tick = t.expiry;
+            std::uint64_t const range = (std::uint64_t(1) << (LEVELS * SLOT_BITS));
+            if(delta >= range) {
+                // beyond the range of the wheel; park in the farthest slot and redistribute from there
+                slot_tick = m_current + range - 1;
+            }
+            timer& head = m_slots[level][slotIndex(slot_tick, level)];
+            t.prev = head.prev;
+            t.next = &head;
+            head.prev->next = &t;
+            head.prev = &t;
+        }
+
+        static void unlink(timer& t)
+        {
+            t.prev->next = t.next;
+            t.next->prev = t.prev;
+            t.prev = nullptr;
+            t.next = nullptr;
+        }
+
+        void cascade(unsigned level, unsigned slot)
+        {
+            timer& head = m_slots[level][slot];
+            timer* it = head.next;
+            head.prev = &head;
+            head.next = &head;
+            while(it != &head) {
+                timer* next = it->next;
+                insert(*it);
+                it = next;
+            }
+        }
+
+        timer_wheel(timer_wheel const&);              // = delete
+        timer_wheel& operator=(timer_wheel const&);   // = delete
+    };
+}
+
+#endif
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_trace.hpp"
+
+#ifdef LIBSTRATCOM_TRACING
+
+#include "stratcom_allocator.hpp"
+
+#include <cstdio>
+#include <mutex>
+
+namespace stratcom_internal {
+
+    std::atomic<bool> g_trace_enabled(true);
+
+    namespace {
+        std::size_t const TRACE_BUFFER_CAPACITY = 16384;
+
+        struct trace_event {
+            char const* name;
+            std::uint64_t begin;
+            std::uint64_t end;
+        };
+
+        /** Single-producer single-consumer ring of spans.
+         * The owning thread is the only producer; traceExport() is the only consumer.
+         * Buffers are never freed. When a thread exits, its buffer is released for reuse by a later thread.
+         */
+        struct trace_buffer {
+            trace_event events[TRACE_BUFFER_CAPACITY];
+            std::atomic<std::uint64_t> write_pos;
+            std::atomic<std::uint64_t> read_pos;
+            std::atomic<std::uint64_t> dropped;
+            std::atomic<bool> in_use;
+            std::uint32_t thread_id;                    ///< tid reported in the trace.
+            trace_buffer* next;
+        };
+
+        std::atomic<trace_buffer*> g_trace_buffers(nullptr);
+        std::atomic<std::uint32_t> g_next_thread_id(1);
+        std::mutex g_export_mutex;
+
+        trace_buffer* acquireBuffer()
+        {
+            for(trace_buffer* b = g_trace_buffers.load(std::memory_order_acquire); b; b = b->next) {
+                bool expected = false;
+                if(b->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return b;
+                }
+            }
+            trace_buffer* b = create<trace_buffer>(getGlobalAllocator());
+            if(!b) { return nullptr; }
+            b->write_pos.store(0, std::memory_order_relaxed);
+            b->read_pos.store(0, std::memory_order_relaxed);
+            b->dropped.store(0, std::memory_order_relaxed);
+            b->in_use.store(true, std::memory_order_relaxed);
+            b->thread_id = g_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+            b->next = g_trace_buffers.load(std::memory_order_relaxed);
+            while(!g_trace_buffers.compare_exchange_weak(b->next, b, std::memory_order_release)) {}
+            return b;
+        }
+
+        struct thread_buffer_holder {
+            trace_buffer* buffer;
+            bool has_acquired;
+
+            ~thread_buffer_holder()
+            {
+                if(buffer) { buffer->in_use.store(false, std::memory_order_release); }
+            }
+        };
+
+        thread_local thread_buffer_holder t_trace_buffer = { nullptr, false };
+
+        void writeTimestamp(std::FILE* f, std::uint64_t ns)
+        {
+            std::fprintf(f, "%llu.%03u", static_cast<unsigned long long>(ns / 1000),
+                         static_cast<unsigned>(ns % 1000));
+        }
+    }
+
+    void traceRecord(char const* name, std::uint64_t begin, std::uint64_t end)
+    {
+        thread_buffer_holder& holder = t_trace_buffer;
+        if(!holder.has_acquired) {
+            holder.buffer = acquireBuffer();
+            holder.has_acquired = true;
+        }
+        trace_buffer* b = holder.buffer;
+        if(!b) { return; }
+        std::uint64_t const w = b->write_pos.load(std::memory_order_relaxed);
+        if(w - b->read_pos.load(std::memory_order_acquire) >= TRACE_BUFFER_CAPACITY) {
+            b->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        trace_event& e = b->events[w % TRACE_BUFFER_CAPACITY];
+        e.name = name;
+        e.begin = begin;
+        e.end = end;
+        b->write_pos.store(w + 1, std::memory_order_release);
+    }
+
+    bool traceExport(char const* filename)
+    {
+        std::lock_guard<std::mutex> lk(g_export_mutex);
+        std::FILE* f = std::fopen(filename, "w");
+        if(!f) { return false; }
+        std::fputs("{\"traceEvents\":[\n", f);
+        bool first = true;
+        std::uint64_t dropped = 0;
+        for(trace_buffer* b = g_trace_buffers.load(std::memory_order_acquire); b; b = b->next) {
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                            "\"args\":{\"name\":\"libstratcom %u\"}}",
+                         (first ? "" : ",\n"), b->thread_id, b->thread_id);
+            first = false;
+            std::uint64_t const w = b->write_pos.load(std::memory_order_acquire);
+            std::uint64_t const r = b->read_pos.load(std::memory_order_relaxed);
+            for(std::uint64_t i = r; i < w; ++i) {
+                trace_event const& e = b->events[i % TRACE_BUFFER_CAPACITY];
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"stratcom\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":",
+                             e.name, b->thread_id);
+                writeTimestamp(f, e.begin);
+                std::fputs(",\"dur\":", f);
+                writeTimestamp(f, e.end - e.begin);
+                std::fputs("}", f);
+            }
+            b->read_pos.store(w, std::memory_order_release);
+            dropped += b->dropped.exchange(0, std::memory_order_relaxed);
+        }
+        std::fprintf(f, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_spans\":\"%llu\"}}\n",
+                     static_cast<unsigned long long>(dropped));
+        bool const success = (std::ferror(f) == 0);
+        return (std::fclose(f) == 0) && success;
+    }
+}
+
+#endif
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_TRACE_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_TRACE_HPP_
+
+/** \internal
+ * Tracing.
+ * Tracing is compiled in only if LIBSTRATCOM_TRACING is defined. Otherwise STRATCOM_TRACE_SCOPE expands to
+ * nothing and the tracing functions of the C interface report an error.
+ *
+ * STRATCOM_TRACE_SCOPE(name) records a span from its point of declaration to the end of the enclosing scope.
+ * Spans are recorded into a buffer owned by the calling thread without any locking. The name must be a
+ * string literal.
+ */
+#ifdef LIBSTRATCOM_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    extern std::atomic<bool> g_trace_enabled;
+
+    /** Current time in nanoseconds on the trace clock.
+     */
+    inline std::uint64_t traceClock()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /** Record a completed span into the buffer of the calling thread.
+     * If the buffer is full, the span is dropped.
+     */
+    void traceRecord(char const* name, std::uint64_t begin, std::uint64_t end);
+
+    /** Write all spans recorded since the previous export to a file in Chrome Trace Event JSON format.
+     * Exported spans are removed from the thread buffers.
+     */
+    bool traceExport(char const* filename);
+
+    /** RAII span.
+     */
+    class trace_scope {
+    private:
+        char const* m_name;
+        std::uint64_t m_begin;                          ///< 0 if tracing was disabled on construction.
+    public:
+        explicit trace_scope(char const* name)
+            :m_name(name), m_begin(g_trace_enabled.load(std::memory_order_relaxed) ? traceClock() : 0)
+        {}
+
+        ~trace_scope()
+        {
+            if(m_begin != 0) { traceRecord(m_name, m_begin, traceClock()); }
+        }
+    private:
+        trace_scope(trace_scope const&);              // = delete
+        trace_scope& operator=(trace_scope const&);   // = delete
+    };
+}
+
+#   define STRATCOM_TRACE_CONCAT_IMPL(a, b) a##b
+#   define STRATCOM_TRACE_CONCAT(a, b) STRATCOM_TRACE_CONCAT_IMPL(a, b)
+#   define STRATCOM_TRACE_SCOPE(name) \
+        stratcom_internal::trace_scope STRATCOM_TRACE_CONCAT(stratcom_trace_scope_, __LINE__)(name)
+#else
+#   define STRATCOM_TRACE_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_velocity.hpp"
+
+namespace stratcom_internal {
+
+    namespace {
+        std::int64_t const MICROSECONDS_PER_SECOND = 1000000;
+        /** Filter weight 1.0.
+         */
+        std::int64_t const WEIGHT_ONE = (std::int64_t(1) << 16);
+        /** Bound for fixed point values, leaving enough headroom for the intermediate products.
+         */
+        std::int64_t const FIXED_LIMIT = (std::int64_t(1) << 44);
+
+        std::int64_t clamp(std::int64_t v, std::int64_t limit)
+        {
+            return (v > limit) ? limit : ((v < -limit) ? -limit : v);
+        }
+
+        std::int32_t toInt32(std::int64_t fixed, unsigned fraction_bits)
+        {
+            std::int64_t const v = fixed / (std::int64_t(1) << fraction_bits);
+            return static_cast<std::int32_t>(clamp(v, 0x7fffffff));
+        }
+    }
+
+    axis_velocity_estimator::axis_velocity_estimator()
+        :m_smoothing_time(0), m_has_position(false), m_position(0), m_timestamp(0), m_velocity(0),
+         m_acceleration(0)
+    {
+    }
+
+    void axis_velocity_estimator::setSmoothingTime(std::uint32_t smoothing_microseconds)
+    {
+        m_smoothing_time = smoothing_microseconds;
+        m_has_position = false;
+        m_velocity = 0;
+        m_acceleration = 0;
+    }
+
+    std::uint32_t axis_velocity_estimator::getSmoothingTime() const
+    {
+        return m_smoothing_time;
+    }
+
+    bool axis_velocity_estimator::isEnabled() const
+    {
+        return m_smoothing_time != 0;
+    }
+
+    void axis_velocity_estimator::update(stratcom_axis_word position, stratcom_timestamp timestamp)
+    {
+        if(m_has_position && (timestamp <= m_timestamp)) {
+            // reports drained in one wakeup share a timestamp; keep the last sample so that the next
+            // update accounts for the whole distance travelled since
+            return;
+        }
+        if(m_has_position) {
+            std::int64_t const dt = static_cast<std::int64_t>(timestamp - m_timestamp);
+            // weight of the new sample as dt / (dt + smoothing time)
+            std::int64_t const weight = (dt >= FIXED_LIMIT) ? WEIGHT_ONE :
+                ((dt * WEIGHT_ONE) / (dt + static_cast<std::int64_t>(m_smoothing_time)));
+            std::int64_t const distance = static_cast<std::int64_t>(position) - m_position;
+            std::int64_t const velocity = (distance * MICROSECONDS_PER_SECOND * (1 << FRACTION_BITS)) / dt;
+            std::int64_t const new_velocity = m_velocity + (((velocity - m_velocity) * weight) / WEIGHT_ONE);
+            std::int64_t const acceleration = clamp(((new_velocity - m_velocity) * MICROSECONDS_PER_SECOND) / dt,
+                                                    FIXED_LIMIT);
+            m_acceleration += ((acceleration - m_acceleration) * weight) / WEIGHT_ONE;
+            m_velocity = new_velocity;
+        }
+        m_position = position;
+        m_timestamp = timestamp;
+        m_has_position = true;
+    }
+
+    std::int64_t axis_velocity_estimator::decay(std::int64_t value, stratcom_timestamp now) const
+    {
+        if(!m_has_position || (now <= m_timestamp)) {
+            return value;
+        }
+        // the filter applied to a stationary axis over the elapsed time
+        std::int64_t const elapsed = static_cast<std::int64_t>(now - m_timestamp);
+        if(elapsed >= FIXED_LIMIT) { return 0; }
+        std::int64_t const smoothing = static_cast<std::int64_t>(m_smoothing_time);
+        std::int64_t const weight = (smoothing * WEIGHT_ONE) / (elapsed + smoothing);
+        return (value * weight) / WEIGHT_ONE;
+    }
+
+    std::int32_t axis_velocity_estimator::getVelocity() const
+    {
+        return toInt32(m_velocity, FRACTION_BITS);
+    }
+
+    std::int32_t axis_velocity_estimator::getVelocity(stratcom_timestamp now) const
+    {
+        return toInt32(decay(m_velocity, now), FRACTION_BITS);
+    }
+
+    std::int32_t axis_velocity_estimator::getAcceleration(stratcom_timestamp now) const
+    {
+        return toInt32(decay(m_acceleration, now), FRACTION_BITS);
+    }
+}
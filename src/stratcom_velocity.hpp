@@ -0,0 +1,83 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_VELOCITY_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_VELOCITY_HPP_
+
+#include <stratcom.h>
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal Estimates velocity and acceleration of an axis from its positions at irregular points in time.
+     * Each update computes the difference quotient to the previous update and blends it into the estimate with
+     * an exponential filter. The weight of the new value is dt / (dt + smoothing time), which equals the decay
+     * an exponential filter with the smoothing time as time constant would apply over dt to first order.
+     * This keeps the response independent of the report rate. All arithmetic is in 64-bit fixed point with
+     * FRACTION_BITS fractional bits and the estimator never allocates.
+     */
+    class axis_velocity_estimator {
+    private:
+        static unsigned const FRACTION_BITS = 8;
+
+        std::uint32_t m_smoothing_time;                 ///< time constant in microseconds. 0 if disabled.
+        bool m_has_position;                            ///< true if m_position and m_timestamp are valid.
+        stratcom_axis_word m_position;                  ///< position at the last update.
+        stratcom_timestamp m_timestamp;                 ///< time of the last update.
+        std::int64_t m_velocity;                        ///< positions per second, fixed point.
+        std::int64_t m_acceleration;                    ///< positions per second squared, fixed point.
+    public:
+        axis_velocity_estimator();
+
+        /** Enable or disable the estimator, resetting its estimates.
+         * @param[in] smoothing_microseconds Time constant of the filter. 0 disables the estimator.
+         */
+        void setSmoothingTime(std::uint32_t smoothing_microseconds);
+
+        bool isEnabled() const;
+
+        std::uint32_t getSmoothingTime() const;
+
+        /** Feed the position of the axis at a point in time.
+         * Updates with a timestamp not newer than the previous update are ignored, so that the movement is
+         * attributed to the next update with a newer timestamp.
+         */
+        void update(stratcom_axis_word position, stratcom_timestamp timestamp);
+
+        /** The velocity estimated by the last update, in positions per second.
+         */
+        std::int32_t getVelocity() const;
+
+        /** The velocity estimate at a point in time, assuming the axis did not move since the last update.
+         */
+        std::int32_t getVelocity(stratcom_timestamp now) const;
+
+        /** The acceleration estimate at a point in time, assuming the axis did not move since the last update,
+         * in positions per second squared.
+         */
+        std::int32_t getAcceleration(stratcom_timestamp now) const;
+    private:
+        std::int64_t decay(std::int64_t value, stratcom_timestamp now) const;
+    };
+}
+
+#endif
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+#include "stratcom_wait.hpp"
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace stratcom_internal {
+
+    namespace {
+        /** Intervals between reports above this are pauses in input and not used for the estimate.
+         */
+        stratcom_timestamp const MAX_INTERVAL_SAMPLE = 1000000;
+
+        unsigned bucketIndex(std::uint64_t latency)
+        {
+            unsigned ret = 0;
+            while((ret + 1 < STRATCOM_LATENCY_HISTOGRAM_BUCKETS) && ((latency >> (ret + 1)) != 0)) { ++ret; }
+            return ret;
+        }
+    }
+
+    std::uint64_t getThreadCpuTime()
+    {
+#ifdef _WIN32
+        FILETIME creation_time, exit_time, kernel_time, user_time;
+        if(!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time)) { return 0; }
+        // in units of 100 nanoseconds
+        std::uint64_t const kernel = (static_cast<std::uint64_t>(kernel_time.dwHighDateTime) << 32) |
+                                     kernel_time.dwLowDateTime;
+        std::uint64_t const user = (static_cast<std::uint64_t>(user_time.dwHighDateTime) << 32) |
+                                   user_time.dwLowDateTime;
+        return (kernel + user) / 10;
+#else
+        timespec ts;
+        if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) { return 0; }
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000 + static_cast<std::uint64_t>(ts.tv_nsec) / 1000;
+#endif
+    }
+
+    input_waiter::input_waiter()
+        :m_last_arrival(0), m_interval(0), m_deviation(0)
+    {
+        resetStatistics();
+    }
+
+    void input_waiter::getStatistics(stratcom_wait_policy_type type, stratcom_wait_statistics& out_statistics) const
+    {
+        out_statistics = m_statistics[type];
+    }
+
+    void input_waiter::resetStatistics()
+    {
+        std::memset(m_statistics, 0, sizeof(m_statistics));
+    }
+
+    void input_waiter::planWait(stratcom_wait_policy const& policy, stratcom_timestamp now,
+                                stratcom_timestamp& out_block_until, stratcom_timestamp& out_spin_until) const
+    {
+        out_block_until = 0;
+        out_spin_until = 0;
+        switch(policy.type) {
+        case STRATCOM_WAIT_BLOCK:
+            break;
+        case STRATCOM_WAIT_SPIN_THEN_BLOCK:
+            out_spin_until = now + policy.spin_microseconds;
+            break;
+        case STRATCOM_WAIT_ADAPTIVE:
+            if(m_interval == 0) {
+                // nothing learned yet
+                out_spin_until = now + std::min(policy.spin_microseconds, policy.max_spin_microseconds);
+            } else {
+                stratcom_timestamp const margin = std::max<stratcom_timestamp>(policy.spin_microseconds,
+                                                                               2 * m_deviation);
+                stratcom_timestamp const expected = m_last_arrival + m_interval;
+                stratcom_timestamp const spin_begin = std::max(now, (expected > margin) ? (expected - margin) : 0);
+                stratcom_timestamp const spin_end = std::min(expected + margin,
+                                                             spin_begin + policy.max_spin_microseconds);
+                if(spin_end > spin_begin) {
+                    out_block_until = spin_begin;
+                    out_spin_until = spin_end;
+                }
+            }
+            break;
+        }
+    }
+
+    void input_waiter::record(stratcom_wait_policy_type type, wakeup_type wakeup, stratcom_timestamp start,
+                              stratcom_timestamp end, stratcom_timestamp arrival, std::uint64_t cpu_time)
+    {
+        stratcom_wait_statistics& s = m_statistics[type];
+        ++s.waits;
+        s.wait_time += end - start;
+        s.cpu_time += cpu_time;
+        switch(wakeup) {
+        case WAKEUP_IMMEDIATE: ++s.immediate_wakeups; break;
+        case WAKEUP_SPIN:      ++s.spin_wakeups;      break;
+        case WAKEUP_BLOCK:     ++s.block_wakeups;     break;
+        }
+        if(wakeup != WAKEUP_IMMEDIATE) {
+            stratcom_latency_histogram& h = s.wakeup_latency;
+            std::uint64_t const latency = (end > arrival) ? (end - arrival) : 0;
+            h.min = (h.count == 0) ? latency : std::min(h.min, latency);
+            h.max = std::max(h.max, latency);
+            h.sum += latency;
+            ++h.buckets[bucketIndex(latency)];
+            ++h.count;
+        }
+
+        // update the estimate of the time between reports
+        if((m_last_arrival != 0) && (arrival >= m_last_arrival) && (arrival - m_last_arrival <= MAX_INTERVAL_SAMPLE)) {
+            std::int64_t const sample = static_cast<std::int64_t>(arrival - m_last_arrival);
+            if(m_interval == 0) {
+                m_interval = static_cast<stratcom_timestamp>(std::max<std::int64_t>(sample, 1));
+                m_deviation = m_interval / 2;
+            } else {
+                std::int64_t const interval = static_cast<std::int64_t>(m_interval);
+                std::int64_t const error = sample - interval;
+                std::int64_t const abs_error = (error < 0) ? -error : error;
+                std::int64_t const deviation = static_cast<std::int64_t>(m_deviation);
+                m_interval = static_cast<stratcom_timestamp>(std::max<std::int64_t>(interval + error / 8, 1));
+                m_deviation = static_cast<stratcom_timestamp>(deviation + (abs_error - deviation) / 4);
+            }
+        }
+        m_last_arrival = arrival;
+    }
+}
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_WAIT_HPP_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOM_WAIT_HPP_
+
+#include <stratcom.h>
+
+#include <cstdint>
+
+namespace stratcom_internal {
+
+    /** \internal CPU time consumed by the calling thread in microseconds. 0 where not supported.
+     */
+    std::uint64_t getThreadCpuTime();
+
+    /** \internal Waits for input reports according to a stratcom_wait_policy and keeps statistics for each policy.
+     * For the adaptive policy, the time between reports is estimated like a round-trip time in TCP: a moving
+     * average of the interval and of its deviation. Waits then block until shortly before the expected arrival
+     * of the next report and spin from there until shortly after it. If the expected arrival has passed, the
+     * device is considered idle and waits block right away.
+     */
+    class input_waiter {
+    private:
+        enum wakeup_type {
+            WAKEUP_IMMEDIATE,                           ///< the report was available before the wait began.
+            WAKEUP_SPIN,
+            WAKEUP_BLOCK
+        };
+
+        stratcom_wait_statistics m_statistics[STRATCOM_NUMBER_OF_WAIT_POLICIES];
+        stratcom_timestamp m_last_arrival;
+        stratcom_timestamp m_interval;                  ///< average time between reports; 0 while unknown.
+        stratcom_timestamp m_deviation;                 ///< average deviation from m_interval.
+    public:
+        input_waiter();
+
+        /** Wait for and read one input report.
+         * @param[in] policy A valid policy.
+         * @param[in] read Function object with the signature
+         *                 <tt>stratcom_return(int timeout_milliseconds, stratcom_timestamp& out_arrival)</tt>,
+         *                 reading a single report with the semantics of stratcom_read_input_with_timeout().
+         * @return The result of the last read.
+         */
+        template<typename Read>
+        stratcom_return wait(stratcom_wait_policy const& policy, Read&& read)
+        {
+            stratcom_timestamp const start = stratcom_get_timestamp();
+            std::uint64_t const cpu_start = getThreadCpuTime();
+            stratcom_timestamp block_until;
+            stratcom_timestamp spin_until;
+            planWait(policy, start, block_until, spin_until);
+            stratcom_timestamp arrival = 0;
+            // physical devices timestamp a report only once it is read, so check for a report that is
+            // already waiting before the wait begins
+            stratcom_return res = read(0, arrival);
+            wakeup_type wakeup = WAKEUP_IMMEDIATE;
+            stratcom_timestamp now = stratcom_get_timestamp();
+            if((res == STRATCOM_RET_NO_DATA) && (block_until > now)) {
+                wakeup = WAKEUP_BLOCK;
+                int const timeout_milliseconds = static_cast<int>((block_until - now) / 1000);
+                if(timeout_milliseconds > 0) {
+                    res = read(timeout_milliseconds, arrival);
+                    now = stratcom_get_timestamp();
+                }
+            }
+            while((res == STRATCOM_RET_NO_DATA) && (now < spin_until)) {
+                res = read(0, arrival);
+                wakeup = WAKEUP_SPIN;
+                now = stratcom_get_timestamp();
+            }
+            if(res == STRATCOM_RET_NO_DATA) {
+                res = read(-1, arrival);
+                wakeup = WAKEUP_BLOCK;
+                now = stratcom_get_timestamp();
+            }
+            if(res == STRATCOM_RET_SUCCESS) {
+                record(policy.type, (arrival < start) ? WAKEUP_IMMEDIATE : wakeup, start, now, arrival,
+                       getThreadCpuTime() - cpu_start);
+            }
+            return res;
+        }
+
+        void getStatistics(stratcom_wait_policy_type type, stratcom_wait_statistics& out_statistics) const;
+
+        void resetStatistics();
+
+    private:
+        void planWait(stratcom_wait_policy const& policy, stratcom_timestamp now,
+                      stratcom_timestamp& out_block_until, stratcom_timestamp& out_spin_until) const;
+        void record(stratcom_wait_policy_type type, wakeup_type wakeup, stratcom_timestamp start,
+                    stratcom_timestamp end, stratcom_timestamp arrival, std::uint64_t cpu_time);
+
+        input_waiter(input_waiter const&);              // = delete
+        input_waiter& operator=(input_waiter const&);   // = delete
+    };
+}
+
+#endif
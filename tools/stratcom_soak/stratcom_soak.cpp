@@ -0,0 +1,652 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/** @file
+ * stratcom_soak - Soak test and load generator for libstratcom.
+ *
+ * Simulates a number of devices that produce input reports at a configurable rate and pattern.
+ * Each device is fed by a producer thread and drained by a reader thread through the public read API;
+ * devices with an even index are read through the input event API, devices with an odd index through
+ * the input state API. An additional thread drives LED traffic for all devices through LED transactions.
+ *
+ * Results are written to stdout as JSON lines: one "interval" record per reporting interval and a final
+ * "summary" record. Latencies are measured from the time a report is queued on the simulated device
+ * until the reader thread has processed it. Memory is tracked through the library's allocator hooks.
+ */
+#include <stratcom.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    /** Timeout for device reads. Determines how quickly reader threads notice shutdown. */
+    int const READER_TIMEOUT_MILLISECONDS = 100;
+    /** Number of reports sent back-to-back in a burst by the bursty-axes pattern. */
+    unsigned const BURST_LENGTH = 32;
+    /** Producers that fall behind by more than this many reports skip ahead instead of catching up. */
+    unsigned const MAX_PRODUCER_BACKLOG = 1000;
+
+    enum report_pattern {
+        PATTERN_STEADY,                             ///< every report moves an axis by a small amount.
+        PATTERN_BURSTY_AXES,                        ///< bursts of reports with large axis movements.
+        PATTERN_BUTTON_STORM,                       ///< every report toggles several buttons.
+        PATTERN_MIXED                               ///< random mix of the other patterns.
+    };
+
+    char const* const PATTERN_NAMES[] = { "steady", "bursty-axes", "button-storm", "mixed" };
+
+    struct options {
+        unsigned devices;
+        unsigned rate;                              ///< input reports per second and device.
+        double duration;                            ///< in seconds.
+        report_pattern pattern;
+        unsigned led_rate;                          ///< LED transactions per second.
+        double report_interval;                     ///< in seconds.
+        unsigned seed;
+    };
+
+    /** Latency histogram with constant relative error.
+     * Values below 64 are counted exactly. Above that, each power of two is split into 32 buckets,
+     * which bounds the error of a reported percentile to about 3%.
+     */
+    class latency_histogram {
+    private:
+        static unsigned const SUB_BUCKET_BITS = 5;
+        static unsigned const SUB_BUCKETS = (1u << SUB_BUCKET_BITS);
+        static unsigned const LINEAR_LIMIT = 2 * SUB_BUCKETS;
+        static unsigned const NUMBER_OF_BUCKETS = LINEAR_LIMIT + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+        std::uint64_t m_counts[NUMBER_OF_BUCKETS];
+        std::uint64_t m_total;
+        std::uint64_t m_max;
+    public:
+        latency_histogram()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            std::memset(m_counts, 0, sizeof(m_counts));
+            m_total = 0;
+            m_max = 0;
+        }
+
+        void record(std::uint64_t value)
+        {
+            ++m_counts[bucketIndex(value)];
+            ++m_total;
+            m_max = std::max(m_max, value);
+        }
+
+        void merge(latency_histogram const& rhs)
+        {
+            for(unsigned i = 0; i < NUMBER_OF_BUCKETS; ++i) { m_counts[i] += rhs.m_counts[i]; }
+            m_total += rhs.m_total;
+            m_max = std::max(m_max, rhs.m_max);
+        }
+
+        std::uint64_t getCount() const
+        {
+            return m_total;
+        }
+
+        std::uint64_t getMax() const
+        {
+            return m_max;
+        }
+
+        /** Smallest bucket bound that at least a fraction q of all values are less than or equal to.
+         */
+        std::uint64_t getPercentile(double q) const
+        {
+            if(m_total == 0) { return 0; }
+            std::uint64_t const rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * m_total + 0.5));
+            std::uint64_t seen = 0;
+            for(unsigned i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+                seen += m_counts[i];
+                if(seen >= rank) { return std::min(bucketUpperBound(i), m_max); }
+            }
+            return m_max;
+        }
+    private:
+        static unsigned bucketIndex(std::uint64_t value)
+        {
+            if(value < LINEAR_LIMIT) { return static_cast<unsigned>(value); }
+            unsigned msb = 0;
+            while((value >> msb) > 1) { ++msb; }
+            unsigned const shift = msb - SUB_BUCKET_BITS;
+            return LINEAR_LIMIT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKETS +
+                   static_cast<unsigned>((value >> shift) - SUB_BUCKETS);
+        }
+
+        static std::uint64_t bucketUpperBound(unsigned index)
+        {
+            if(index < LINEAR_LIMIT) { return index; }
+            unsigned const group = (index - LINEAR_LIMIT) / SUB_BUCKETS;
+            unsigned const sub = (index - LINEAR_LIMIT) % SUB_BUCKETS;
+            unsigned const shift = group + 1;
+            return ((static_cast<std::uint64_t>(SUB_BUCKETS + sub + 1)) << shift) - 1;
+        }
+    };
+
+    /** Latency histogram that is filled by one thread and periodically collected by another.
+     */
+    struct shared_histogram {
+        std::mutex mutex;
+        latency_histogram histogram;
+
+        void record(std::uint64_t value)
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            histogram.record(value);
+        }
+
+        /** Merge the recorded values into target and start over.
+         */
+        void collect(latency_histogram& target)
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            target.merge(histogram);
+            histogram.clear();
+        }
+    };
+
+    /** Memory accounting through the library allocator hooks.
+     */
+    std::atomic<std::uint64_t> g_allocations(0);
+    std::atomic<std::uint64_t> g_deallocations(0);
+    std::atomic<std::int64_t> g_live_bytes(0);
+
+    void* counting_alloc(void*, std::size_t size)
+    {
+        void* ret = std::malloc(size);
+        if(ret) {
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+            g_live_bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+        }
+        return ret;
+    }
+
+    void counting_free(void*, void* ptr, std::size_t size)
+    {
+        g_deallocations.fetch_add(1, std::memory_order_relaxed);
+        g_live_bytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+        std::free(ptr);
+    }
+
+    /** Resident set size of the process in bytes. -1 where not available.
+     */
+    long long get_rss_bytes()
+    {
+        long long ret = -1;
+#ifdef __linux__
+        std::FILE* statm = std::fopen("/proc/self/statm", "r");
+        if(statm) {
+            long long pages_total, pages_resident;
+            if(std::fscanf(statm, "%lld %lld", &pages_total, &pages_resident) == 2) {
+                ret = pages_resident * sysconf(_SC_PAGESIZE);
+            }
+            std::fclose(statm);
+        }
+#endif
+        return ret;
+    }
+
+    struct device_context {
+        stratcom_device* device;
+        unsigned index;
+        shared_histogram latency;
+        std::atomic<std::uint64_t> reports_pushed;
+        std::atomic<std::uint64_t> reports_rejected;
+        std::atomic<std::uint64_t> reports_read;
+        std::atomic<std::uint64_t> events_read;
+        std::atomic<std::uint64_t> read_errors;
+
+        device_context(stratcom_device* dev, unsigned idx)
+            :device(dev), index(idx), reports_pushed(0), reports_rejected(0), reports_read(0), events_read(0),
+             read_errors(0)
+        {}
+    };
+
+    struct led_context {
+        shared_histogram latency;
+        std::atomic<std::uint64_t> commits;
+        std::atomic<std::uint64_t> errors;
+
+        led_context()
+            :commits(0), errors(0)
+        {}
+    };
+
+    std::atomic<bool> g_quit(false);
+
+    stratcom_axis_word clamp_axis(int v)
+    {
+        return static_cast<stratcom_axis_word>(std::max(-512, std::min(511, v)));
+    }
+
+    void producer_thread(device_context& ctx, options const& opts)
+    {
+        std::minstd_rand rng(opts.seed + ctx.index);
+        std::vector<stratcom_button> buttons;
+        for(auto b = stratcom_iterate_buttons_range_begin(); b != stratcom_iterate_buttons_range_end();
+            b = stratcom_iterate_buttons_range_increment(b))
+        {
+            buttons.push_back(b);
+        }
+        stratcom_input_state state;
+        std::memset(&state, 0, sizeof(state));
+        state.slider = STRATCOM_SLIDER_1;
+
+        auto const period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / opts.rate));
+        auto next = std::chrono::steady_clock::now();
+        unsigned burst_position = 0;
+        while(!g_quit.load(std::memory_order_relaxed)) {
+            report_pattern pattern = opts.pattern;
+            if(pattern == PATTERN_MIXED) {
+                pattern = static_cast<report_pattern>(rng() % PATTERN_MIXED);
+            }
+            // every report has to differ from the previous one; the library counts a repeated report as a gap
+            switch(pattern) {
+            case PATTERN_STEADY:
+            {
+                int step = (rng() % 2) ? 1 : -1;
+                if(clamp_axis(state.axisX + step) == state.axisX) { step = -step; }
+                state.axisX = clamp_axis(state.axisX + step);
+                break;
+            }
+            case PATTERN_BURSTY_AXES:
+            {
+                stratcom_axis_word const old_x = state.axisX;
+                do {
+                    state.axisX = clamp_axis(static_cast<int>(rng() % 1024) - 512);
+                } while(state.axisX == old_x);
+                state.axisY = clamp_axis(static_cast<int>(rng() % 1024) - 512);
+                state.axisZ = clamp_axis(static_cast<int>(rng() % 1024) - 512);
+                break;
+            }
+            case PATTERN_BUTTON_STORM:
+            case PATTERN_MIXED:
+            {
+                // toggle distinct buttons, so that no button is toggled back within the same report
+                stratcom_button_word toggled = 0;
+                for(unsigned i = 0, n = 1 + rng() % 3; i < n; ++i) {
+                    stratcom_button b;
+                    do { b = buttons[rng() % buttons.size()]; } while((toggled & b) != 0);
+                    toggled = static_cast<stratcom_button_word>(toggled | b);
+                }
+                state.buttons = static_cast<stratcom_button_word>(state.buttons ^ toggled);
+                if((rng() % 64) == 0) {
+                    state.slider = static_cast<stratcom_slider_state>(STRATCOM_SLIDER_1 + rng() % 3);
+                }
+                break;
+            }
+            }
+
+            if(stratcom_simulated_device_push_state(ctx.device, &state) == STRATCOM_RET_SUCCESS) {
+                ctx.reports_pushed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                ctx.reports_rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // the bursty pattern sends BURST_LENGTH reports back-to-back, then pauses to keep the average rate
+            if(pattern == PATTERN_BURSTY_AXES) {
+                if(++burst_position < BURST_LENGTH) { continue; }
+                burst_position = 0;
+                next += period * BURST_LENGTH;
+            } else {
+                next += period;
+            }
+            auto const now = std::chrono::steady_clock::now();
+            if(next > now) {
+                std::this_thread::sleep_until(next);
+            } else if(now - next > period * MAX_PRODUCER_BACKLOG) {
+                next = now;
+            }
+        }
+    }
+
+    void reader_thread(device_context& ctx)
+    {
+        bool const use_events = ((ctx.index % 2) == 0);
+        while(!g_quit.load(std::memory_order_relaxed)) {
+            stratcom_return res;
+            stratcom_timestamp report_time = 0;
+            if(use_events) {
+                stratcom_input_event* events;
+                res = stratcom_read_input_events(ctx.device, READER_TIMEOUT_MILLISECONDS, &events);
+                if(events) {
+                    report_time = events->timestamp;
+                    std::uint64_t count = 0;
+                    for(auto it = events; it; it = it->next) { ++count; }
+                    ctx.events_read.fetch_add(count, std::memory_order_relaxed);
+                    stratcom_free_input_events(events);
+                }
+            } else {
+                res = stratcom_read_input_with_timeout(ctx.device, READER_TIMEOUT_MILLISECONDS);
+                if(res == STRATCOM_RET_SUCCESS) {
+                    stratcom_input_state const state = stratcom_get_input_state(ctx.device);
+                    (void)state;
+                    report_time = stratcom_get_input_timestamp(ctx.device);
+                }
+            }
+            if(res == STRATCOM_RET_ERROR) {
+                ctx.read_errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(res != STRATCOM_RET_NO_DATA) {
+                ctx.reports_read.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(report_time != 0) {
+                stratcom_timestamp const now = stratcom_get_timestamp();
+                ctx.latency.record((now > report_time) ? (now - report_time) : 0);
+            }
+        }
+    }
+
+    void led_thread(std::vector<std::unique_ptr<device_context>> const& devices, led_context& ctx,
+                    options const& opts)
+    {
+        stratcom_button_led const leds[] = { STRATCOM_LEDBUTTON_1, STRATCOM_LEDBUTTON_2, STRATCOM_LEDBUTTON_3,
+                                             STRATCOM_LEDBUTTON_4, STRATCOM_LEDBUTTON_5, STRATCOM_LEDBUTTON_6,
+                                             STRATCOM_LEDBUTTON_REC };
+        stratcom_led_state const led_states[] = { STRATCOM_LED_ON, STRATCOM_LED_OFF, STRATCOM_LED_BLINK };
+        std::minstd_rand rng(opts.seed + 0x1ED);
+        std::vector<stratcom_led_transaction_result> results(devices.size());
+        auto const period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / opts.led_rate));
+        auto next = std::chrono::steady_clock::now();
+        while(!g_quit.load(std::memory_order_relaxed)) {
+            stratcom_timestamp const start = stratcom_get_timestamp();
+            stratcom_led_transaction* tx = stratcom_begin_led_transaction();
+            stratcom_return res = tx ? STRATCOM_RET_SUCCESS : STRATCOM_RET_ERROR;
+            for(auto const& d : devices) {
+                if(res != STRATCOM_RET_SUCCESS) { break; }
+                res = stratcom_led_transaction_set_button_led_state(tx, d->device, leds[rng() % 7],
+                                                                    led_states[rng() % 3]);
+            }
+            if(res == STRATCOM_RET_SUCCESS) {
+                res = stratcom_commit_led_transaction(tx, results.data());
+            }
+            stratcom_free_led_transaction(tx);
+            stratcom_timestamp const end = stratcom_get_timestamp();
+            ctx.latency.record(end - start);
+            ctx.commits.fetch_add(1, std::memory_order_relaxed);
+            if(res != STRATCOM_RET_SUCCESS) {
+                ctx.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            next += period;
+            auto const now = std::chrono::steady_clock::now();
+            if(next > now) {
+                std::this_thread::sleep_until(next);
+            } else {
+                next = now;
+            }
+        }
+    }
+
+    void print_latency(char const* name, latency_histogram const& h)
+    {
+        std::printf("\"%s\":{\"count\":%" PRIu64 ",\"p50\":%" PRIu64 ",\"p99\":%" PRIu64 ",\"p999\":%" PRIu64
+                    ",\"max\":%" PRIu64 "}",
+                    name, h.getCount(), h.getPercentile(0.5), h.getPercentile(0.99), h.getPercentile(0.999),
+                    h.getMax());
+    }
+
+    /** Counters summed over all devices.
+     */
+    struct totals {
+        std::uint64_t reports_pushed;
+        std::uint64_t reports_rejected;
+        std::uint64_t reports_read;
+        std::uint64_t events_read;
+        std::uint64_t read_errors;
+        std::uint64_t led_commits;
+        std::uint64_t led_errors;
+    };
+
+    totals get_totals(std::vector<std::unique_ptr<device_context>> const& devices, led_context const& leds)
+    {
+        totals ret;
+        std::memset(&ret, 0, sizeof(ret));
+        for(auto const& d : devices) {
+            ret.reports_pushed += d->reports_pushed.load(std::memory_order_relaxed);
+            ret.reports_rejected += d->reports_rejected.load(std::memory_order_relaxed);
+            ret.reports_read += d->reports_read.load(std::memory_order_relaxed);
+            ret.events_read += d->events_read.load(std::memory_order_relaxed);
+            ret.read_errors += d->read_errors.load(std::memory_order_relaxed);
+        }
+        ret.led_commits = leds.commits.load(std::memory_order_relaxed);
+        ret.led_errors = leds.errors.load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    void print_counters(totals const& t)
+    {
+        std::printf("\"reports_pushed\":%" PRIu64 ",\"reports_rejected\":%" PRIu64 ",\"reports_read\":%" PRIu64
+                    ",\"events_read\":%" PRIu64 ",\"read_errors\":%" PRIu64 ",\"led_commits\":%" PRIu64
+                    ",\"led_errors\":%" PRIu64,
+                    t.reports_pushed, t.reports_rejected, t.reports_read, t.events_read, t.read_errors,
+                    t.led_commits, t.led_errors);
+    }
+
+    void print_memory()
+    {
+        std::printf("\"live_bytes\":%" PRId64 ",\"allocations\":%" PRIu64 ",\"deallocations\":%" PRIu64
+                    ",\"rss_bytes\":%lld",
+                    static_cast<std::int64_t>(g_live_bytes.load(std::memory_order_relaxed)),
+                    static_cast<std::uint64_t>(g_allocations.load(std::memory_order_relaxed)),
+                    static_cast<std::uint64_t>(g_deallocations.load(std::memory_order_relaxed)),
+                    get_rss_bytes());
+    }
+
+    void print_usage(char const* program_name)
+    {
+        std::printf("Usage: %s [-d <devices>] [-r <reports_per_second>] [-t <seconds>] [-p <pattern>]\n"
+                    "          [-l <led_transactions_per_second>] [-i <report_interval_seconds>] [-s <seed>]\n",
+                    program_name);
+        std::printf("Drives simulated Strategic Commander devices through libstratcom under sustained load\n"
+                    "and writes throughput, latency and memory statistics to stdout as JSON lines.\n");
+        std::printf("Patterns: steady, bursty-axes, button-storm, mixed (default).\n");
+        std::printf("Defaults: -d 4 -r 1000 -t 10 -l 50 -i 1 -s 1. Pass -l 0 to disable LED traffic.\n");
+    }
+
+    bool parse_pattern(char const* str, report_pattern& out_pattern)
+    {
+        for(int i = 0; i <= PATTERN_MIXED; ++i) {
+            if(std::strcmp(str, PATTERN_NAMES[i]) == 0) {
+                out_pattern = static_cast<report_pattern>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    options opts;
+    opts.devices = 4;
+    opts.rate = 1000;
+    opts.duration = 10.0;
+    opts.pattern = PATTERN_MIXED;
+    opts.led_rate = 50;
+    opts.report_interval = 1.0;
+    opts.seed = 1;
+    for(int i = 1; i < argc; ++i) {
+        bool const has_arg = (i + 1 < argc);
+        if((std::strcmp(argv[i], "-d") == 0) && has_arg) {
+            opts.devices = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if((std::strcmp(argv[i], "-r") == 0) && has_arg) {
+            opts.rate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if((std::strcmp(argv[i], "-t") == 0) && has_arg) {
+            opts.duration = std::strtod(argv[++i], nullptr);
+        } else if((std::strcmp(argv[i], "-p") == 0) && has_arg) {
+            if(!parse_pattern(argv[++i], opts.pattern)) {
+                std::fprintf(stderr, "Unknown pattern %s.\n", argv[i]);
+                return 1;
+            }
+        } else if((std::strcmp(argv[i], "-l") == 0) && has_arg) {
+            opts.led_rate = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if((std::strcmp(argv[i], "-i") == 0) && has_arg) {
+            opts.report_interval = std::strtod(argv[++i], nullptr);
+        } else if((std::strcmp(argv[i], "-s") == 0) && has_arg) {
+            opts.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if((std::strcmp(argv[i], "-h") == 0) || (std::strcmp(argv[i], "--help") == 0)) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if((opts.devices == 0) || (opts.rate == 0) || !(opts.duration > 0.0) || !(opts.report_interval > 0.0)) {
+        std::fprintf(stderr, "Invalid arguments.\n");
+        return 1;
+    }
+
+    stratcom_set_allocator(counting_alloc, counting_free, nullptr);
+    if(stratcom_init() != STRATCOM_RET_SUCCESS) {
+        std::fprintf(stderr, "Unable to initialize libstratcom.\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<device_context>> devices;
+    for(unsigned i = 0; i < opts.devices; ++i) {
+        stratcom_device* dev = stratcom_open_simulated_device();
+        if(!dev) {
+            std::fprintf(stderr, "Unable to open simulated device.\n");
+            return 1;
+        }
+        devices.emplace_back(new device_context(dev, i));
+    }
+    std::int64_t const live_bytes_start = g_live_bytes.load();
+    long long const rss_start = get_rss_bytes();
+
+    std::vector<std::thread> threads;
+    for(auto& d : devices) {
+        threads.emplace_back(reader_thread, std::ref(*d));
+        threads.emplace_back(producer_thread, std::ref(*d), std::cref(opts));
+    }
+    led_context leds;
+    if(opts.led_rate > 0) {
+        threads.emplace_back(led_thread, std::cref(devices), std::ref(leds), std::cref(opts));
+    }
+
+    latency_histogram total_latency;
+    latency_histogram total_led_latency;
+    totals last_totals = get_totals(devices, leds);
+    auto const start = std::chrono::steady_clock::now();
+    auto last = start;
+    auto const end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(opts.duration));
+    auto const interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(opts.report_interval));
+    while(last < end) {
+        std::this_thread::sleep_until(std::min(last + interval, end));
+        auto const now = std::chrono::steady_clock::now();
+        double const elapsed = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        latency_histogram latency;
+        for(auto& d : devices) { d->latency.collect(latency); }
+        latency_histogram led_latency;
+        leds.latency.collect(led_latency);
+        total_latency.merge(latency);
+        total_led_latency.merge(led_latency);
+        totals const t = get_totals(devices, leds);
+        totals delta;
+        delta.reports_pushed = t.reports_pushed - last_totals.reports_pushed;
+        delta.reports_rejected = t.reports_rejected - last_totals.reports_rejected;
+        delta.reports_read = t.reports_read - last_totals.reports_read;
+        delta.events_read = t.events_read - last_totals.events_read;
+        delta.read_errors = t.read_errors - last_totals.read_errors;
+        delta.led_commits = t.led_commits - last_totals.led_commits;
+        delta.led_errors = t.led_errors - last_totals.led_errors;
+        last_totals = t;
+
+        std::printf("{\"type\":\"interval\",\"time_s\":%.3f,\"interval_s\":%.3f,",
+                    std::chrono::duration<double>(now - start).count(), elapsed);
+        print_counters(delta);
+        std::printf(",\"reports_per_s\":%.1f,\"events_per_s\":%.1f,",
+                    delta.reports_read / elapsed, delta.events_read / elapsed);
+        print_latency("latency_us", latency);
+        std::printf(",");
+        print_latency("led_latency_us", led_latency);
+        std::printf(",");
+        print_memory();
+        std::printf("}\n");
+        std::fflush(stdout);
+    }
+
+    g_quit.store(true);
+    for(auto& t : threads) { t.join(); }
+
+    double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for(auto& d : devices) { d->latency.collect(total_latency); }
+    leds.latency.collect(total_led_latency);
+    totals const t = get_totals(devices, leds);
+    stratcom_read_statistics gaps;
+    std::memset(&gaps, 0, sizeof(gaps));
+    for(auto const& d : devices) {
+        stratcom_read_statistics stats;
+        stratcom_get_read_statistics(d->device, &stats);
+        gaps.gaps_detected += stats.gaps_detected;
+        gaps.gaps_suspected += stats.gaps_suspected;
+    }
+    std::int64_t const live_bytes_end = g_live_bytes.load();
+    long long const rss_end = get_rss_bytes();
+
+    std::printf("{\"type\":\"summary\",\"devices\":%u,\"rate\":%u,\"pattern\":\"%s\",\"led_rate\":%u,"
+                "\"duration_s\":%.3f,",
+                opts.devices, opts.rate, PATTERN_NAMES[opts.pattern], opts.led_rate, elapsed);
+    print_counters(t);
+    std::printf(",\"gaps_detected\":%" PRIu64 ",\"gaps_suspected\":%" PRIu64
+                ",\"reports_per_s\":%.1f,\"events_per_s\":%.1f,",
+                gaps.gaps_detected, gaps.gaps_suspected, t.reports_read / elapsed, t.events_read / elapsed);
+    print_latency("latency_us", total_latency);
+    std::printf(",");
+    print_latency("led_latency_us", total_led_latency);
+    std::printf(",\"live_bytes_start\":%" PRId64 ",\"live_bytes_end\":%" PRId64 ",\"live_bytes_growth\":%" PRId64
+                ",\"rss_bytes_start\":%lld,\"rss_bytes_end\":%lld}\n",
+                live_bytes_start, live_bytes_end, live_bytes_end - live_bytes_start, rss_start, rss_end);
+
+    for(auto& d : devices) { stratcom_close_device(d->device); }
+    stratcom_shutdown();
+    return (t.read_errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,622 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/** @file
+ * stratcomd - Serves Strategic Commander input to local clients over a Unix domain socket.
+ *
+ * The daemon owns all devices given on the command line (or the first device found if none is given).
+ * Each device is read by a dedicated reader thread, which encodes input events into protocol records.
+ * All client connections are served from a single poll() loop on the main thread.
+ * See stratcomd_protocol.h for a description of the wire protocol.
+ */
+#include <stratcom.h>
+
+#include "stratcomd_protocol.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    /** Maximum number of bytes buffered per client before records are dropped. */
+    std::size_t const CLIENT_BUFFER_CAPACITY = 4096 * sizeof(stratcomd_record);
+    /** A client that overflowed receives a new snapshot once its buffer drains below this mark. */
+    std::size_t const CLIENT_BUFFER_LOW_WATERMARK = CLIENT_BUFFER_CAPACITY / 4;
+    /** Timeout for device reads. Determines how quickly reader threads notice shutdown. */
+    int const READER_TIMEOUT_MILLISECONDS = 100;
+    /** Default permissions of the socket. Any user that can connect may change the LEDs. */
+    mode_t const DEFAULT_SOCKET_MODE = 0600;
+
+    int g_wakeup_pipe[2] = { -1, -1 };
+    volatile sig_atomic_t g_quit = 0;
+
+    /** Wake up the main loop from a reader thread or a signal handler.
+     */
+    void wakeup_main_loop()
+    {
+        char const c = 0;
+        ssize_t const res = write(g_wakeup_pipe[1], &c, 1);
+        (void)res;
+    }
+
+    void on_quit_signal(int)
+    {
+        g_quit = 1;
+        wakeup_main_loop();
+    }
+
+    stratcomd_record make_record(stratcomd_record_type type, std::uint8_t device, std::uint16_t control,
+                                 std::int16_t value)
+    {
+        stratcomd_record ret;
+        ret.type = static_cast<std::uint8_t>(type);
+        ret.device = device;
+        ret.control = control;
+        ret.value = value;
+        ret.reserved = 0;
+        return ret;
+    }
+
+    /** A device owned by the daemon.
+     * The input side of the device is exclusively accessed by the reader thread.
+     * The LED side of the device is exclusively accessed by the main thread.
+     */
+    struct device_entry {
+        stratcom_device* device;
+        std::uint8_t index;
+        std::thread reader;
+
+        std::mutex mutex;                               ///< protects pending_records, state and lost.
+        std::vector<stratcomd_record> pending_records;  ///< records produced by the reader thread.
+        stratcom_input_state state;                     ///< input state after the last pending record.
+        bool lost;                                      ///< true if the device was disconnected.
+
+        stratcom_input_state published_state;           ///< main thread copy of state.
+        bool published_lost;                            ///< main thread copy of lost.
+        bool led_dirty;                                 ///< main thread has unflushed LED changes.
+        bool blink_dirty;                               ///< main thread has an unsent blink interval.
+        std::uint8_t blink_on_time;
+        std::uint8_t blink_off_time;
+
+        device_entry(stratcom_device* dev, std::uint8_t idx)
+            :device(dev), index(idx), lost(false), published_lost(false), led_dirty(false), blink_dirty(false),
+             blink_on_time(0), blink_off_time(0)
+        {
+            std::memset(&state, 0, sizeof(state));
+            std::memset(&published_state, 0, sizeof(published_state));
+        }
+    };
+
+    void encode_events(stratcom_input_event const* events, std::uint8_t device,
+                       std::vector<stratcomd_record>& out_records)
+    {
+        for(auto it = events; it != nullptr; it = it->next) {
+            switch(it->type) {
+            case STRATCOM_INPUT_EVENT_BUTTON:
+                out_records.push_back(make_record(STRATCOMD_RECORD_BUTTON, device,
+                                                  static_cast<std::uint16_t>(it->desc.button.button),
+                                                  static_cast<std::int16_t>(it->desc.button.status)));
+                break;
+            case STRATCOM_INPUT_EVENT_AXIS:
+                out_records.push_back(make_record(STRATCOMD_RECORD_AXIS, device,
+                                                  static_cast<std::uint16_t>(it->desc.axis.axis),
+                                                  it->desc.axis.status));
+                break;
+            case STRATCOM_INPUT_EVENT_SLIDER:
+                out_records.push_back(make_record(STRATCOMD_RECORD_SLIDER, device, 0,
+                                                  static_cast<std::int16_t>(it->desc.slider.status)));
+                break;
+            }
+        }
+    }
+
+    void encode_snapshot(stratcom_input_state const& state, std::uint8_t device,
+                         std::vector<stratcomd_record>& out_records)
+    {
+        out_records.push_back(make_record(STRATCOMD_RECORD_BUTTONS, device, state.buttons, 0));
+        out_records.push_back(make_record(STRATCOMD_RECORD_AXIS, device, STRATCOM_AXIS_X, state.axisX));
+        out_records.push_back(make_record(STRATCOMD_RECORD_AXIS, device, STRATCOM_AXIS_Y, state.axisY));
+        out_records.push_back(make_record(STRATCOMD_RECORD_AXIS, device, STRATCOM_AXIS_Z, state.axisZ));
+        out_records.push_back(make_record(STRATCOMD_RECORD_SLIDER, device, 0,
+                                          static_cast<std::int16_t>(state.slider)));
+    }
+
+    void device_reader(device_entry& entry, std::atomic<bool> const& running)
+    {
+        stratcom_input_state old_state = stratcom_get_input_state(entry.device);
+        std::vector<stratcomd_record> records;
+        while(running) {
+            stratcom_return const res = stratcom_read_input_with_timeout(entry.device, READER_TIMEOUT_MILLISECONDS);
+            if(res == STRATCOM_RET_NO_DATA) {
+                continue;
+            } else if(res == STRATCOM_RET_ERROR) {
+                std::lock_guard<std::mutex> lk(entry.mutex);
+                entry.lost = true;
+                entry.pending_records.push_back(make_record(STRATCOMD_RECORD_DEVICE_LOST, entry.index, 0, 0));
+                wakeup_main_loop();
+                return;
+            }
+            stratcom_input_state new_state = stratcom_get_input_state(entry.device);
+            stratcom_input_event* events = stratcom_create_input_events_from_states(&old_state, &new_state);
+            records.clear();
+            encode_events(events, entry.index, records);
+            stratcom_free_input_events(events);
+            old_state = new_state;
+            if(!records.empty()) {
+                std::lock_guard<std::mutex> lk(entry.mutex);
+                bool const needs_wakeup = entry.pending_records.empty();
+                entry.pending_records.insert(entry.pending_records.end(), records.begin(), records.end());
+                entry.state = new_state;
+                if(needs_wakeup) { wakeup_main_loop(); }
+            }
+        }
+    }
+
+    /** A connected client.
+     */
+    struct client_entry {
+        int fd;
+        std::vector<char> out_buffer;                   ///< bytes not yet written to the socket.
+        std::size_t out_offset;                         ///< first unwritten byte in out_buffer.
+        unsigned char in_buffer[sizeof(stratcomd_record)];
+        std::size_t in_size;                            ///< number of bytes of a partial record in in_buffer.
+        bool overflowed;                                ///< true if records were dropped for this client.
+        bool closed;
+
+        explicit client_entry(int client_fd)
+            :fd(client_fd), out_offset(0), in_size(0), overflowed(false), closed(false)
+        {}
+
+        std::size_t pending_bytes() const
+        {
+            return out_buffer.size() - out_offset;
+        }
+    };
+
+    class daemon_server {
+    private:
+        int m_listen_fd;
+        std::vector<std::unique_ptr<device_entry>> m_devices;
+        std::vector<std::unique_ptr<client_entry>> m_clients;
+        std::vector<stratcomd_record> m_batch;
+        std::vector<struct pollfd> m_pollfds;
+    public:
+        daemon_server(int listen_fd, std::vector<std::unique_ptr<device_entry>>& devices)
+            :m_listen_fd(listen_fd), m_devices(std::move(devices))
+        {
+        }
+
+        ~daemon_server()
+        {
+            for(auto& c : m_clients) { close(c->fd); }
+        }
+
+        void run()
+        {
+            while(!g_quit) {
+                m_pollfds.clear();
+                struct pollfd pfd;
+                pfd.fd = m_listen_fd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                m_pollfds.push_back(pfd);
+                pfd.fd = g_wakeup_pipe[0];
+                m_pollfds.push_back(pfd);
+                for(auto const& c : m_clients) {
+                    pfd.fd = c->fd;
+                    pfd.events = POLLIN | ((c->pending_bytes() > 0) ? POLLOUT : 0);
+                    m_pollfds.push_back(pfd);
+                }
+
+                if(poll(m_pollfds.data(), m_pollfds.size(), -1) < 0) {
+                    if(errno == EINTR) { continue; }
+                    std::perror("poll");
+                    return;
+                }
+
+                if(m_pollfds[1].revents & POLLIN) {
+                    drain_wakeup_pipe();
+                    collect_device_records();
+                }
+                for(std::size_t i = 0; i < m_clients.size(); ++i) {
+                    auto const revents = m_pollfds[i + 2].revents;
+                    if(revents & (POLLIN | POLLHUP | POLLERR)) {
+                        read_from_client(*m_clients[i]);
+                    }
+                }
+                if(m_pollfds[0].revents & POLLIN) {
+                    accept_clients();
+                }
+                flush_led_changes();
+                for(auto& c : m_clients) {
+                    if(!c->closed) { write_to_client(*c); }
+                }
+                remove_closed_clients();
+            }
+        }
+
+    private:
+        void drain_wakeup_pipe()
+        {
+            char buffer[64];
+            while(read(g_wakeup_pipe[0], buffer, sizeof(buffer)) > 0) {}
+        }
+
+        /** Gather the records of all devices into a single batch and append it to every client.
+         */
+        void collect_device_records()
+        {
+            m_batch.clear();
+            for(auto& d : m_devices) {
+                std::lock_guard<std::mutex> lk(d->mutex);
+                m_batch.insert(m_batch.end(), d->pending_records.begin(), d->pending_records.end());
+                d->pending_records.clear();
+                d->published_state = d->state;
+                d->published_lost = d->lost;
+            }
+            if(m_batch.empty()) { return; }
+            std::size_t const batch_size = m_batch.size() * sizeof(stratcomd_record);
+            for(auto& c : m_clients) {
+                if(c->overflowed) { continue; }
+                if(c->pending_bytes() + batch_size > CLIENT_BUFFER_CAPACITY) {
+                    c->overflowed = true;
+                    continue;
+                }
+                append_records(*c, m_batch);
+            }
+        }
+
+        void append_records(client_entry& client, std::vector<stratcomd_record> const& records)
+        {
+            if(client.out_offset > 0 && client.out_offset >= client.out_buffer.size() / 2) {
+                client.out_buffer.erase(client.out_buffer.begin(), client.out_buffer.begin() + client.out_offset);
+                client.out_offset = 0;
+            }
+            char const* first = reinterpret_cast<char const*>(records.data());
+            client.out_buffer.insert(client.out_buffer.end(), first, first + records.size() * sizeof(stratcomd_record));
+        }
+
+        void append_snapshots(client_entry& client)
+        {
+            std::vector<stratcomd_record> records;
+            for(auto const& d : m_devices) {
+                if(d->published_lost) {
+                    records.push_back(make_record(STRATCOMD_RECORD_DEVICE_LOST, d->index, 0, 0));
+                } else {
+                    encode_snapshot(d->published_state, d->index, records);
+                }
+            }
+            append_records(client, records);
+        }
+
+        void accept_clients()
+        {
+            for(;;) {
+                int const fd = accept(m_listen_fd, nullptr, nullptr);
+                if(fd < 0) { return; }
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                std::unique_ptr<client_entry> client(new client_entry(fd));
+                std::vector<stratcomd_record> hello(1, make_record(STRATCOMD_RECORD_HELLO, 0,
+                                                                   STRATCOMD_PROTOCOL_VERSION,
+                                                                   static_cast<std::int16_t>(m_devices.size())));
+                append_records(*client, hello);
+                append_snapshots(*client);
+                m_clients.push_back(std::move(client));
+            }
+        }
+
+        void read_from_client(client_entry& client)
+        {
+            unsigned char buffer[64 * sizeof(stratcomd_record)];
+            for(;;) {
+                ssize_t const res = read(client.fd, buffer, sizeof(buffer));
+                if(res == 0 || (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    client.closed = true;
+                    return;
+                } else if(res < 0) {
+                    return;
+                }
+                for(ssize_t i = 0; i < res; ++i) {
+                    client.in_buffer[client.in_size++] = buffer[i];
+                    if(client.in_size == sizeof(stratcomd_record)) {
+                        stratcomd_record record;
+                        std::memcpy(&record, client.in_buffer, sizeof(record));
+                        handle_command(record);
+                        client.in_size = 0;
+                    }
+                }
+            }
+        }
+
+        void handle_command(stratcomd_record const& record)
+        {
+            if(record.device >= m_devices.size()) { return; }
+            device_entry& d = *m_devices[record.device];
+            switch(record.type) {
+            case STRATCOMD_RECORD_SET_LED:
+                if((record.value == STRATCOM_LED_ON) || (record.value == STRATCOM_LED_OFF) ||
+                   (record.value == STRATCOM_LED_BLINK))
+                {
+                    auto const led = static_cast<stratcom_button_led>(record.control & STRATCOM_LEDBUTTON_ALL);
+                    stratcom_set_button_led_state_without_flushing(d.device, led,
+                                                                   static_cast<stratcom_led_state>(record.value));
+                    d.led_dirty = true;
+                }
+                break;
+            case STRATCOMD_RECORD_SET_BLINK_INTERVAL:
+                d.blink_on_time = static_cast<std::uint8_t>(record.control & 0xff);
+                d.blink_off_time = static_cast<std::uint8_t>((record.control >> 8) & 0xff);
+                d.blink_dirty = true;
+                break;
+            default: break;
+            }
+        }
+
+        /** Send all LED changes received during this loop iteration with one feature report per device.
+         */
+        void flush_led_changes()
+        {
+            for(auto& d : m_devices) {
+                if(d->published_lost) { continue; }
+                if(d->blink_dirty) {
+                    stratcom_set_led_blink_interval(d->device, d->blink_on_time, d->blink_off_time);
+                    d->blink_dirty = false;
+                }
+                if(d->led_dirty) {
+                    stratcom_flush_button_led_state(d->device);
+                    d->led_dirty = false;
+                }
+            }
+        }
+
+        void write_to_client(client_entry& client)
+        {
+            while(client.pending_bytes() > 0) {
+                ssize_t const res = write(client.fd, client.out_buffer.data() + client.out_offset,
+                                          client.pending_bytes());
+                if(res < 0) {
+                    if(errno == EINTR) { continue; }
+                    if(errno != EAGAIN && errno != EWOULDBLOCK) { client.closed = true; }
+                    break;
+                }
+                client.out_offset += static_cast<std::size_t>(res);
+            }
+            if(client.pending_bytes() == 0) {
+                client.out_buffer.clear();
+                client.out_offset = 0;
+            }
+            if(client.overflowed && (client.pending_bytes() < CLIENT_BUFFER_LOW_WATERMARK)) {
+                std::vector<stratcomd_record> overflow(1, make_record(STRATCOMD_RECORD_OVERFLOW, 0, 0, 0));
+                append_records(client, overflow);
+                append_snapshots(client);
+                client.overflowed = false;
+            }
+        }
+
+        void remove_closed_clients()
+        {
+            for(auto it = m_clients.begin(); it != m_clients.end(); ) {
+                if((*it)->closed) {
+                    close((*it)->fd);
+                    it = m_clients.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    };
+
+    /** The socket path used if none is given on the command line.
+     */
+    std::string default_socket_path()
+    {
+        char const* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+        if(runtime_dir && (runtime_dir[0] != '\0')) {
+            return std::string(runtime_dir) + "/" + STRATCOMD_SOCKET_NAME;
+        }
+        return STRATCOMD_DEFAULT_SOCKET_PATH;
+    }
+
+    /** Remove a socket left behind by a daemon that is no longer running.
+     * @return false if the path is in use by a running daemon or is not a socket.
+     */
+    bool remove_stale_socket(struct sockaddr_un const& addr)
+    {
+        struct stat st;
+        if(lstat(addr.sun_path, &st) != 0) {
+            return true;
+        }
+        if(!S_ISSOCK(st.st_mode)) {
+            std::fprintf(stderr, "%s exists and is not a socket.\n", addr.sun_path);
+            return false;
+        }
+        int const probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(probe < 0) {
+            std::perror("socket");
+            return false;
+        }
+        bool const in_use = (connect(probe, reinterpret_cast<struct sockaddr const*>(&addr), sizeof(addr)) == 0);
+        close(probe);
+        if(in_use) {
+            std::fprintf(stderr, "Another stratcomd is already serving on %s.\n", addr.sun_path);
+            return false;
+        }
+        unlink(addr.sun_path);
+        return true;
+    }
+
+    int open_listen_socket(char const* path, mode_t mode)
+    {
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(std::strlen(path) >= sizeof(addr.sun_path)) {
+            std::fprintf(stderr, "Socket path too long: %s\n", path);
+            return -1;
+        }
+        std::strcpy(addr.sun_path, path);
+
+        if(!remove_stale_socket(addr)) {
+            return -1;
+        }
+        int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) {
+            std::perror("socket");
+            return -1;
+        }
+        // create the socket without any permissions for others, so that it is never more accessible than asked
+        mode_t const old_umask = umask(0177);
+        int const bind_res = bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        umask(old_umask);
+        if((bind_res != 0) || (chmod(path, mode) != 0) || (listen(fd, 64) != 0)) {
+            std::perror("bind");
+            if(bind_res == 0) { unlink(path); }
+            close(fd);
+            return -1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return fd;
+    }
+
+    void print_usage(char const* program_name)
+    {
+        std::printf("Usage: %s [-s <socket_path>] [-m <socket_mode>] [<device_path> ...]\n", program_name);
+        std::printf("Serves Strategic Commander input over a Unix domain socket (default: %s).\n",
+                    default_socket_path().c_str());
+        std::printf("The socket is created with the given octal mode (default: %03o). Every user that may\n"
+                    "connect to the socket may also change the LEDs.\n", static_cast<unsigned>(DEFAULT_SOCKET_MODE));
+        std::printf("If no device path is given, the first Strategic Commander found is used.\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string const default_path = default_socket_path();
+    char const* socket_path = default_path.c_str();
+    mode_t socket_mode = DEFAULT_SOCKET_MODE;
+    std::vector<char const*> device_paths;
+    for(int i = 1; i < argc; ++i) {
+        if((std::strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+            socket_path = argv[++i];
+        } else if((std::strcmp(argv[i], "-m") == 0) && (i + 1 < argc)) {
+            char* end;
+            unsigned long const mode = std::strtoul(argv[++i], &end, 8);
+            if((*end != '\0') || (mode > 0777)) {
+                std::fprintf(stderr, "Invalid socket mode: %s\n", argv[i]);
+                return 1;
+            }
+            socket_mode = static_cast<mode_t>(mode);
+        } else if((std::strcmp(argv[i], "-h") == 0) || (std::strcmp(argv[i], "--help") == 0)) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            device_paths.push_back(argv[i]);
+        }
+    }
+    if(device_paths.size() > 255) {
+        std::fprintf(stderr, "Too many devices.\n");
+        return 1;
+    }
+
+    if(stratcom_init() != STRATCOM_RET_SUCCESS) {
+        std::fprintf(stderr, "Unable to initialize libstratcom.\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<device_entry>> devices;
+    if(device_paths.empty()) {
+        stratcom_device* dev = stratcom_open_device();
+        if(dev) { devices.emplace_back(new device_entry(dev, 0)); }
+    } else {
+        for(auto path : device_paths) {
+            stratcom_device* dev = stratcom_open_device_on_path(path);
+            if(!dev) {
+                std::fprintf(stderr, "Unable to open device %s.\n", path);
+                continue;
+            }
+            devices.emplace_back(new device_entry(dev, static_cast<std::uint8_t>(devices.size())));
+        }
+    }
+    if(devices.empty()) {
+        std::fprintf(stderr, "Strategic Commander was not found.\n");
+        stratcom_shutdown();
+        return 1;
+    }
+
+    if(pipe(g_wakeup_pipe) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+    fcntl(g_wakeup_pipe[0], F_SETFL, fcntl(g_wakeup_pipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(g_wakeup_pipe[1], F_SETFL, fcntl(g_wakeup_pipe[1], F_GETFL) | O_NONBLOCK);
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_quit_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    int const listen_fd = open_listen_socket(socket_path, socket_mode);
+    if(listen_fd < 0) {
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+    std::vector<device_entry*> device_list;
+    for(auto& d : devices) {
+        device_entry& entry = *d;
+        entry.reader = std::thread([&entry, &running]() { device_reader(entry, running); });
+        device_list.push_back(&entry);
+    }
+
+    {
+        daemon_server server(listen_fd, devices);
+        server.run();
+
+        running = false;
+        for(auto d : device_list) {
+            d->reader.join();
+            stratcom_close_device(d->device);
+        }
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    stratcom_shutdown();
+    return 0;
+}
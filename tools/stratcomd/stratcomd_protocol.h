@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Copyright (c) 2010-2014 Andreas Weis <der_ghulbus@ghulbus-inc.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *****************************************************************************/
+
+/** @file
+ * Wire protocol of the stratcomd daemon.
+ * Clients connect to the daemon through a local Unix domain stream socket.
+ * All communication happens in fixed-size 8 byte records, encoded in host byte order.
+ *
+ * Upon connecting, a client receives a single STRATCOMD_RECORD_HELLO record, followed by a
+ * state snapshot for each device. After that, the daemon streams input events as they arrive.
+ *
+ * A state snapshot consists of one STRATCOMD_RECORD_BUTTONS record, three STRATCOMD_RECORD_AXIS
+ * records (X, Y, Z) and one STRATCOMD_RECORD_SLIDER record.
+ *
+ * If a client does not consume records fast enough, the daemon drops records for that client.
+ * Once the client has caught up, it receives a STRATCOMD_RECORD_OVERFLOW record, followed by a
+ * fresh state snapshot for each device.
+ *
+ * Clients may send STRATCOMD_RECORD_SET_LED and STRATCOMD_RECORD_SET_BLINK_INTERVAL records
+ * to the daemon. LED changes from all clients are merged and flushed to the device with a
+ * single feature report.
+ */
+#ifndef LIBSTRATCOM_INCLUDE_GUARD_STRATCOMD_PROTOCOL_H_
+#define LIBSTRATCOM_INCLUDE_GUARD_STRATCOMD_PROTOCOL_H_
+
+#include <stdint.h>
+
+/** Protocol version reported in the STRATCOMD_RECORD_HELLO record. */
+#define STRATCOMD_PROTOCOL_VERSION 1
+
+/** File name of the daemon socket.
+ * By default, the socket is created in the directory named by the XDG_RUNTIME_DIR environment variable,
+ * which is private to the user. If that variable is not set, STRATCOMD_DEFAULT_SOCKET_PATH is used.
+ * Clients should look for the socket in the same places.
+ */
+#define STRATCOMD_SOCKET_NAME "stratcomd.sock"
+
+/** Path of the daemon socket if XDG_RUNTIME_DIR is not set. */
+#define STRATCOMD_DEFAULT_SOCKET_PATH "/tmp/" STRATCOMD_SOCKET_NAME
+
+/** Record types.
+ */
+typedef enum stratcomd_record_type_ {
+    /* daemon -> client */
+    STRATCOMD_RECORD_HELLO   = 0x01,            /**< control: protocol version; value: number of devices. */
+    STRATCOMD_RECORD_BUTTONS = 0x02,            /**< control: complete stratcom_button_word of the device. */
+    STRATCOMD_RECORD_BUTTON  = 0x03,            /**< control: stratcom_button; value: 1 if pressed, 0 if released. */
+    STRATCOMD_RECORD_AXIS    = 0x04,            /**< control: stratcom_axis; value: new axis position. */
+    STRATCOMD_RECORD_SLIDER  = 0x05,            /**< value: new stratcom_slider_state. */
+    STRATCOMD_RECORD_OVERFLOW = 0x06,           /**< Records were dropped. A state snapshot follows. */
+    STRATCOMD_RECORD_DEVICE_LOST = 0x07,        /**< The device was disconnected. */
+    /* client -> daemon */
+    STRATCOMD_RECORD_SET_LED = 0x10,            /**< control: stratcom_button_led mask; value: stratcom_led_state. */
+    STRATCOMD_RECORD_SET_BLINK_INTERVAL = 0x11  /**< control: on time (low byte) and off time (high byte). */
+} stratcomd_record_type;
+
+/** A single protocol record.
+ */
+typedef struct stratcomd_record_ {
+    uint8_t  type;                              /**< One of stratcomd_record_type. */
+    uint8_t  device;                            /**< Index of the device this record refers to. */
+    uint16_t control;                           /**< Control identifier. Meaning depends on type. */
+    int16_t  value;                             /**< Control value. Meaning depends on type. */
+    uint16_t reserved;                          /**< Unused. Always 0. */
+} stratcomd_record;
+
+#endif